@@ -2,7 +2,11 @@
 
 #include <cassert>
 #include <cstdint>
-#include <GL/glew.h>
+#include "gl_dispatch.h"
+
+#include "init.h"
+#include "instrumentation.h"
+#include "state_cache.h"
 
 
 namespace ogu {
@@ -12,11 +16,16 @@ private:
 
     GLuint _handle;
     size_t _size;
+    uint64_t _serial;
 
 public:
 
     explicit buffer(size_t size);
 
+    // Immutable storage through glBufferStorage, storageFlags are passed straight through
+    // (e.g. GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)
+    buffer(size_t size, GLbitfield storageFlags, const void* pData = nullptr);
+
     buffer(buffer&& b);
 
     ~buffer();
@@ -27,13 +36,25 @@ public:
 
     inline const GLuint& handle() const;
 
+    // Unique to this buffer for the life of the process, unlike GL names which are reused after a
+    // buffer is deleted. For caches that remember which buffer they last saw.
+    inline uint64_t serial() const;
+
     template<typename Fn>
     inline void write(intptr_t offset, size_t size, const Fn& fn) const;
 
+    // Long-lived mappings (e.g. persistent ones), for one-off writes prefer write()
+    void* map(intptr_t offset, size_t size, GLbitfield accessFlags) const;
+
+    // For mappings made with GL_MAP_FLUSH_EXPLICIT_BIT, offset is relative to the start of the mapping
+    void flushMappedRange(intptr_t offset, size_t size) const;
+
+    void unmap() const;
+
 };
 
 void buffer::bind(GLenum target) const {
-    glBindBuffer(target, _handle);
+    state_cache::current().bindBuffer(target, _handle);
 }
 
 size_t buffer::size() const {
@@ -44,23 +65,49 @@ const GLuint& buffer::handle() const {
     return _handle;
 }
 
+uint64_t buffer::serial() const {
+    return _serial;
+}
+
+// Non-owning view of a sub-range of a buffer, e.g. an allocation from a buffer_arena
+struct buffer_range {
+    const buffer* buf;
+    intptr_t offset;
+    size_t size;
+
+    template<typename Fn>
+    inline void write(const Fn& fn) const {
+        buf->write(offset, size, fn);
+    }
+};
+
 template<typename Fn>
 void buffer::write(intptr_t offset, size_t size, const Fn& fn) const {
     size = (size == 0) ? _size : size;
+    OGU_COUNT_CALL(UPLOAD);
+    OGU_COUNT_UPLOAD(size);
     void* pBufferData;
-    bind(GL_COPY_WRITE_BUFFER); // using GL_COPY_WRITE_BUFFER because why not
     GLbitfield flags = GL_MAP_WRITE_BIT;
     if (offset == 0 && size == _size) {
         flags |= GL_MAP_INVALIDATE_BUFFER_BIT;
     } else {
         flags |= GL_MAP_INVALIDATE_RANGE_BIT;
     }
+    if (getFeatures().directStateAccess) {
+        pBufferData = glMapNamedBufferRange(_handle, offset, size, flags);
+        assert(pBufferData);
+        fn(pBufferData);
+        glUnmapNamedBuffer(_handle);
+        return;
+    }
+    bind(GL_COPY_WRITE_BUFFER); // using GL_COPY_WRITE_BUFFER because why not
     pBufferData = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, flags);
     assert(pBufferData);
     fn(pBufferData);
-    bind(GL_COPY_WRITE_BUFFER); // rebind the buffer in case the user did some shenanigans
+    // fn may have bound another buffer through ogu, the cache then issues this bind. Raw glBindBuffer
+    // calls bypass the cache, so fn must call state_cache::invalidate() after making any.
+    bind(GL_COPY_WRITE_BUFFER);
     glUnmapBuffer(GL_COPY_WRITE_BUFFER);
-    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 }
 
 }  // namespace ogu
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "buffer.h"
+
+
+namespace ogu {
+
+// Sub-allocates aligned ranges out of a few large buffers ("pages") instead of creating a
+// buffer object per mesh. Each page keeps a free list that is coalesced on free.
+class buffer_arena {
+private:
+
+    struct page {
+        buffer buf;
+
+        // free blocks, keyed by offset and by size (for best-fit search)
+        std::map<size_t, size_t> freeByOffset;
+        std::multimap<size_t, size_t> freeBySize;
+
+        explicit page(size_t size);
+
+        void insertFree(size_t offset, size_t size);
+        void eraseFree(std::map<size_t, size_t>::iterator it);
+
+        bool tryAllocate(size_t size, size_t alignment, size_t& offsetOut);
+    };
+
+    std::vector<std::unique_ptr<page>> _pages;
+
+    size_t _pageSize;
+    size_t _maxPages;
+
+    size_t _used = 0;
+    size_t _peakUsed = 0;
+    size_t _allocationCount = 0;
+
+    page& findPage(const buffer* buf);
+
+public:
+
+    struct stats {
+        size_t pageCount;
+        size_t capacity;
+        size_t used;
+        size_t peakUsed;
+        size_t allocationCount;
+        size_t freeBlockCount;
+        size_t largestFreeBlock;
+
+        // 0 when all free space is one contiguous block, approaching 1 as it gets split up
+        inline float fragmentation() const {
+            size_t free = capacity - used;
+            return free == 0 ? 0.0f : 1.0f - (float) largestFreeBlock / (float) free;
+        }
+    };
+
+    // @param maxPages 0 for no limit
+    explicit buffer_arena(size_t pageSize, size_t maxPages = 0);
+
+    buffer_arena(const buffer_arena&) = delete;
+
+    buffer_arena& operator=(const buffer_arena&) = delete;
+
+    // Alignment does not need to be a power of two, so a vertex stride can be used directly,
+    // making offset / stride usable as a base vertex.
+    // Throws std::length_error if size is larger than a page or the page limit is reached.
+    buffer_range allocate(size_t size, size_t alignment = 1);
+
+    void free(const buffer_range& range);
+
+    stats getStats() const;
+
+    inline size_t pageSize() const {
+        return _pageSize;
+    }
+
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, for ranges that will be bound with bindUniformBuffer
+    static size_t uniformBufferAlignment();
+
+};
+
+}  // namespace ogu
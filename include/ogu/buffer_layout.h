@@ -0,0 +1,333 @@
+#pragma once
+
+#include "gl_dispatch.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "program_reflection.h"
+
+
+namespace ogu {
+
+// Compile-time std140 / std430 layouts for uniform and shader storage buffers.
+//
+// C++ types map to GLSL types the same way as for uniforms: float / int32_t / uint32_t are scalars,
+// std::array<scalar, 2-4> are vectors, std::array<std::array<float, R>, C> are column-major
+// matrices and C arrays are arrays. Structs are described by specializing glsl_struct_of:
+//
+//     struct Light { std::array<float, 3> position; float radius; std::array<float, 4> color[2]; };
+//     template<> struct ogu::glsl_struct_of<Light> {
+//         using type = ogu::glsl_struct<&Light::position, &Light::radius, &Light::color>;
+//     };
+//
+// then buffer_layout<Light, layout_rule::STD140> has the offsets, size and array stride, and writes
+// Light values straight into mapped buffer memory.
+
+enum class layout_rule {
+    STD140,
+    STD430
+};
+
+template<auto... Members>
+struct glsl_struct { };
+
+template<typename T>
+struct glsl_struct_of;
+
+template<typename T, layout_rule R, typename Enable = void>
+struct layout_of;
+
+namespace detail {
+
+constexpr size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Arrays (and matrix columns) in std140 round the element alignment up to a vec4
+constexpr size_t arrayAlignment(layout_rule rule, size_t elementAlignment) {
+    return rule == layout_rule::STD140 ? alignUp(elementAlignment, 16) : elementAlignment;
+}
+
+template<typename T>
+struct is_glsl_scalar : std::integral_constant<bool,
+    std::is_same<T, float>::value || std::is_same<T, int32_t>::value || std::is_same<T, uint32_t>::value> { };
+
+template<typename T>
+struct scalar_gl_type;
+
+template<> struct scalar_gl_type<float> { static constexpr GLenum vec[5] = { 0, GL_FLOAT, GL_FLOAT_VEC2, GL_FLOAT_VEC3, GL_FLOAT_VEC4 }; };
+template<> struct scalar_gl_type<int32_t> { static constexpr GLenum vec[5] = { 0, GL_INT, GL_INT_VEC2, GL_INT_VEC3, GL_INT_VEC4 }; };
+template<> struct scalar_gl_type<uint32_t> { static constexpr GLenum vec[5] = { 0, GL_UNSIGNED_INT, GL_UNSIGNED_INT_VEC2, GL_UNSIGNED_INT_VEC3, GL_UNSIGNED_INT_VEC4 }; };
+
+// indexed [columns][rows]
+constexpr GLenum matrixGlTypes[5][5] = {
+    { 0, 0, 0, 0, 0 },
+    { 0, 0, 0, 0, 0 },
+    { 0, 0, GL_FLOAT_MAT2, GL_FLOAT_MAT2x3, GL_FLOAT_MAT2x4 },
+    { 0, 0, GL_FLOAT_MAT3x2, GL_FLOAT_MAT3, GL_FLOAT_MAT3x4 },
+    { 0, 0, GL_FLOAT_MAT4x2, GL_FLOAT_MAT4x3, GL_FLOAT_MAT4 },
+};
+
+template<typename M>
+struct member_pointer_traits;
+
+template<typename C, typename T>
+struct member_pointer_traits<T C::*> {
+    using class_type = C;
+    using member_type = T;
+};
+
+template<typename T, typename = void>
+struct has_glsl_struct : std::false_type { };
+
+template<typename T>
+struct has_glsl_struct<T, std::void_t<typename glsl_struct_of<T>::type>> : std::true_type { };
+
+template<layout_rule R, typename S>
+struct struct_layout;
+
+template<auto First, auto... Rest>
+struct first_member {
+    using class_type = typename member_pointer_traits<decltype(First)>::class_type;
+};
+
+template<layout_rule R, auto... Members>
+struct struct_layout<R, glsl_struct<Members...>> {
+    static_assert(sizeof...(Members) > 0, "glsl_struct needs at least one member");
+
+    using class_type = typename first_member<Members...>::class_type;
+
+    template<auto M>
+    using member_layout = layout_of<typename member_pointer_traits<decltype(M)>::member_type, R>;
+
+    static constexpr size_t count = sizeof...(Members);
+
+    static constexpr std::array<size_t, count> alignments = { member_layout<Members>::alignment... };
+    static constexpr std::array<size_t, count> sizes = { member_layout<Members>::size... };
+
+    static constexpr std::array<size_t, count> computeOffsets() {
+        std::array<size_t, count> offsets {};
+        size_t offset = 0;
+        for (size_t i = 0; i < count; ++i) {
+            offset = alignUp(offset, alignments[i]);
+            offsets[i] = offset;
+            offset += sizes[i];
+        }
+        return offsets;
+    }
+
+    static constexpr size_t computeAlignment() {
+        size_t alignment = 1;
+        for (size_t a : alignments) {
+            alignment = std::max(alignment, a);
+        }
+        return arrayAlignment(R, alignment);
+    }
+
+    static constexpr std::array<size_t, count> offsets = computeOffsets();
+    static constexpr size_t alignment = computeAlignment();
+    static constexpr size_t size = alignUp(offsets[count - 1] + sizes[count - 1], alignment);
+
+    static constexpr std::array<GLenum, count> glTypes = { member_layout<Members>::glType... };
+    static constexpr std::array<size_t, count> arraySizes = { member_layout<Members>::arraySize... };
+
+    template<size_t... I>
+    static void writeMembers(uint8_t* pDst, const class_type& value, std::index_sequence<I...>) {
+        (member_layout<Members>::write(pDst + offsets[I], value.*Members), ...);
+    }
+
+    static void write(uint8_t* pDst, const class_type& value) {
+        writeMembers(pDst, value, std::make_index_sequence<count>());
+    }
+
+    static bool sameAsCpp() {
+        // offsetof for member pointers, against a dummy object
+        static const bool same = [] {
+            alignas(class_type) uint8_t storage[sizeof(class_type)] = {};
+            const class_type* pObject = reinterpret_cast<const class_type*>(storage);
+            size_t i = 0;
+            bool result = size == sizeof(class_type);
+            ((result = result && member_layout<Members>::sameAsCpp()
+                && (size_t) (reinterpret_cast<const uint8_t*>(&(pObject->*Members)) - storage) == offsets[i++]), ...);
+            return result;
+        }();
+        return same;
+    }
+};
+
+}  // namespace detail
+
+// Scalars
+template<typename T, layout_rule R>
+struct layout_of<T, R, std::enable_if_t<detail::is_glsl_scalar<T>::value>> {
+    static constexpr size_t alignment = 4;
+    static constexpr size_t size = 4;
+    static constexpr GLenum glType = detail::scalar_gl_type<T>::vec[1];
+    static constexpr size_t arraySize = 1;
+
+    static void write(uint8_t* pDst, const T& value) {
+        memcpy(pDst, &value, size);
+    }
+
+    static constexpr bool sameAsCpp() {
+        return true;
+    }
+};
+
+// Vectors
+template<typename T, size_t N, layout_rule R>
+struct layout_of<std::array<T, N>, R, std::enable_if_t<detail::is_glsl_scalar<T>::value && N >= 2 && N <= 4>> {
+    static constexpr size_t alignment = (N == 2) ? 8 : 16;
+    static constexpr size_t size = 4 * N;
+    static constexpr GLenum glType = detail::scalar_gl_type<T>::vec[N];
+    static constexpr size_t arraySize = 1;
+
+    static void write(uint8_t* pDst, const std::array<T, N>& value) {
+        memcpy(pDst, value.data(), size);
+    }
+
+    static constexpr bool sameAsCpp() {
+        return sizeof(std::array<T, N>) == size;
+    }
+};
+
+// Matrices, laid out as an array of column vectors
+template<size_t C, size_t Rows, layout_rule R>
+struct layout_of<std::array<std::array<float, Rows>, C>, R, std::enable_if_t<C >= 2 && C <= 4 && Rows >= 2 && Rows <= 4>> {
+    using column = layout_of<std::array<float, Rows>, R>;
+
+    static constexpr size_t alignment = detail::arrayAlignment(R, column::alignment);
+    static constexpr size_t columnStride = detail::alignUp(column::size, alignment);
+    static constexpr size_t size = columnStride * C;
+    static constexpr GLenum glType = detail::matrixGlTypes[C][Rows];
+    static constexpr size_t arraySize = 1;
+
+    static void write(uint8_t* pDst, const std::array<std::array<float, Rows>, C>& value) {
+        for (size_t c = 0; c < C; ++c) {
+            memcpy(pDst + c * columnStride, value[c].data(), column::size);
+        }
+    }
+
+    static constexpr bool sameAsCpp() {
+        return columnStride == sizeof(std::array<float, Rows>);
+    }
+};
+
+// Arrays
+template<typename T, size_t N, layout_rule R>
+struct layout_of<T[N], R> {
+    using element = layout_of<T, R>;
+
+    static constexpr size_t alignment = detail::arrayAlignment(R, element::alignment);
+    static constexpr size_t stride = detail::alignUp(element::size, alignment);
+    static constexpr size_t size = stride * N;
+    static constexpr GLenum glType = element::glType;
+    static constexpr size_t arraySize = N;
+
+    static void write(uint8_t* pDst, const T (&value)[N]) {
+        if (sameAsCpp()) {
+            memcpy(pDst, value, sizeof(value));
+            return;
+        }
+        for (size_t i = 0; i < N; ++i) {
+            element::write(pDst + i * stride, value[i]);
+        }
+    }
+
+    static bool sameAsCpp() {
+        return stride == sizeof(T) && element::sameAsCpp();
+    }
+};
+
+// Structs described with glsl_struct_of
+template<typename T, layout_rule R>
+struct layout_of<T, R, std::enable_if_t<detail::has_glsl_struct<T>::value>> {
+    using members = detail::struct_layout<R, typename glsl_struct_of<T>::type>;
+
+    static constexpr size_t alignment = members::alignment;
+    static constexpr size_t size = members::size;
+    static constexpr GLenum glType = 0;
+    static constexpr size_t arraySize = 1;
+
+    static void write(uint8_t* pDst, const T& value) {
+        if (sameAsCpp()) {
+            memcpy(pDst, &value, size);
+            return;
+        }
+        members::write(pDst, value);
+    }
+
+    static bool sameAsCpp() {
+        return members::sameAsCpp();
+    }
+};
+
+// Layout of a whole buffer block (or an array of them) holding T
+template<typename T, layout_rule R = layout_rule::STD140>
+struct buffer_layout {
+    using layout = layout_of<T, R>;
+
+    static constexpr size_t size = layout::size;
+    static constexpr size_t alignment = layout::alignment;
+    // stride between consecutive T in an array, e.g. for T[] at the end of an SSBO
+    static constexpr size_t arrayStride = detail::alignUp(size, detail::arrayAlignment(R, alignment));
+
+    static void write(void* pDst, const T& value) {
+        layout::write(static_cast<uint8_t*>(pDst), value);
+    }
+
+    // One memcpy when T's C++ layout already matches, otherwise one pass writing each element
+    static void writeArray(void* pDst, const T* pValues, size_t count) {
+        uint8_t* pBytes = static_cast<uint8_t*>(pDst);
+        if (arrayStride == sizeof(T) && layout::sameAsCpp()) {
+            memcpy(pBytes, pValues, count * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            layout::write(pBytes + i * arrayStride, pValues[i]);
+        }
+    }
+
+    // Check the layout against a block reflected from a linked program. Every top-level member needs a
+    // reflected member at the same offset (with the same type and array size, except for nested structs),
+    // and the block size has to match. On failure, a description is put in pError if it isn't null.
+    static bool validate(const program_reflection& reflection, const program_reflection::block& block,
+            std::string* pError = nullptr) {
+        static_assert(detail::has_glsl_struct<T>::value, "Only struct layouts can be validated against a block");
+        using members = typename layout::members;
+
+        auto fail = [&] (const std::string& message) {
+            if (pError) *pError = reflection.name(block) + ": " + message;
+            return false;
+        };
+
+        if ((size_t) block.dataSize < size || (size_t) block.dataSize > detail::alignUp(size, 16)) {
+            return fail("block size " + std::to_string(block.dataSize) + " does not match layout size " + std::to_string(size));
+        }
+
+        const program_reflection::variable* pBegin = reflection.members(block);
+        const program_reflection::variable* pEnd = pBegin + block.memberCount;
+        for (size_t i = 0; i < members::count; ++i) {
+            GLint offset = (GLint) members::offsets[i];
+            const auto* pMember = std::lower_bound(pBegin, pEnd, offset, [] (const program_reflection::variable& v, GLint offset) {
+                    return v.offset < offset;
+                });
+            if (pMember == pEnd || pMember->offset != offset) {
+                return fail("no member at offset " + std::to_string(offset) + " (member " + std::to_string(i) + ")");
+            }
+            if (members::glTypes[i] != 0 && ((GLenum) pMember->type != members::glTypes[i]
+                    || (size_t) pMember->arraySize != members::arraySizes[i])) {
+                return fail("member " + reflection.name(*pMember) + " type or array size does not match");
+            }
+        }
+        return true;
+    }
+};
+
+}  // namespace ogu
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "gl_dispatch.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "buffer.h"
+#include "shader.h"
+#include "stream_buffer.h"
+#include "vertex_layout.h"
+
+
+namespace ogu {
+
+// Layout of one command in GL_DRAW_INDIRECT_BUFFER for glMultiDrawElementsIndirect
+struct draw_elements_indirect_command {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+static_assert(sizeof(draw_elements_indirect_command) == 20, "indirect commands must be tightly packed");
+
+// Collects indexed draws for a frame, sorts them by state and submits every run of draws sharing a
+// program, vertex layout, vertex buffers and index buffer with one glMultiDrawElementsIndirect.
+// Without ARB_multi_draw_indirect each run is drawn with a loop of
+// glDrawElementsInstancedBaseVertexBaseInstance instead, so the batch needs GL 4.2 / ARB_base_instance
+// either way.
+//
+// Per-draw instance data (e.g. a model matrix) is packed into a shader storage buffer in submission
+// order, and each draw's baseInstance is set to the index of its record. Shaders read their record at
+// gl_BaseInstance, which works for both submission paths. Instance data needs GL 4.3 /
+// ARB_shader_storage_buffer_object and GL 4.6 / ARB_shader_draw_parameters. Since baseInstance also
+// offsets attributes with a divisor, draws with instance data can't use layouts with instanced bindings.
+class draw_batch {
+public:
+
+    struct draw {
+        const shader_program* program;
+        const vertex_layout* layout;  // from vertex_array_cache::intern()
+        const buffer_range* pVertexBuffers;  // one per layout binding, must stay valid until submit()
+        const buffer* indexBuffer;
+        GLenum mode;
+        GLenum indexType;
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t baseVertex;
+        uint32_t instanceCount;
+        uint32_t baseInstance;  // ignored when the batch has per-draw instance data
+    };
+
+    struct stats {
+        uint64_t draws;
+        uint64_t batches;  // runs of draws with the same state
+        uint64_t drawCalls;  // GL draw calls issued
+    };
+
+    // Throws std::runtime_error if the context lacks what the batch needs, see above.
+    // @param instanceDataSize bytes of per-draw data, 0 for none
+    // @param instanceBinding the GL_SHADER_STORAGE_BUFFER binding the instance data is bound to
+    explicit draw_batch(uint32_t instanceDataSize = 0, GLuint instanceBinding = 0);
+
+    draw_batch(const draw_batch&) = delete;
+
+    draw_batch& operator=(const draw_batch&) = delete;
+
+    // Queue a draw, copying instanceDataSize bytes from pInstanceData if the batch has instance data.
+    // Throws std::invalid_argument for a layout with instanced bindings when the batch has instance data.
+    void add(const draw& d, const void* pInstanceData = nullptr);
+
+    inline size_t size() const {
+        return _draws.size();
+    }
+
+    // Sorts the queued draws by state, writes commands and instance data to the stream and draws them.
+    // Clears the queue afterwards.
+    void submit(stream_buffer& stream, vertex_array_cache& vertexArrays);
+
+    void clear();
+
+    // Sort and group the queued draws without touching GL, returns the number of batches.
+    // submit() does this itself, it's exposed to measure the CPU side of building the batch.
+    size_t build();
+
+    inline const stats& lastStats() const {
+        return _lastStats;
+    }
+
+private:
+
+    uint32_t _instanceDataSize;
+    GLuint _instanceBinding;
+
+    std::vector<draw> _draws;
+    std::vector<uint64_t> _keys;
+    std::vector<uint8_t> _instanceData;
+
+    // built by build(): draw indices in submission order, and where each run of equal state starts
+    std::vector<uint32_t> _order;
+    std::vector<uint32_t> _runStarts;
+
+    stats _lastStats {};
+
+    static uint64_t stateKey(const draw& d);
+    static bool sameState(const draw& a, const draw& b);
+
+};
+
+}  // namespace ogu
@@ -0,0 +1,506 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Every GL entry point the library calls, without the gl prefix
+#define OGU_GL_FUNCTIONS(X) \
+    X(ActiveTexture) \
+    X(AttachShader) \
+    X(BeginQuery) \
+    X(BindBuffer) \
+    X(BindBufferBase) \
+    X(BindBufferRange) \
+    X(BindTexture) \
+    X(BindVertexArray) \
+    X(BindVertexBuffer) \
+    X(BufferData) \
+    X(BufferStorage) \
+    X(ClientWaitSync) \
+    X(CompileShader) \
+    X(CompressedTexImage1D) \
+    X(CompressedTexImage2D) \
+    X(CompressedTexImage3D) \
+    X(CompressedTexSubImage1D) \
+    X(CompressedTexSubImage2D) \
+    X(CompressedTexSubImage3D) \
+    X(CompressedTextureSubImage1D) \
+    X(CompressedTextureSubImage2D) \
+    X(CompressedTextureSubImage3D) \
+    X(CopyImageSubData) \
+    X(CreateBuffers) \
+    X(CreateProgram) \
+    X(CreateShader) \
+    X(CreateTextures) \
+    X(CreateVertexArrays) \
+    X(DeleteBuffers) \
+    X(DeleteProgram) \
+    X(DeleteQueries) \
+    X(DeleteShader) \
+    X(DeleteSync) \
+    X(DeleteTextures) \
+    X(DeleteVertexArrays) \
+    X(DetachShader) \
+    X(DrawArraysInstanced) \
+    X(DrawElementsInstancedBaseVertex) \
+    X(DrawElementsInstancedBaseVertexBaseInstance) \
+    X(EnableVertexArrayAttrib) \
+    X(EnableVertexAttribArray) \
+    X(EndQuery) \
+    X(FenceSync) \
+    X(Flush) \
+    X(FlushMappedBufferRange) \
+    X(FlushMappedNamedBufferRange) \
+    X(GenBuffers) \
+    X(GenQueries) \
+    X(GenTextures) \
+    X(GenVertexArrays) \
+    X(GenerateMipmap) \
+    X(GenerateTextureMipmap) \
+    X(GetActiveAttrib) \
+    X(GetActiveUniformBlockName) \
+    X(GetActiveUniformBlockiv) \
+    X(GetActiveUniformName) \
+    X(GetActiveUniformsiv) \
+    X(GetAttribLocation) \
+    X(GetInteger64v) \
+    X(GetIntegerv) \
+    X(GetProgramBinary) \
+    X(GetProgramInfoLog) \
+    X(GetProgramInterfaceiv) \
+    X(GetProgramResourceName) \
+    X(GetProgramResourceiv) \
+    X(GetProgramiv) \
+    X(GetQueryObjectiv) \
+    X(GetQueryObjectui64v) \
+    X(GetShaderInfoLog) \
+    X(GetShaderiv) \
+    X(GetString) \
+    X(GetUniformLocation) \
+    X(GetUniformfv) \
+    X(GetUniformiv) \
+    X(GetUniformuiv) \
+    X(LinkProgram) \
+    X(MapBufferRange) \
+    X(MapNamedBufferRange) \
+    X(MaxShaderCompilerThreadsARB) \
+    X(MaxShaderCompilerThreadsKHR) \
+    X(MultiDrawElementsIndirect) \
+    X(NamedBufferData) \
+    X(NamedBufferStorage) \
+    X(PixelStorei) \
+    X(ProgramBinary) \
+    X(ProgramParameteri) \
+    X(ProgramUniform1f) \
+    X(ProgramUniform1i) \
+    X(ProgramUniform1ui) \
+    X(ProgramUniform2fv) \
+    X(ProgramUniform2iv) \
+    X(ProgramUniform2uiv) \
+    X(ProgramUniform3fv) \
+    X(ProgramUniform3iv) \
+    X(ProgramUniform3uiv) \
+    X(ProgramUniform4fv) \
+    X(ProgramUniform4iv) \
+    X(ProgramUniform4uiv) \
+    X(ProgramUniformMatrix2fv) \
+    X(ProgramUniformMatrix3fv) \
+    X(ProgramUniformMatrix4fv) \
+    X(QueryCounter) \
+    X(ShaderSource) \
+    X(TexBuffer) \
+    X(TexImage1D) \
+    X(TexImage2D) \
+    X(TexImage3D) \
+    X(TexParameterfv) \
+    X(TexParameteri) \
+    X(TexStorage1D) \
+    X(TexStorage2D) \
+    X(TexStorage3D) \
+    X(TexSubImage1D) \
+    X(TexSubImage2D) \
+    X(TexSubImage3D) \
+    X(TextureBuffer) \
+    X(TextureParameterfv) \
+    X(TextureParameteri) \
+    X(TextureStorage1D) \
+    X(TextureStorage2D) \
+    X(TextureStorage3D) \
+    X(TextureSubImage1D) \
+    X(TextureSubImage2D) \
+    X(TextureSubImage3D) \
+    X(Uniform1f) \
+    X(Uniform1i) \
+    X(Uniform1ui) \
+    X(Uniform2fv) \
+    X(Uniform2iv) \
+    X(Uniform2uiv) \
+    X(Uniform3fv) \
+    X(Uniform3iv) \
+    X(Uniform3uiv) \
+    X(Uniform4fv) \
+    X(Uniform4iv) \
+    X(Uniform4uiv) \
+    X(UniformBlockBinding) \
+    X(UniformMatrix2fv) \
+    X(UniformMatrix3fv) \
+    X(UniformMatrix4fv) \
+    X(UnmapBuffer) \
+    X(UnmapNamedBuffer) \
+    X(UseProgram) \
+    X(VertexArrayAttribBinding) \
+    X(VertexArrayAttribFormat) \
+    X(VertexArrayAttribIFormat) \
+    X(VertexArrayBindingDivisor) \
+    X(VertexArrayVertexBuffer) \
+    X(VertexAttribBinding) \
+    X(VertexAttribDivisor) \
+    X(VertexAttribFormat) \
+    X(VertexAttribIFormat) \
+    X(VertexAttribIPointer) \
+    X(VertexAttribPointer) \
+    X(VertexBindingDivisor) \
+    X(WaitSync)
+
+#ifdef OGU_GL_DISPATCH
+
+#include <type_traits>
+
+
+namespace ogu {
+namespace gl {
+
+// With OGU_GL_DISPATCH defined (the OGU_MOCK_GL CMake option), every GL call made through the ogu
+// headers goes through this table instead of straight to GLEW, so that a stand-in backend such as
+// mock_gl can take over without a context. Code that includes ogu headers is routed too.
+struct dispatch_table {
+#define OGU_GL_TABLE_ENTRY(name) std::decay_t<decltype(gl##name)> name;
+    OGU_GL_FUNCTIONS(OGU_GL_TABLE_ENTRY)
+#undef OGU_GL_TABLE_ENTRY
+};
+
+extern dispatch_table table;
+
+// Points the table at GLEW's entry points, called by init() after glewInit()
+void loadDispatchTable();
+
+}  // namespace gl
+}  // namespace ogu
+
+#ifndef OGU_GL_DISPATCH_IMPLEMENTATION
+
+#undef glActiveTexture
+#define glActiveTexture ::ogu::gl::table.ActiveTexture
+#undef glAttachShader
+#define glAttachShader ::ogu::gl::table.AttachShader
+#undef glBeginQuery
+#define glBeginQuery ::ogu::gl::table.BeginQuery
+#undef glBindBuffer
+#define glBindBuffer ::ogu::gl::table.BindBuffer
+#undef glBindBufferBase
+#define glBindBufferBase ::ogu::gl::table.BindBufferBase
+#undef glBindBufferRange
+#define glBindBufferRange ::ogu::gl::table.BindBufferRange
+#undef glBindTexture
+#define glBindTexture ::ogu::gl::table.BindTexture
+#undef glBindVertexArray
+#define glBindVertexArray ::ogu::gl::table.BindVertexArray
+#undef glBindVertexBuffer
+#define glBindVertexBuffer ::ogu::gl::table.BindVertexBuffer
+#undef glBufferData
+#define glBufferData ::ogu::gl::table.BufferData
+#undef glBufferStorage
+#define glBufferStorage ::ogu::gl::table.BufferStorage
+#undef glClientWaitSync
+#define glClientWaitSync ::ogu::gl::table.ClientWaitSync
+#undef glCompileShader
+#define glCompileShader ::ogu::gl::table.CompileShader
+#undef glCompressedTexImage1D
+#define glCompressedTexImage1D ::ogu::gl::table.CompressedTexImage1D
+#undef glCompressedTexImage2D
+#define glCompressedTexImage2D ::ogu::gl::table.CompressedTexImage2D
+#undef glCompressedTexImage3D
+#define glCompressedTexImage3D ::ogu::gl::table.CompressedTexImage3D
+#undef glCompressedTexSubImage1D
+#define glCompressedTexSubImage1D ::ogu::gl::table.CompressedTexSubImage1D
+#undef glCompressedTexSubImage2D
+#define glCompressedTexSubImage2D ::ogu::gl::table.CompressedTexSubImage2D
+#undef glCompressedTexSubImage3D
+#define glCompressedTexSubImage3D ::ogu::gl::table.CompressedTexSubImage3D
+#undef glCompressedTextureSubImage1D
+#define glCompressedTextureSubImage1D ::ogu::gl::table.CompressedTextureSubImage1D
+#undef glCompressedTextureSubImage2D
+#define glCompressedTextureSubImage2D ::ogu::gl::table.CompressedTextureSubImage2D
+#undef glCompressedTextureSubImage3D
+#define glCompressedTextureSubImage3D ::ogu::gl::table.CompressedTextureSubImage3D
+#undef glCopyImageSubData
+#define glCopyImageSubData ::ogu::gl::table.CopyImageSubData
+#undef glCreateBuffers
+#define glCreateBuffers ::ogu::gl::table.CreateBuffers
+#undef glCreateProgram
+#define glCreateProgram ::ogu::gl::table.CreateProgram
+#undef glCreateShader
+#define glCreateShader ::ogu::gl::table.CreateShader
+#undef glCreateTextures
+#define glCreateTextures ::ogu::gl::table.CreateTextures
+#undef glCreateVertexArrays
+#define glCreateVertexArrays ::ogu::gl::table.CreateVertexArrays
+#undef glDeleteBuffers
+#define glDeleteBuffers ::ogu::gl::table.DeleteBuffers
+#undef glDeleteProgram
+#define glDeleteProgram ::ogu::gl::table.DeleteProgram
+#undef glDeleteQueries
+#define glDeleteQueries ::ogu::gl::table.DeleteQueries
+#undef glDeleteShader
+#define glDeleteShader ::ogu::gl::table.DeleteShader
+#undef glDeleteSync
+#define glDeleteSync ::ogu::gl::table.DeleteSync
+#undef glDeleteTextures
+#define glDeleteTextures ::ogu::gl::table.DeleteTextures
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays ::ogu::gl::table.DeleteVertexArrays
+#undef glDetachShader
+#define glDetachShader ::ogu::gl::table.DetachShader
+#undef glDrawArraysInstanced
+#define glDrawArraysInstanced ::ogu::gl::table.DrawArraysInstanced
+#undef glDrawElementsInstancedBaseVertex
+#define glDrawElementsInstancedBaseVertex ::ogu::gl::table.DrawElementsInstancedBaseVertex
+#undef glDrawElementsInstancedBaseVertexBaseInstance
+#define glDrawElementsInstancedBaseVertexBaseInstance ::ogu::gl::table.DrawElementsInstancedBaseVertexBaseInstance
+#undef glEnableVertexArrayAttrib
+#define glEnableVertexArrayAttrib ::ogu::gl::table.EnableVertexArrayAttrib
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray ::ogu::gl::table.EnableVertexAttribArray
+#undef glEndQuery
+#define glEndQuery ::ogu::gl::table.EndQuery
+#undef glFenceSync
+#define glFenceSync ::ogu::gl::table.FenceSync
+#undef glFlush
+#define glFlush ::ogu::gl::table.Flush
+#undef glFlushMappedBufferRange
+#define glFlushMappedBufferRange ::ogu::gl::table.FlushMappedBufferRange
+#undef glFlushMappedNamedBufferRange
+#define glFlushMappedNamedBufferRange ::ogu::gl::table.FlushMappedNamedBufferRange
+#undef glGenBuffers
+#define glGenBuffers ::ogu::gl::table.GenBuffers
+#undef glGenQueries
+#define glGenQueries ::ogu::gl::table.GenQueries
+#undef glGenTextures
+#define glGenTextures ::ogu::gl::table.GenTextures
+#undef glGenVertexArrays
+#define glGenVertexArrays ::ogu::gl::table.GenVertexArrays
+#undef glGenerateMipmap
+#define glGenerateMipmap ::ogu::gl::table.GenerateMipmap
+#undef glGenerateTextureMipmap
+#define glGenerateTextureMipmap ::ogu::gl::table.GenerateTextureMipmap
+#undef glGetActiveAttrib
+#define glGetActiveAttrib ::ogu::gl::table.GetActiveAttrib
+#undef glGetActiveUniformBlockName
+#define glGetActiveUniformBlockName ::ogu::gl::table.GetActiveUniformBlockName
+#undef glGetActiveUniformBlockiv
+#define glGetActiveUniformBlockiv ::ogu::gl::table.GetActiveUniformBlockiv
+#undef glGetActiveUniformName
+#define glGetActiveUniformName ::ogu::gl::table.GetActiveUniformName
+#undef glGetActiveUniformsiv
+#define glGetActiveUniformsiv ::ogu::gl::table.GetActiveUniformsiv
+#undef glGetAttribLocation
+#define glGetAttribLocation ::ogu::gl::table.GetAttribLocation
+#undef glGetInteger64v
+#define glGetInteger64v ::ogu::gl::table.GetInteger64v
+#undef glGetIntegerv
+#define glGetIntegerv ::ogu::gl::table.GetIntegerv
+#undef glGetProgramBinary
+#define glGetProgramBinary ::ogu::gl::table.GetProgramBinary
+#undef glGetProgramInfoLog
+#define glGetProgramInfoLog ::ogu::gl::table.GetProgramInfoLog
+#undef glGetProgramInterfaceiv
+#define glGetProgramInterfaceiv ::ogu::gl::table.GetProgramInterfaceiv
+#undef glGetProgramResourceName
+#define glGetProgramResourceName ::ogu::gl::table.GetProgramResourceName
+#undef glGetProgramResourceiv
+#define glGetProgramResourceiv ::ogu::gl::table.GetProgramResourceiv
+#undef glGetProgramiv
+#define glGetProgramiv ::ogu::gl::table.GetProgramiv
+#undef glGetQueryObjectiv
+#define glGetQueryObjectiv ::ogu::gl::table.GetQueryObjectiv
+#undef glGetQueryObjectui64v
+#define glGetQueryObjectui64v ::ogu::gl::table.GetQueryObjectui64v
+#undef glGetShaderInfoLog
+#define glGetShaderInfoLog ::ogu::gl::table.GetShaderInfoLog
+#undef glGetShaderiv
+#define glGetShaderiv ::ogu::gl::table.GetShaderiv
+#undef glGetString
+#define glGetString ::ogu::gl::table.GetString
+#undef glGetUniformLocation
+#define glGetUniformLocation ::ogu::gl::table.GetUniformLocation
+#undef glGetUniformfv
+#define glGetUniformfv ::ogu::gl::table.GetUniformfv
+#undef glGetUniformiv
+#define glGetUniformiv ::ogu::gl::table.GetUniformiv
+#undef glGetUniformuiv
+#define glGetUniformuiv ::ogu::gl::table.GetUniformuiv
+#undef glLinkProgram
+#define glLinkProgram ::ogu::gl::table.LinkProgram
+#undef glMapBufferRange
+#define glMapBufferRange ::ogu::gl::table.MapBufferRange
+#undef glMapNamedBufferRange
+#define glMapNamedBufferRange ::ogu::gl::table.MapNamedBufferRange
+#undef glMaxShaderCompilerThreadsARB
+#define glMaxShaderCompilerThreadsARB ::ogu::gl::table.MaxShaderCompilerThreadsARB
+#undef glMaxShaderCompilerThreadsKHR
+#define glMaxShaderCompilerThreadsKHR ::ogu::gl::table.MaxShaderCompilerThreadsKHR
+#undef glMultiDrawElementsIndirect
+#define glMultiDrawElementsIndirect ::ogu::gl::table.MultiDrawElementsIndirect
+#undef glNamedBufferData
+#define glNamedBufferData ::ogu::gl::table.NamedBufferData
+#undef glNamedBufferStorage
+#define glNamedBufferStorage ::ogu::gl::table.NamedBufferStorage
+#undef glPixelStorei
+#define glPixelStorei ::ogu::gl::table.PixelStorei
+#undef glProgramBinary
+#define glProgramBinary ::ogu::gl::table.ProgramBinary
+#undef glProgramParameteri
+#define glProgramParameteri ::ogu::gl::table.ProgramParameteri
+#undef glProgramUniform1f
+#define glProgramUniform1f ::ogu::gl::table.ProgramUniform1f
+#undef glProgramUniform1i
+#define glProgramUniform1i ::ogu::gl::table.ProgramUniform1i
+#undef glProgramUniform1ui
+#define glProgramUniform1ui ::ogu::gl::table.ProgramUniform1ui
+#undef glProgramUniform2fv
+#define glProgramUniform2fv ::ogu::gl::table.ProgramUniform2fv
+#undef glProgramUniform2iv
+#define glProgramUniform2iv ::ogu::gl::table.ProgramUniform2iv
+#undef glProgramUniform2uiv
+#define glProgramUniform2uiv ::ogu::gl::table.ProgramUniform2uiv
+#undef glProgramUniform3fv
+#define glProgramUniform3fv ::ogu::gl::table.ProgramUniform3fv
+#undef glProgramUniform3iv
+#define glProgramUniform3iv ::ogu::gl::table.ProgramUniform3iv
+#undef glProgramUniform3uiv
+#define glProgramUniform3uiv ::ogu::gl::table.ProgramUniform3uiv
+#undef glProgramUniform4fv
+#define glProgramUniform4fv ::ogu::gl::table.ProgramUniform4fv
+#undef glProgramUniform4iv
+#define glProgramUniform4iv ::ogu::gl::table.ProgramUniform4iv
+#undef glProgramUniform4uiv
+#define glProgramUniform4uiv ::ogu::gl::table.ProgramUniform4uiv
+#undef glProgramUniformMatrix2fv
+#define glProgramUniformMatrix2fv ::ogu::gl::table.ProgramUniformMatrix2fv
+#undef glProgramUniformMatrix3fv
+#define glProgramUniformMatrix3fv ::ogu::gl::table.ProgramUniformMatrix3fv
+#undef glProgramUniformMatrix4fv
+#define glProgramUniformMatrix4fv ::ogu::gl::table.ProgramUniformMatrix4fv
+#undef glQueryCounter
+#define glQueryCounter ::ogu::gl::table.QueryCounter
+#undef glShaderSource
+#define glShaderSource ::ogu::gl::table.ShaderSource
+#undef glTexBuffer
+#define glTexBuffer ::ogu::gl::table.TexBuffer
+#undef glTexImage1D
+#define glTexImage1D ::ogu::gl::table.TexImage1D
+#undef glTexImage2D
+#define glTexImage2D ::ogu::gl::table.TexImage2D
+#undef glTexImage3D
+#define glTexImage3D ::ogu::gl::table.TexImage3D
+#undef glTexParameterfv
+#define glTexParameterfv ::ogu::gl::table.TexParameterfv
+#undef glTexParameteri
+#define glTexParameteri ::ogu::gl::table.TexParameteri
+#undef glTexStorage1D
+#define glTexStorage1D ::ogu::gl::table.TexStorage1D
+#undef glTexStorage2D
+#define glTexStorage2D ::ogu::gl::table.TexStorage2D
+#undef glTexStorage3D
+#define glTexStorage3D ::ogu::gl::table.TexStorage3D
+#undef glTexSubImage1D
+#define glTexSubImage1D ::ogu::gl::table.TexSubImage1D
+#undef glTexSubImage2D
+#define glTexSubImage2D ::ogu::gl::table.TexSubImage2D
+#undef glTexSubImage3D
+#define glTexSubImage3D ::ogu::gl::table.TexSubImage3D
+#undef glTextureBuffer
+#define glTextureBuffer ::ogu::gl::table.TextureBuffer
+#undef glTextureParameterfv
+#define glTextureParameterfv ::ogu::gl::table.TextureParameterfv
+#undef glTextureParameteri
+#define glTextureParameteri ::ogu::gl::table.TextureParameteri
+#undef glTextureStorage1D
+#define glTextureStorage1D ::ogu::gl::table.TextureStorage1D
+#undef glTextureStorage2D
+#define glTextureStorage2D ::ogu::gl::table.TextureStorage2D
+#undef glTextureStorage3D
+#define glTextureStorage3D ::ogu::gl::table.TextureStorage3D
+#undef glTextureSubImage1D
+#define glTextureSubImage1D ::ogu::gl::table.TextureSubImage1D
+#undef glTextureSubImage2D
+#define glTextureSubImage2D ::ogu::gl::table.TextureSubImage2D
+#undef glTextureSubImage3D
+#define glTextureSubImage3D ::ogu::gl::table.TextureSubImage3D
+#undef glUniform1f
+#define glUniform1f ::ogu::gl::table.Uniform1f
+#undef glUniform1i
+#define glUniform1i ::ogu::gl::table.Uniform1i
+#undef glUniform1ui
+#define glUniform1ui ::ogu::gl::table.Uniform1ui
+#undef glUniform2fv
+#define glUniform2fv ::ogu::gl::table.Uniform2fv
+#undef glUniform2iv
+#define glUniform2iv ::ogu::gl::table.Uniform2iv
+#undef glUniform2uiv
+#define glUniform2uiv ::ogu::gl::table.Uniform2uiv
+#undef glUniform3fv
+#define glUniform3fv ::ogu::gl::table.Uniform3fv
+#undef glUniform3iv
+#define glUniform3iv ::ogu::gl::table.Uniform3iv
+#undef glUniform3uiv
+#define glUniform3uiv ::ogu::gl::table.Uniform3uiv
+#undef glUniform4fv
+#define glUniform4fv ::ogu::gl::table.Uniform4fv
+#undef glUniform4iv
+#define glUniform4iv ::ogu::gl::table.Uniform4iv
+#undef glUniform4uiv
+#define glUniform4uiv ::ogu::gl::table.Uniform4uiv
+#undef glUniformBlockBinding
+#define glUniformBlockBinding ::ogu::gl::table.UniformBlockBinding
+#undef glUniformMatrix2fv
+#define glUniformMatrix2fv ::ogu::gl::table.UniformMatrix2fv
+#undef glUniformMatrix3fv
+#define glUniformMatrix3fv ::ogu::gl::table.UniformMatrix3fv
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv ::ogu::gl::table.UniformMatrix4fv
+#undef glUnmapBuffer
+#define glUnmapBuffer ::ogu::gl::table.UnmapBuffer
+#undef glUnmapNamedBuffer
+#define glUnmapNamedBuffer ::ogu::gl::table.UnmapNamedBuffer
+#undef glUseProgram
+#define glUseProgram ::ogu::gl::table.UseProgram
+#undef glVertexArrayAttribBinding
+#define glVertexArrayAttribBinding ::ogu::gl::table.VertexArrayAttribBinding
+#undef glVertexArrayAttribFormat
+#define glVertexArrayAttribFormat ::ogu::gl::table.VertexArrayAttribFormat
+#undef glVertexArrayAttribIFormat
+#define glVertexArrayAttribIFormat ::ogu::gl::table.VertexArrayAttribIFormat
+#undef glVertexArrayBindingDivisor
+#define glVertexArrayBindingDivisor ::ogu::gl::table.VertexArrayBindingDivisor
+#undef glVertexArrayVertexBuffer
+#define glVertexArrayVertexBuffer ::ogu::gl::table.VertexArrayVertexBuffer
+#undef glVertexAttribBinding
+#define glVertexAttribBinding ::ogu::gl::table.VertexAttribBinding
+#undef glVertexAttribDivisor
+#define glVertexAttribDivisor ::ogu::gl::table.VertexAttribDivisor
+#undef glVertexAttribFormat
+#define glVertexAttribFormat ::ogu::gl::table.VertexAttribFormat
+#undef glVertexAttribIFormat
+#define glVertexAttribIFormat ::ogu::gl::table.VertexAttribIFormat
+#undef glVertexAttribIPointer
+#define glVertexAttribIPointer ::ogu::gl::table.VertexAttribIPointer
+#undef glVertexAttribPointer
+#define glVertexAttribPointer ::ogu::gl::table.VertexAttribPointer
+#undef glVertexBindingDivisor
+#define glVertexBindingDivisor ::ogu::gl::table.VertexBindingDivisor
+#undef glWaitSync
+#define glWaitSync ::ogu::gl::table.WaitSync
+
+#endif  // OGU_GL_DISPATCH_IMPLEMENTATION
+
+#endif  // OGU_GL_DISPATCH
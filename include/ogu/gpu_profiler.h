@@ -0,0 +1,148 @@
+#pragma once
+
+#include "gl_dispatch.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <vector>
+
+
+namespace ogu {
+
+// Per-frame tree of timed scopes, measured on both the CPU (when commands were issued) and the GPU
+// (when they executed). GPU times come from GL_TIMESTAMP queries; without ARB_timer_query only
+// outermost scopes get a GL_TIME_ELAPSED query, since those can't nest. Queries go into a ring of
+// frameLatency frames and are only read back once available, so the profiler never stalls. A frame
+// whose results are still pending when its slot comes around again is dropped.
+// Render thread only. Scope names are kept as pointers and must outlive the profiler (literals).
+class gpu_profiler {
+public:
+
+    // All times in nanoseconds on the CPU timeline since the profiler was created; gpu times are -1
+    // where they weren't measured
+    struct timing {
+        const char* name;
+        int32_t parent;  // index in the frame, -1 for top level
+        uint32_t depth;
+        int64_t cpuBegin;
+        int64_t cpuEnd;
+        int64_t gpuBegin;
+        int64_t gpuEnd;
+    };
+
+    struct frame {
+        uint64_t number;
+        std::vector<timing> timings;  // in begin order, parents before children
+    };
+
+    // CPU and GPU time for everything between construction and destruction
+    class scope {
+    private:
+        gpu_profiler& _profiler;
+    public:
+        scope(gpu_profiler& profiler, const char* name) :
+                _profiler(profiler) {
+            _profiler.begin(name, true);
+        }
+        ~scope() {
+            _profiler.end();
+        }
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+    };
+
+    // CPU time only, e.g. for work that doesn't issue GL commands
+    class cpu_scope {
+    private:
+        gpu_profiler& _profiler;
+    public:
+        cpu_scope(gpu_profiler& profiler, const char* name) :
+                _profiler(profiler) {
+            _profiler.begin(name, false);
+        }
+        ~cpu_scope() {
+            _profiler.end();
+        }
+        cpu_scope(const cpu_scope&) = delete;
+        cpu_scope& operator=(const cpu_scope&) = delete;
+    };
+
+    // @param historyFrames resolved frames kept for lastFrame() and the trace export
+    explicit gpu_profiler(uint32_t frameLatency = 3, size_t historyFrames = 120);
+
+    ~gpu_profiler();
+
+    gpu_profiler(const gpu_profiler&) = delete;
+
+    gpu_profiler& operator=(const gpu_profiler&) = delete;
+
+    void beginFrame();
+
+    // Closes the frame and resolves any older frames whose queries are available
+    void endFrame();
+
+    void begin(const char* name, bool gpu);
+
+    void end();
+
+    // Most recent frame with results, nullptr before the first one resolves
+    const frame* lastFrame() const;
+
+    inline const std::deque<frame>& history() const {
+        return _history;
+    }
+
+    inline uint64_t droppedFrames() const {
+        return _droppedFrames;
+    }
+
+    // Chrome trace event format (chrome://tracing, Perfetto), CPU scopes on thread 0 and GPU on thread 1
+    void writeChromeTrace(std::ostream& out) const;
+
+private:
+
+    static constexpr int32_t NO_QUERY = -1;
+
+    struct node {
+        const char* name;
+        int32_t parent;
+        uint32_t depth;
+        int64_t cpuBegin;
+        int64_t cpuEnd;
+        int32_t beginQuery;  // indices into the slot's queries
+        int32_t endQuery;
+    };
+
+    struct slot {
+        uint64_t number;
+        bool pending;
+        std::vector<node> nodes;
+        std::vector<GLuint> queries;
+        uint32_t queriesUsed;
+    };
+
+    std::chrono::steady_clock::time_point _epoch;
+    int64_t _gpuOffset = 0;  // add to a GL_TIMESTAMP to get the CPU timeline
+
+    std::vector<slot> _slots;
+    uint32_t _current = 0;
+    uint64_t _frameNumber = 0;
+    bool _inFrame = false;
+    std::vector<uint32_t> _stack;
+    int32_t _elapsedOwner = -1;  // node holding the open GL_TIME_ELAPSED query, they can't nest
+
+    size_t _historyFrames;
+    std::deque<frame> _history;
+    uint64_t _droppedFrames = 0;
+
+    int64_t now() const;
+
+    int32_t nextQuery(slot& s);
+
+    bool resolve(slot& s);
+
+};
+
+}  // namespace ogu
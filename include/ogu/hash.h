@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace ogu {
+
+// 64-bit FNV-1a, usable at compile time. Pass a previous result as the basis to hash several
+// pieces of data as one stream.
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+constexpr uint64_t fnv1a(const char* pData, size_t size, uint64_t basis = FNV_OFFSET_BASIS) {
+    uint64_t hash = basis;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (uint64_t) (uint8_t) pData[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t fnv1a(const std::string& s, uint64_t basis = FNV_OFFSET_BASIS) {
+    return fnv1a(s.data(), s.size(), basis);
+}
+
+template<typename T>
+inline uint64_t fnv1a_value(const T& value, uint64_t basis = FNV_OFFSET_BASIS) {
+    return fnv1a(reinterpret_cast<const char*>(&value), sizeof(T), basis);
+}
+
+}  // namespace ogu
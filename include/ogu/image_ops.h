@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "texture.h"
+
+
+namespace ogu {
+
+// CPU-side image processing for texture uploads: mip chain generation and pixel conversions.
+// Inner loops have SIMD versions next to the scalar one, with identical results. SSE2, used wherever
+// the compiler targets it, covers the filter passes and the 8-bit and half float conversions. AVX2
+// (+F16C), picked at runtime on GCC/Clang when the CPU supports it, adds the sRGB table lookups as
+// gathers and the byte shuffles of expandRGB8ToRGBA8 and swizzle8, which SSE2 has no instructions
+// for. Mip levels are resampled across rows on several threads. No GL calls except in uploadMipmaps().
+namespace image_ops {
+
+enum class simd_level {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// Best level this build can run on this CPU
+simd_level supportedSimd();
+
+// Level currently used, supportedSimd() unless capped with setSimdLimit()
+simd_level activeSimd();
+
+// Cap the level used, e.g. to compare the paths. Don't call while other threads are converting.
+void setSimdLimit(simd_level limit);
+
+enum class mip_filter {
+    BOX,  // average of the covered texels, exact for odd sizes too
+    KAISER  // Kaiser-windowed sinc over 3 texels of the smaller level each side, sharper
+};
+
+struct mip_options {
+    mip_filter filter = mip_filter::BOX;
+
+    // 8-bit colour channels hold sRGB values: filter in linear space and encode again. The fourth
+    // (alpha) channel is always filtered as is.
+    bool srgb = false;
+
+    // Worker threads per level, 0 for std::thread::hardware_concurrency()
+    uint32_t threads = 0;
+
+    // Levels in the whole chain including level 0, 0 for the full chain down to 1x1
+    uint32_t levels = 0;
+};
+
+struct mip_level {
+    uint32_t width, height;
+    std::vector<uint8_t> data;  // tightly packed rows in the source format
+};
+
+// Formats generateMipmaps() handles: unsigned normalized 8-bit, 16-bit float and 32-bit float,
+// with any number of components
+bool supportsFormat(const Texture::Format& format);
+
+// Levels 1 and up of a 2D image (for arrays and 3D textures call it per layer / slice). Each level is
+// filtered from the previous one at float precision, so rounding doesn't accumulate down the chain.
+// pLevel0 is tightly packed. Throws std::invalid_argument for unsupported formats.
+std::vector<mip_level> generateMipmaps(const void* pLevel0, uint32_t width, uint32_t height,
+    const Texture::Format& format, const mip_options& options = {});
+
+// writeSubPixels() each level into the texture starting at firstLevel, which must have storage for
+// them (allocateStorage). Rows are tightly packed, so set GL_UNPACK_ALIGNMENT to 1 if they might not
+// be 4-byte multiples.
+void uploadMipmaps(Texture& texture, const std::vector<mip_level>& levels, uint32_t firstLevel = 1);
+
+// IEEE half conversions, rounding to nearest even, with infinities and NaNs kept
+void floatToHalf(const float* pSrc, uint16_t* pDst, size_t count);
+void halfToFloat(const uint16_t* pSrc, float* pDst, size_t count);
+
+// RGB8 -> RGBA8 with a constant alpha
+void expandRGB8ToRGBA8(const uint8_t* pSrc, uint8_t* pDst, size_t pixels, uint8_t alpha = 255);
+
+constexpr uint8_t SWIZZLE_ZERO = 0xfe;
+constexpr uint8_t SWIZZLE_ONE = 0xff;
+
+// Reorder, drop or add channels of 8-bit pixels: destination channel i takes source channel
+// pSwizzle[i], or SWIZZLE_ZERO / SWIZZLE_ONE. E.g. BGRA -> RGBA is {2, 1, 0, 3}.
+void swizzle8(const uint8_t* pSrc, uint32_t srcComponents, uint8_t* pDst, uint32_t dstComponents,
+    const uint8_t* pSwizzle, size_t pixels);
+
+}  // namespace image_ops
+}  // namespace ogu
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "gl_dispatch.h"
+
+
+namespace ogu {
+
+// Optional code paths, detected by init() from the current context
+struct features {
+    // GL 4.5 / ARB_direct_state_access: edit objects by name instead of bind-to-edit
+    bool directStateAccess;
+
+    // KHR/ARB_parallel_shader_compile: compiles and links run in the background and can be polled
+    bool parallelShaderCompile;
+
+    // GL 4.3 / ARB_program_interface_query: reflect a whole program with glGetProgramResource*
+    bool programInterfaceQuery;
+
+    // GL 4.3 / ARB_vertex_attrib_binding: vertex formats separate from vertex buffer bindings
+    bool vertexAttribBinding;
+
+    // GL 4.3 / ARB_multi_draw_indirect: many indirect draws in one call
+    bool multiDrawIndirect;
+
+    // GL 4.2 / ARB_base_instance: draws with a base instance, glDrawElementsInstancedBaseVertexBaseInstance
+    bool baseInstance;
+
+    // GL 4.3 / ARB_shader_storage_buffer_object
+    bool shaderStorageBuffer;
+
+    // GL 4.6 / ARB_shader_draw_parameters: gl_BaseInstance and gl_DrawID in vertex shaders
+    bool shaderDrawParameters;
+
+    // GL 3.3 / ARB_timer_query: GL_TIMESTAMP queries, so timer scopes can nest
+    bool timerQuery;
+
+    // GL 4.3 / ARB_copy_image: copy texel regions between textures without a framebuffer
+    bool copyImage;
+
+    // NVX_gpu_memory_info / ATI_meminfo: the driver reports how much video memory is free
+    bool gpuMemoryInfoNVX;
+    bool memInfoATI;
+};
+
+namespace detail {
+extern features _features;
+}  // namespace detail
+
+// Initializes GLEW and detects which optional code paths the context supports.
+// Must be called once with the context current, before any other ogu object is created.
+// With the mock backend (OGU_MOCK_GL), creating a mock_gl takes the place of init().
+// @param allowDirectStateAccess false to keep the bind-to-edit paths even where DSA is available
+void init(bool allowDirectStateAccess = true);
+
+inline const features& getFeatures() {
+    return detail::_features;
+}
+
+}  // namespace ogu
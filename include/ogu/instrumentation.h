@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+// Hooks used inside the wrappers. They compile to nothing unless OGU_INSTRUMENTATION is defined
+// (the OGU_INSTRUMENTATION CMake option), so the counters cost nothing in normal builds.
+#ifdef OGU_INSTRUMENTATION
+#define OGU_COUNT_CALLS(c, n) ::ogu::instrumentation::countCalls(::ogu::instrumentation::category::c, (n))
+#define OGU_COUNT_UPLOAD(bytes) ::ogu::instrumentation::countUpload(bytes)
+#define OGU_OBJECT_CREATED(t, bytes) ::ogu::instrumentation::objectCreated(::ogu::instrumentation::object_type::t, (bytes))
+#define OGU_OBJECT_DESTROYED(t, bytes) ::ogu::instrumentation::objectDestroyed(::ogu::instrumentation::object_type::t, (bytes))
+#define OGU_OBJECT_RESIZED(t, oldBytes, newBytes) \
+    ::ogu::instrumentation::objectResized(::ogu::instrumentation::object_type::t, (oldBytes), (newBytes))
+#else
+#define OGU_COUNT_CALLS(c, n) ((void) 0)
+#define OGU_COUNT_UPLOAD(bytes) ((void) 0)
+#define OGU_OBJECT_CREATED(t, bytes) ((void) 0)
+#define OGU_OBJECT_DESTROYED(t, bytes) ((void) 0)
+#define OGU_OBJECT_RESIZED(t, oldBytes, newBytes) ((void) 0)
+#endif
+
+#define OGU_COUNT_CALL(c) OGU_COUNT_CALLS(c, 1)
+
+
+namespace ogu {
+namespace instrumentation {
+
+#ifdef OGU_INSTRUMENTATION
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+// GL calls issued by the wrappers, binds only once state_cache has decided not to elide them
+enum class category : uint32_t {
+    BIND,
+    UNIFORM,
+    DRAW,
+    UPLOAD,  // buffer and texture data specification and updates
+    OBJECT,  // creation and deletion
+    COUNT
+};
+
+enum class object_type : uint32_t {
+    BUFFER,
+    TEXTURE,
+    VERTEX_ARRAY,
+    SHADER,
+    PROGRAM,
+    COUNT
+};
+
+constexpr size_t CATEGORY_COUNT = (size_t) category::COUNT;
+constexpr size_t OBJECT_TYPE_COUNT = (size_t) object_type::COUNT;
+
+struct snapshot {
+    uint64_t frame;
+    // counted since the start of the frame
+    uint64_t calls[CATEGORY_COUNT];
+    uint64_t bytesUploaded;
+    // at the time of the snapshot
+    int64_t liveObjects[OBJECT_TYPE_COUNT];
+    int64_t memoryBytes[OBJECT_TYPE_COUNT];  // estimated: buffer sizes, texture levels x format size
+};
+
+// Counters are atomics, the hooks can be hit from any thread
+void countCalls(category c, uint64_t n);
+void countUpload(uint64_t bytes);
+void objectCreated(object_type type, int64_t bytes);
+void objectDestroyed(object_type type, int64_t bytes);
+void objectResized(object_type type, int64_t oldBytes, int64_t newBytes);
+
+// The frame so far
+snapshot current();
+
+// Closes the frame: its counters become lastFrame() and start again from zero
+void endFrame();
+
+// Only stable between endFrame() calls, read it from the thread that calls endFrame()
+const snapshot& lastFrame();
+
+const char* name(category c);
+const char* name(object_type type);
+
+// Write a snapshot into a caller-provided buffer without allocating, always null-terminated when
+// size > 0. Returns the length of the full output like snprintf, so a result >= size means it was cut.
+size_t writeText(const snapshot& s, char* pBuffer, size_t size);
+size_t writeJson(const snapshot& s, char* pBuffer, size_t size);
+
+}  // namespace instrumentation
+}  // namespace ogu
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer.h"
+#include "shader.h"
+#include "texture.h"
+
+
+namespace ogu {
+
+namespace detail {
+
+// Shared between a queued job and its load_ticket
+class load_state {
+public:
+
+    virtual ~load_state();
+
+    bool ready();
+
+    void wait();
+
+    // Called once by the worker, after the fence (0 if the job threw) has been flushed
+    void finish(GLsync fence, std::exception_ptr error);
+
+    // Waits for the worker, makes the calling context's command stream wait on the fence and rethrows
+    // the job's error if it had one
+    void acquire();
+
+private:
+
+    std::mutex _mutex;
+    std::condition_variable _done;
+    bool _finished = false;
+    GLsync _fence = 0;
+    std::exception_ptr _error;
+
+};
+
+template<typename T>
+class typed_load_state : public load_state {
+public:
+    std::unique_ptr<T> object;
+};
+
+}  // namespace detail
+
+// Result of a loader_context job, to be taken on the render thread
+template<typename T>
+class load_ticket {
+public:
+
+    load_ticket() = default;
+
+    // True once the worker is done with the job, the GPU may still be working on it
+    inline bool ready() const {
+        return _state->ready();
+    }
+
+    // Blocks the calling thread until ready()
+    inline void wait() const {
+        _state->wait();
+    }
+
+    // Render thread only. Waits for the worker if needed (check ready() to avoid that), then queues a
+    // glWaitSync on the job's fence, so the GPU, not this thread, waits for the upload to land. Rethrows
+    // whatever the job threw. Can only be called once.
+    inline std::unique_ptr<T> take() {
+        if (!_state) throw std::logic_error("Load ticket is empty or has already been taken.");
+        auto state = std::move(_state);
+        state->acquire();
+        return std::move(state->object);
+    }
+
+    inline bool valid() const {
+        return (bool) _state;
+    }
+
+private:
+
+    friend class loader_context;
+
+    std::shared_ptr<detail::typed_load_state<T>> _state;
+
+    explicit load_ticket(std::shared_ptr<detail::typed_load_state<T>> state) :
+        _state(std::move(state))
+    { }
+
+};
+
+// A worker thread with its own GL context, sharing objects with the render thread's context, that
+// creates buffers, textures and programs and uploads their data off the render thread. Each finished
+// job is fenced and flushed, and load_ticket::take() only makes the render context wait on that fence
+// with glWaitSync. Jobs run in submission order.
+// The caller provides the context as two functions run on the worker: makeCurrent at startup and
+// release at shutdown (e.g. a hidden GLFW window created with the render window as its share).
+// createSurfaceless() does it all with EGL when built with OGU_EGL. Only objects GL shares between
+// contexts may be created: not vertex arrays, framebuffers or queries.
+class loader_context {
+public:
+
+    enum class job_type {
+        BUFFER,
+        TEXTURE,
+        PROGRAM,
+        CUSTOM
+    };
+
+    static constexpr size_t JOB_TYPES = 4;
+
+    struct job_stats {
+        uint64_t completed;
+        uint64_t failed;
+        uint64_t bytes;
+        double meanLatencyMs;  // submit() until handed over (fence flushed), queueing included
+        double maxLatencyMs;
+        double meanRunMs;  // on the worker
+        double jobsPerSecond;  // completed per second of worker time
+        double bytesPerSecond;
+    };
+
+    struct stats {
+        job_stats jobs[JOB_TYPES];
+        size_t queued;
+    };
+
+    // The functions run on the worker thread. makeCurrent is expected to throw if it fails, which is
+    // rethrown here after release has been called.
+    loader_context(std::function<void()> makeCurrent, std::function<void()> release);
+
+    // Jobs still queued are cancelled, their tickets throw std::runtime_error
+    ~loader_context();
+
+    loader_context(const loader_context&) = delete;
+
+    loader_context& operator=(const loader_context&) = delete;
+
+#ifdef OGU_EGL
+    // Surfaceless EGL context sharing with the EGL context current on the calling thread (e.g. under
+    // Mesa without any window). Version 0 keeps the EGL default. Throws std::runtime_error if EGL can't
+    // do it.
+    static std::unique_ptr<loader_context> createSurfaceless(int majorVersion = 0, int minorVersion = 0,
+        bool coreProfile = false);
+#endif
+
+    // Immutable buffer through glBufferStorage with the given data
+    load_ticket<buffer> createBuffer(std::vector<uint8_t> data, GLbitfield storageFlags = 0);
+
+    // Texture with every level stored in a KTX2 or DDS file (see texture_file)
+    load_ticket<Texture> createTexture(std::string path);
+
+    // Texture from tightly packed level 0 pixels, the other levels generated with image_ops when the
+    // format allows (for 2D textures), left undefined otherwise
+    load_ticket<Texture> createTexture(Texture::Dimension dimension, Texture::Format format, uint32_t levels,
+        uint32_t width, uint32_t height, uint32_t depth, std::vector<uint8_t> pixels);
+
+    // Compiled and linked on the worker
+    load_ticket<shader_program> createProgram(std::vector<shader_source> stages);
+
+    // Anything else, fn runs on the worker with its context current. bytes only feeds the stats.
+    template<typename T, typename Fn>
+    load_ticket<T> submit(job_type type, Fn fn, size_t bytes = 0);
+
+    stats getStats();
+
+private:
+
+    using clock = std::chrono::steady_clock;
+
+    struct job {
+        job_type type;
+        size_t bytes;
+        clock::time_point submitted;
+        std::shared_ptr<detail::load_state> state;
+        std::function<void(size_t& bytes)> run;
+    };
+
+    struct accumulator {
+        uint64_t completed = 0, failed = 0, bytes = 0;
+        double latencyMs = 0.0, maxLatencyMs = 0.0, runMs = 0.0;
+    };
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::deque<job> _jobs;
+    bool _stopping = false;
+    accumulator _accumulators[JOB_TYPES];
+
+    std::function<void()> _makeCurrent;
+    std::function<void()> _release;
+    std::thread _thread;
+
+    void enqueue(job j);
+
+    // fn(bytes) returns the object and may correct the byte count once it knows it
+    template<typename T, typename Fn>
+    load_ticket<T> submitSized(job_type type, size_t bytes, Fn fn);
+
+    void workerMain(std::promise<void>& started);
+
+};
+
+template<typename T, typename Fn>
+load_ticket<T> loader_context::submit(job_type type, Fn fn, size_t bytes) {
+    return submitSized<T>(type, bytes, [fn = std::move(fn)] (size_t&) mutable {
+        return fn();
+    });
+}
+
+template<typename T, typename Fn>
+load_ticket<T> loader_context::submitSized(job_type type, size_t bytes, Fn fn) {
+    auto state = std::make_shared<detail::typed_load_state<T>>();
+    detail::typed_load_state<T>* pState = state.get();
+    job j;
+    j.type = type;
+    j.bytes = bytes;
+    j.state = state;
+    j.run = [pState, fn = std::move(fn)] (size_t& jobBytes) mutable {
+        pState->object = fn(jobBytes);
+    };
+    enqueue(std::move(j));
+    return load_ticket<T>(std::move(state));
+}
+
+}  // namespace ogu
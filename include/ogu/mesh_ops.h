@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "buffer.h"
+
+
+namespace ogu {
+
+// CPU-side preparation of indexed triangle meshes before they go into buffers: vertex welding,
+// post-transform vertex cache ordering (Forsyth or Tipsify), overdraw-aware cluster ordering (Sander
+// et al.) and vertex fetch ordering. optimizeMeshes() runs whole meshes on several threads; the
+// individual passes are single-threaded. No GL calls except in uploadMesh().
+namespace mesh_ops {
+
+// Interleaved vertices with a triangle list. Positions are three floats at positionOffset in each vertex,
+// only welding with an epsilon and overdraw ordering read them.
+struct mesh {
+    std::vector<uint8_t> vertices;
+    uint32_t stride = 0;
+    uint32_t positionOffset = 0;
+    std::vector<uint32_t> indices;
+
+    inline size_t vertexCount() const {
+        return stride ? vertices.size() / stride : 0;
+    }
+};
+
+// Post-transform cache behaviour of an index order, simulated with a FIFO cache
+struct cache_stats {
+    float acmr;  // vertex shader invocations per triangle, 0.5 at best for large regular meshes, 3 at worst
+    float atvr;  // vertex shader invocations per referenced vertex, 1 at best
+};
+
+cache_stats analyzeVertexCache(const uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = 16);
+
+// Merges vertices whose bytes are identical, or with epsilon > 0 whose positions snap to the same
+// point of an epsilon grid and whose other bytes are identical. Triangles that become degenerate are
+// dropped and the vertex data is compacted, keeping the first of each merged set in its original order.
+// Returns the number of vertices removed.
+size_t weldVertices(mesh& m, float epsilon = 0.0f);
+
+enum class cache_algorithm {
+    FORSYTH,  // Forsyth's linear-speed optimiser, models a 32-entry LRU cache whatever cacheSize is
+    TIPSIFY  // Sander et al., tuned for a cacheSize FIFO, faster and leaves better overdraw clusters
+};
+
+// Reorders the triangles for the post-transform vertex cache
+void optimizeVertexCache(uint32_t* pIndices, size_t indexCount, size_t vertexCount,
+    cache_algorithm algorithm = cache_algorithm::TIPSIFY, uint32_t cacheSize = 16);
+
+// Reorders the triangles of a cache-optimised mesh in clusters, outward facing clusters first, so
+// early depth tests reject more from any view. A cluster is cut where the cache order restarts cold
+// and again wherever its running ACMR is within threshold of the whole cluster's, so the vertex cache
+// loses at most a factor of threshold.
+void optimizeOverdraw(mesh& m, uint32_t cacheSize = 16, float threshold = 1.05f);
+
+// Reorders the vertices in the order the indices first use them, so the vertex fetch reads memory
+// sequentially. Unreferenced vertices are dropped.
+void optimizeVertexFetch(mesh& m);
+
+struct optimize_options {
+    bool weld = true;
+    float weldEpsilon = 0.0f;
+    cache_algorithm algorithm = cache_algorithm::TIPSIFY;
+    uint32_t cacheSize = 16;
+    bool overdraw = true;
+    float overdrawThreshold = 1.05f;
+    bool fetch = true;
+};
+
+struct optimize_report {
+    cache_stats before, after;
+    size_t verticesBefore, verticesAfter;
+    size_t trianglesBefore, trianglesAfter;
+};
+
+// Runs the enabled passes in order: weld, vertex cache, overdraw, vertex fetch
+optimize_report optimizeMesh(mesh& m, const optimize_options& options = {});
+
+// optimizeMesh() on every mesh, one mesh per worker at a time. threads 0 for hardware_concurrency().
+std::vector<optimize_report> optimizeMeshes(std::vector<mesh>& meshes, const optimize_options& options = {},
+    uint32_t threads = 0);
+
+// GPU copies of a mesh. Pass vertices with the mesh stride to a vertex_buffer_binding and bind indices
+// to GL_ELEMENT_ARRAY_BUFFER; indices are 16-bit when the vertex count allows.
+struct mesh_buffers {
+    buffer vertices;
+    buffer indices;
+    GLenum indexType;
+    uint32_t indexCount;
+    uint32_t vertexCount;
+    uint32_t stride;
+};
+
+// Immutable buffers holding the mesh, storageFlags are passed to glBufferStorage.
+// Throws std::invalid_argument for an empty mesh.
+mesh_buffers uploadMesh(const mesh& m, GLbitfield storageFlags = 0);
+
+}  // namespace mesh_ops
+}  // namespace ogu
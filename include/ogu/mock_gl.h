@@ -0,0 +1,132 @@
+#pragma once
+
+#include "gl_dispatch.h"
+
+#ifndef OGU_GL_DISPATCH
+#error "mock_gl needs the GL dispatch table, configure with -DOGU_MOCK_GL=ON"
+#endif
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "init.h"
+
+
+namespace ogu {
+
+enum class gl_entry_point : uint32_t {
+#define OGU_GL_ENTRY_POINT(name) name,
+    OGU_GL_FUNCTIONS(OGU_GL_ENTRY_POINT)
+#undef OGU_GL_ENTRY_POINT
+    COUNT
+};
+
+// Stand-in GL backend for tests and call-count benchmarks on machines without a GPU.
+// While a mock_gl exists it owns the dispatch table: every call is counted per entry point and
+// optionally recorded with its arguments. Object names come from a counter, buffer storage lives in
+// host memory so that mapping works, and queries report success (shaders compile, programs link,
+// fences are already signaled, query
+// results are available at once and timestamps advance 1us per read). Only one can exist at a time, and it isn't thread-safe.
+class mock_gl {
+
+    friend struct mock_gl_backend;
+
+public:
+
+    struct call {
+        gl_entry_point entryPoint;
+        uint32_t argCount;
+        uint64_t args[16];  // integers and enums by value, pointers as addresses, floats as their bits
+    };
+
+    struct object_counts {
+        size_t buffers;
+        size_t textures;
+        size_t vertexArrays;
+        size_t shaders;
+        size_t programs;
+        size_t syncs;
+        size_t queries;
+    };
+
+    // Installs the mock and sets the features the library will see
+    explicit mock_gl(const features& f = {});
+
+    // Restores the previous dispatch table
+    ~mock_gl();
+
+    mock_gl(const mock_gl&) = delete;
+
+    mock_gl& operator=(const mock_gl&) = delete;
+
+    static mock_gl& current();
+
+    static const char* name(gl_entry_point entryPoint);
+
+    inline uint64_t count(gl_entry_point entryPoint) const {
+        return _counts[(size_t) entryPoint];
+    }
+
+    // By full name, e.g. "glBindBuffer"
+    uint64_t count(const std::string& name) const;
+
+    uint64_t totalCalls() const;
+
+    inline const std::vector<call>& calls() const {
+        return _calls;
+    }
+
+    // Keep counting but stop storing calls, for long benchmark runs
+    inline void setRecording(bool recording) {
+        _recording = recording;
+    }
+
+    // Clears counts and recorded calls, simulated objects are kept
+    void reset();
+
+    object_counts liveObjects() const;
+
+    // Value returned by glGetIntegerv, 0 for anything not set. Offset alignments default to 256 and
+    // GL_MAX_VERTEX_ATTRIB_RELATIVE_OFFSET to 2047, the worst cases GL allows.
+    void setInteger(GLenum pname, GLint value);
+
+    // What GL_COMPLETION_STATUS_KHR reports for shaders and programs, true by default. False keeps
+    // compiles and links in flight for code that polls them with parallelShaderCompile.
+    inline void setCompletionStatus(bool complete) {
+        _complete = complete;
+    }
+
+    // Host copy of a buffer's storage, nullptr if the name isn't a buffer with storage
+    const std::vector<uint8_t>* bufferStorage(GLuint buffer) const;
+
+private:
+
+    gl::dispatch_table _previous;
+    features _previousFeatures;
+
+    bool _recording = true;
+    bool _complete = true;
+    std::array<uint64_t, (size_t) gl_entry_point::COUNT> _counts {};
+    std::vector<call> _calls;
+
+    GLuint _nextName = 1;
+    std::unordered_map<GLuint, std::vector<uint8_t>> _buffers;
+    std::unordered_map<GLenum, GLuint> _boundBuffers;
+    std::unordered_set<GLuint> _textures;
+    std::unordered_set<GLuint> _vertexArrays;
+    std::unordered_set<GLuint> _shaders;
+    std::unordered_set<GLuint> _programs;
+    std::unordered_set<uintptr_t> _syncs;
+    std::unordered_set<GLuint> _queries;
+    GLuint64 _gpuClock = 0;
+    std::unordered_map<GLenum, GLint> _integers;
+
+    void record(gl_entry_point entryPoint, const uint64_t* pArgs, uint32_t argCount);
+
+};
+
+}  // namespace ogu
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+#include "shader.h"
+
+
+namespace ogu {
+
+// A program whose compile and link have been issued but not waited on.
+// Creating many of these up front lets the driver work on them all at once (in the background with
+// KHR_parallel_shader_compile), the info logs are only checked once the program is asked for.
+class pending_program {
+private:
+
+    std::vector<GLuint> _shaders;
+    GLuint _program;
+
+    void release();
+
+public:
+
+    explicit pending_program(const std::vector<shader_source>& stages);
+
+    pending_program(pending_program&& p);
+
+    ~pending_program();
+
+    pending_program(const pending_program&) = delete;
+
+    pending_program& operator=(const pending_program&) = delete;
+    pending_program& operator=(pending_program&&) = delete;
+
+    // Non-blocking with parallel shader compile, otherwise always true since finding out would block
+    bool ready() const;
+
+    // Waits for the link if needed and returns the program, throwing with the info log on failure.
+    // Can only be called once.
+    shader_program get();
+
+    // Hint for the number of background compiler threads, if parallel shader compile is available
+    static void setMaxCompilerThreads(GLuint count);
+
+};
+
+}  // namespace ogu
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "shader.h"
+
+
+namespace ogu {
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+// Entries are keyed by a hash of the stage types, the source strings and the driver's
+// vendor/renderer/version strings, so a driver update just causes misses. A binary the driver
+// rejects falls back to a full compile, which then replaces the cache entry.
+class program_cache {
+public:
+
+    struct stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t rejected;  // binaries found on disk that the driver didn't accept, also counted as misses
+        double secondsSaved;  // compile time recorded with each hit entry, less the time to load it
+    };
+
+    // @param directory must already exist
+    explicit program_cache(const std::string& directory);
+
+    program_cache(const program_cache&) = delete;
+
+    program_cache& operator=(const program_cache&) = delete;
+
+    // Returns the linked program, from the cache if possible
+    shader_program load(const std::vector<shader_source>& stages);
+
+    inline const stats& getStats() const {
+        return _stats;
+    }
+
+    // The cache key for a set of stages on the current driver
+    uint64_t key(const std::vector<shader_source>& stages) const;
+
+private:
+
+    std::string _directory;
+    std::string _driverId;
+    bool _binariesSupported;
+
+    stats _stats {};
+
+    std::string entryPath(uint64_t key) const;
+
+    // Returns 0 on a miss, with rejected set if an entry existed but the driver didn't accept it
+    GLuint loadBinary(uint64_t key, double& recordedSeconds, bool& rejected) const;
+
+    void storeBinary(uint64_t key, GLuint program, double compileSeconds) const;
+
+};
+
+}  // namespace ogu
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "gl_dispatch.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "uniform.h"
+
+
+namespace ogu {
+
+// Everything active in a linked program, queried once at link time so that later lookups and layout
+// checks don't need to go back to the driver. Tables are flat arrays of PODs sorted by name hash,
+// names live in one shared string pool.
+class program_reflection {
+public:
+
+    struct variable {
+        uint64_t nameHash;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        GLenum type;
+        GLint arraySize;
+        GLint location;  // -1 for block members
+        GLint offset;  // -1 outside of blocks
+        GLint arrayStride;
+        GLint matrixStride;
+    };
+
+    struct block {
+        uint64_t nameHash;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        GLuint index;
+        GLint dataSize;
+        // range of blockMembers(), sorted by offset
+        uint32_t firstMember;
+        uint32_t memberCount;
+    };
+
+    program_reflection() = default;
+
+    explicit program_reflection(GLuint program);
+
+    inline const std::vector<variable>& uniforms() const {
+        return _uniforms;
+    }
+
+    inline const std::vector<block>& uniformBlocks() const {
+        return _uniformBlocks;
+    }
+
+    inline const std::vector<block>& storageBlocks() const {
+        return _storageBlocks;
+    }
+
+    inline const std::vector<variable>& inputs() const {
+        return _inputs;
+    }
+
+    const variable* members(const block& b) const {
+        return _blockMembers.data() + b.firstMember;
+    }
+
+    inline std::string name(const variable& v) const {
+        return _names.substr(v.nameOffset, v.nameLength);
+    }
+
+    inline std::string name(const block& b) const {
+        return _names.substr(b.nameOffset, b.nameLength);
+    }
+
+    // Default-block uniforms. Arrays can be found with or without the "[0]" suffix. nullptr if not active.
+    const variable* findUniform(const std::string& name) const;
+    const variable* findUniform(uniform_name name) const;
+
+    const block* findUniformBlock(const std::string& name) const;
+    const block* findStorageBlock(const std::string& name) const;
+
+    const variable* findInput(const std::string& name) const;
+
+private:
+
+    std::string _names;
+
+    std::vector<variable> _uniforms;
+    std::vector<block> _uniformBlocks;
+    std::vector<block> _storageBlocks;
+    std::vector<variable> _blockMembers;
+    std::vector<variable> _inputs;
+
+    uint32_t addName(const char* name, uint32_t length);
+
+    void reflectInterfaceQuery(GLuint program);
+    void reflectLegacy(GLuint program);
+
+    void sortTables();
+
+    template<typename T>
+    const T* find(const std::vector<T>& table, const std::string& name) const;
+
+};
+
+}  // namespace ogu
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace ogu {
+
+// Skyline bottom-left rectangle packer: the packed area is described by its top edge, a list of
+// horizontal segments, and each rectangle goes where its top ends up lowest (ties go to the
+// narrowest segment). Rectangles can't be removed individually, reset() and pack again instead.
+// CPU only, no GL calls, so it can run on any thread.
+class skyline_packer {
+public:
+
+    struct rect {
+        uint32_t x, y;
+        uint32_t width, height;
+    };
+
+    skyline_packer(uint32_t width, uint32_t height);
+
+    // Returns false if the rectangle doesn't fit anywhere, out is left alone then
+    bool insert(uint32_t width, uint32_t height, rect& out);
+
+    void reset();
+
+    inline uint32_t width() const {
+        return _width;
+    }
+
+    inline uint32_t height() const {
+        return _height;
+    }
+
+    // Area of the rectangles inserted since the last reset()
+    inline size_t usedArea() const {
+        return _usedArea;
+    }
+
+    inline float occupancy() const {
+        return (float) _usedArea / ((float) _width * (float) _height);
+    }
+
+private:
+
+    struct segment {
+        uint32_t x, y, width;
+    };
+
+    uint32_t _width, _height;
+    size_t _usedArea = 0;
+    std::vector<segment> _skyline;  // sorted by x, covering the whole width
+
+    // y the rectangle would sit at if its left edge were at segment i, false if it doesn't fit there
+    bool fit(size_t i, uint32_t width, uint32_t height, uint32_t& y) const;
+
+};
+
+}  // namespace ogu
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "gl_dispatch.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "shader.h"
+#include "texture.h"
+#include "uniform.h"
+#include "vertex_array.h"
+
+
+namespace ogu {
+
+enum class command_type : uint32_t {
+    BIND_PROGRAM,
+    BIND_VERTEX_ARRAY,
+    BIND_TEXTURE,
+    SET_UNIFORM,
+    DRAW_ELEMENTS,
+    DRAW_ARRAYS
+};
+
+// Command payloads. Everything is POD so command buffers can be reset without running destructors.
+namespace commands {
+
+struct header {
+    command_type type;
+    uint32_t size;  // of the payload following the header
+};
+
+struct bind_program {
+    const shader_program* program;
+};
+
+struct bind_vertex_array {
+    const vertex_array* vertexArray;
+};
+
+struct bind_texture {
+    const Texture* texture;
+    uint32_t unit;
+};
+
+// Followed by valueSize bytes of the value
+struct set_uniform {
+    void (*set)(GLuint program, GLint location, const void* pValue);
+    GLuint program;
+    GLint location;
+    uint32_t valueSize;
+};
+
+struct draw_elements {
+    GLenum mode;
+    GLsizei count;
+    GLenum indexType;
+    GLsizei instanceCount;
+    GLint baseVertex;
+    uintptr_t indexOffset;  // in bytes into the element array buffer
+};
+
+struct draw_arrays {
+    GLenum mode;
+    GLint first;
+    GLsizei count;
+    GLsizei instanceCount;
+};
+
+}  // namespace commands
+
+// Commands recorded by one thread, without any GL calls. Memory comes from a linear allocator of
+// fixed-size chunks that is kept across reset(), so a buffer reused every frame stops allocating.
+// Commands with equal sort keys are replayed in recording order, so record a draw and the state
+// changes it depends on under the same key.
+class command_buffer {
+public:
+
+    struct entry {
+        uint64_t key;
+        const commands::header* pCommand;
+    };
+
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    command_buffer() = default;
+
+    command_buffer(command_buffer&&) = default;
+
+    command_buffer& operator=(command_buffer&&) = default;
+
+    command_buffer(const command_buffer&) = delete;
+
+    command_buffer& operator=(const command_buffer&) = delete;
+
+    void bindProgram(uint64_t key, const shader_program& program);
+
+    void bindVertexArray(uint64_t key, const vertex_array& vertexArray);
+
+    void bindTexture(uint64_t key, uint32_t unit, const Texture& texture);
+
+    // The value is copied. Without direct state access, replay makes the uniform's program current
+    // and leaves it so, so record uniforms for the program of the draws that follow them.
+    template<typename T>
+    void setUniform(uint64_t key, const uniform<T>& u, const T& value);
+
+    void drawElements(uint64_t key, GLenum mode, GLsizei count, GLenum indexType, uintptr_t indexOffset = 0,
+        GLsizei instanceCount = 1, GLint baseVertex = 0);
+
+    void drawArrays(uint64_t key, GLenum mode, GLint first, GLsizei count, GLsizei instanceCount = 1);
+
+    inline const std::vector<entry>& entries() const {
+        return _entries;
+    }
+
+    inline size_t bytesUsed() const {
+        return _bytesUsed;
+    }
+
+    // Forget all commands, keeping the memory
+    void reset();
+
+private:
+
+    std::vector<std::unique_ptr<uint8_t[]>> _chunks;
+    size_t _chunk = 0;
+    size_t _chunkHead = 0;
+    size_t _bytesUsed = 0;
+
+    std::vector<entry> _entries;
+
+    // Header and payload in one allocation, returns the payload
+    void* record(uint64_t key, command_type type, size_t payloadSize);
+
+};
+
+// Merges command buffers submitted by any number of threads and replays them in sort key order
+// on the thread that owns the GL context, through the usual wrappers (and so through state_cache).
+class render_queue {
+public:
+
+    struct stats {
+        uint64_t commands;
+        uint64_t buffers;
+        uint64_t bytes;
+    };
+
+    render_queue() = default;
+
+    render_queue(const render_queue&) = delete;
+
+    render_queue& operator=(const render_queue&) = delete;
+
+    // An empty command buffer, recycled from an earlier execute() if possible. Thread-safe.
+    command_buffer acquire();
+
+    // Hand a recorded buffer over for the next execute(). Thread-safe.
+    void submit(command_buffer&& commands);
+
+    // Sorts everything submitted so far by key (stable, so buffers submitted earlier win ties) and
+    // replays it. Call on the render thread.
+    void execute();
+
+    inline const stats& lastStats() const {
+        return _lastStats;
+    }
+
+    // LSD radix sort by key, stable. scratch is resized as needed.
+    static void sort(std::vector<command_buffer::entry>& entries, std::vector<command_buffer::entry>& scratch);
+
+    static void replay(const commands::header& command);
+
+private:
+
+    std::mutex _mutex;
+    std::vector<command_buffer> _submitted;
+    std::vector<command_buffer> _free;
+
+    std::vector<command_buffer::entry> _entries;
+    std::vector<command_buffer::entry> _scratch;
+
+    stats _lastStats {};
+
+};
+
+template<typename T>
+void command_buffer::setUniform(uint64_t key, const uniform<T>& u, const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "uniform values are copied into the command buffer");
+    auto* pCommand = (commands::set_uniform*) record(key, command_type::SET_UNIFORM,
+        sizeof(commands::set_uniform) + sizeof(T));
+    pCommand->set = [] (GLuint program, GLint location, const void* pValue) {
+        T v;
+        std::memcpy(&v, pValue, sizeof(T));
+        uniform<T>(program, location).set(v);
+    };
+    pCommand->program = u.program();
+    pCommand->location = u.location();
+    pCommand->valueSize = (uint32_t) sizeof(T);
+    std::memcpy(pCommand + 1, &value, sizeof(T));
+}
+
+}  // namespace ogu
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer.h"
+#include "texture.h"
+
+
+namespace ogu {
+
+// Keeps the estimated GPU memory of textures and buffers under a budget. Managed textures are
+// created through a source callback and go through bind() here, which records when each was last
+// used; update() then evicts the least recently bound ones while over budget, first by recreating
+// them without their top mip levels and then by releasing them entirely. An evicted texture is
+// reloaded from its source the next time it's bound, and reduced ones get their levels back in later
+// update()s once there's room. Buffers and unmanaged textures can be tracked so they count against
+// the budget, but they're never evicted. Render thread only.
+class residency_manager {
+public:
+
+    using texture_id = uint32_t;
+
+    static constexpr texture_id INVALID_TEXTURE = ~0u;
+
+    // Creates the texture with its top droppedLevels levels left out, i.e. level 0 of the result is
+    // level droppedLevels of the full texture. Called whenever the texture is (re)loaded.
+    using texture_source = std::function<std::unique_ptr<Texture>(uint32_t droppedLevels)>;
+
+    // As reported by the driver, see queryDriverMemory()
+    struct driver_memory {
+        size_t totalBytes;  // 0 if the driver doesn't say
+        size_t availableBytes;
+    };
+
+    struct stats {
+        size_t budgetBytes;
+        size_t textureBytes;  // resident managed textures
+        size_t trackedBytes;  // tracked buffers and unmanaged textures
+        size_t texturesResident;
+        size_t texturesReduced;  // resident without some top levels
+        size_t texturesEvicted;
+        uint64_t levelDrops;  // evictions that kept the texture but dropped levels
+        uint64_t releases;  // evictions that released the whole texture
+        uint64_t reloads;  // source calls, including restoring dropped levels
+        uint64_t overBudgetFrames;  // update()s that couldn't get under budget
+    };
+
+    // @param maxReloadsPerFrame how many reduced textures update() may restore per call, so restoring
+    //        levels doesn't hitch a frame; reloads of released textures that get bound aren't limited
+    explicit residency_manager(size_t budgetBytes, uint32_t maxReloadsPerFrame = 4);
+
+    residency_manager(const residency_manager&) = delete;
+
+    residency_manager& operator=(const residency_manager&) = delete;
+
+    // @param maxDroppedLevels how many top levels eviction may drop before releasing the whole texture
+    // @param loadNow load the texture right away rather than on its first bind()
+    texture_id addTexture(texture_source source, uint32_t maxDroppedLevels = ~0u, bool loadNow = true);
+
+    // Releases the texture, the id can be handed out again afterwards
+    void removeTexture(texture_id id);
+
+    // Binds the texture, loading it first if it was released. Returns the texture currently backing
+    // the id, which changes whenever it's reloaded, so don't hold on to it across update() calls.
+    Texture* bind(texture_id id, uint32_t unit);
+
+    // The texture currently backing the id without marking it used, nullptr while it's released
+    Texture* get(texture_id id) const;
+
+    // Levels left out of the currently resident texture, 0 when it's complete
+    uint32_t droppedLevels(texture_id id) const;
+
+    // Count the object against the budget until untracked, it must stay alive until then.
+    // Unmanaged textures are measured at each update(), so they may be respecified while tracked.
+    void track(const buffer& b);
+    void untrack(const buffer& b);
+    void track(const Texture& t);
+    void untrack(const Texture& t);
+
+    inline void setBudget(size_t budgetBytes) {
+        _budget = budgetBytes;
+    }
+
+    inline size_t getBudget() const {
+        return _budget;
+    }
+
+    // Video memory info from NVX_gpu_memory_info or ATI_meminfo, false if neither is supported
+    static bool queryDriverMemory(driver_memory& out);
+
+    // Sets the budget to what's resident now plus what the driver reports as free, less reserveBytes
+    // left for everything the manager doesn't know about (render targets, the driver itself).
+    // Returns false and leaves the budget alone if the driver can't report free memory.
+    bool calibrate(size_t reserveBytes);
+
+    // Call once per frame, after the frame's binds: evicts least recently bound textures while over
+    // budget, then restores levels of reduced textures that were used if there's room for them.
+    // Textures bound since the previous update() are only evicted if nothing else is left.
+    void update();
+
+    stats getStats() const;
+
+private:
+
+    struct entry {
+        texture_source source;
+        std::unique_ptr<Texture> texture;
+        uint32_t maxDroppedLevels;
+        uint32_t droppedLevels;  // of the resident texture, or to reload at once released
+        uint64_t lastUsed;
+        size_t bytes;
+        bool active;
+    };
+
+    std::vector<entry> _entries;
+    std::vector<texture_id> _freeIds;
+    std::unordered_map<const buffer*, size_t> _buffers;
+    std::vector<const Texture*> _textures;
+
+    size_t _budget;
+    uint32_t _maxReloadsPerFrame;
+    uint64_t _frame = 1;
+
+    size_t _textureBytes = 0;
+    size_t _bufferBytes = 0;
+
+    uint64_t _levelDrops = 0;
+    uint64_t _releases = 0;
+    uint64_t _reloads = 0;
+    uint64_t _overBudgetFrames = 0;
+
+    size_t trackedBytes() const;
+
+    void load(entry& e, uint32_t droppedLevels);
+
+    void release(entry& e);
+
+    // Bytes freed by evicting e as far as needed to free want bytes, or fully if that's not enough
+    size_t evict(entry& e, size_t want);
+
+};
+
+}  // namespace ogu
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <GL/glew.h>
+#include "gl_dispatch.h"
 
 #include <cstdint>
 #include <string>
@@ -8,6 +8,10 @@
 #include <vector>
 
 #include "buffer.h"
+#include "instrumentation.h"
+#include "program_reflection.h"
+#include "state_cache.h"
+#include "uniform.h"
 
 
 namespace ogu {
@@ -15,6 +19,9 @@ namespace ogu {
 class shader {
 
     friend class shader_program;
+    friend class program_cache;
+    friend class pending_program;
+    friend class shader_reloader;
 
     GLuint handle;
 
@@ -25,6 +32,16 @@ public:
         FRAGMENT = GL_FRAGMENT_SHADER
     };
 
+private:
+
+    // Issues the compile without waiting for it
+    static GLuint compile(const std::vector<std::string>& sources, type type);
+
+    // Throws with the info log if the shader didn't compile, deleting it first
+    static void checkCompileStatus(GLuint shader);
+
+public:
+
     shader(const std::vector<std::string>& sources, type type);
     shader(shader&&);
 
@@ -32,7 +49,18 @@ public:
 
 };
 
+// Sources for one stage of a program, for APIs that compile shaders themselves
+struct shader_source {
+    std::vector<std::string> sources;
+    shader::type type;
+};
+
 class shader_program {
+
+    friend class program_cache;
+    friend class pending_program;
+    friend class shader_reloader;
+
 private:
 
     GLuint handle;
@@ -45,36 +73,102 @@ private:
     std::unordered_map<std::string, GLint> uniformLocations;
     std::unordered_map<std::string, ubo_entry> uniformBufferIndices;
 
+    // Same locations keyed by the FNV-1a hash of the name, sorted by hash, for uniform_name lookups
+    std::vector<std::pair<uint64_t, GLint>> uniformHashes;
+
     GLuint num_ubo_bindings = 0;
 
+    program_reflection reflection;
+
+    // Takes ownership of an already linked program
+    explicit shader_program(GLuint handle);
+
+    // Links the shaders into a new program, throwing with the info log on failure
+    static GLuint link(const shader* const* pShaders, size_t count, bool binaryRetrievable);
+
+    // Throws with the info log if the program didn't link, deleting it first
+    static void checkLinkStatus(GLuint program);
+
+    // Switches to a newly linked program with the same interface, deleting the old one. Registered
+    // uniforms and uniform blocks are looked up again, block bindings reapplied and the values of
+    // registered non-array uniforms of the same type copied over.
+    void replaceHandle(GLuint program);
+
 public:
 
     explicit shader_program(const std::initializer_list<shader>& shaders);
 
+    shader_program(shader_program&& p);
+
     ~shader_program();
 
     inline void use() const {
-        glUseProgram(handle);
+        state_cache::current().useProgram(handle);
     }
 
     void addUniform(const std::string& name);
 
+    // Registers the uniform and returns a handle for setting it without any lookup
+    template<typename T>
+    inline uniform<T> addUniform(const std::string& name);
+
     void addUniformBuffer(const std::string& name);
 
     // Non-arithmetic types (eg vector and matrix types) are passed by-const-reference
-    // template<typename T, std::enable_if_t<!std::is_arithmetic<T>::value, bool> = true>
-    // void setUniform(const std::string& name, const T& value) const;
+    template<typename T, std::enable_if_t<!std::is_arithmetic<T>::value, bool> = true>
+    inline void setUniform(const std::string& name, const T& value) const;
 
     // Arithmetic types are passed by-value
     template<typename T, std::enable_if_t<std::is_arithmetic<T>::value, bool> = true>
     void setUniform(const std::string& name, T value) const;
 
+    // Lookup by compile-time hashed name, e.g. setUniform("color"_uniform, value)
+    template<typename T>
+    inline void setUniform(uniform_name name, const T& value) const;
+
     GLint getUniformLocation(const std::string& name) const;
 
+    GLint getUniformLocation(uniform_name name) const;
+
+    // All active uniforms, blocks and inputs, queried when the program was linked
+    inline const program_reflection& getReflection() const {
+        return reflection;
+    }
+
+    template<typename T>
+    inline uniform<T> getUniform(const std::string& name) const {
+        return uniform<T>(handle, getUniformLocation(name));
+    }
+
+    template<typename T>
+    inline uniform<T> getUniform(uniform_name name) const {
+        return uniform<T>(handle, getUniformLocation(name));
+    }
+
     void bindUniformBuffer(const std::string& name, const buffer& buffer, intptr_t offset, size_t size) const;
 
     void bindUniformBuffer(const std::string& name, const buffer& buffer) const;
 
+    void bindUniformBuffer(const std::string& name, const buffer_range& range) const;
+
 };
 
+template<typename T>
+uniform<T> shader_program::addUniform(const std::string& name) {
+    addUniform(name);
+    return getUniform<T>(name);
+}
+
+template<typename T, std::enable_if_t<!std::is_arithmetic<T>::value, bool>>
+void shader_program::setUniform(const std::string& name, const T& value) const {
+    OGU_COUNT_CALL(UNIFORM);
+    uniform_traits<T>::set(uniformLocations.at(name), value);
+}
+
+template<typename T>
+void shader_program::setUniform(uniform_name name, const T& value) const {
+    OGU_COUNT_CALL(UNIFORM);
+    uniform_traits<T>::set(getUniformLocation(name), value);
+}
+
 }  // namespace ogu
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "shader.h"
+
+
+namespace ogu {
+
+// Turns a GLSL file with #include directives into one source string for shader / shader_source.
+// Quoted includes are looked up next to the including file first, then in the include directories;
+// angled ones only in the include directories. A file with #pragma once or a classic
+// #ifndef / #define / #endif guard is only included once per program. #define lines given to process()
+// go right after #version, and #line directives keep compiler messages pointing at the original
+// files: "n:line" refers to result::dependencies[n].
+// Parsed files are cached by path and modification time with a hash of their contents, and whole
+// results by path and defines, so building the same program again reads no files and builds no strings.
+// Thread-safe.
+class shader_preprocessor {
+public:
+
+    using define_list = std::vector<std::pair<std::string, std::string>>;
+
+    struct dependency {
+        std::string path;
+        uint64_t hash;  // FNV-1a of the file contents
+    };
+
+    struct result {
+        std::string source;
+        uint64_t hash;  // FNV-1a of source, for downstream caches to key on
+
+        // Every file read, the root file first, numbered as in the #line directives
+        std::vector<dependency> dependencies;
+
+        inline shader_source toShaderSource(shader::type type) const {
+            return { { source }, type };
+        }
+    };
+
+    struct stats {
+        uint64_t fileReads;
+        uint64_t fileHits;  // parsed files reused, including ones whose timestamp changed but contents didn't
+        uint64_t builds;
+        uint64_t resultHits;
+    };
+
+    // With checkTimestamps false cached files are trusted until invalidate(), so process() makes no
+    // system calls at all once everything is cached
+    explicit shader_preprocessor(std::vector<std::string> includeDirectories = {}, bool checkTimestamps = true);
+
+    shader_preprocessor(const shader_preprocessor&) = delete;
+
+    shader_preprocessor& operator=(const shader_preprocessor&) = delete;
+
+    // Throws std::runtime_error for unreadable or missing files and circular includes
+    std::shared_ptr<const result> process(const std::string& path, const define_list& defines = {});
+
+    // Drop a file from the cache so the next process() that needs it reads it again, e.g. when a file
+    // watcher reports it changed
+    void invalidate(const std::string& path);
+
+    void invalidateAll();
+
+    stats getStats();
+
+    // Lexically normalized path ('/' separators, no "." or ".." where avoidable), as used for cache keys
+    // and in result::dependencies
+    static std::string normalizePath(const std::string& path);
+
+private:
+
+    struct segment {
+        std::string text;  // empty for an include
+        uint32_t firstLine;
+        std::string include;
+        bool angled;
+        std::string resolved;  // of the include, filled in the first time it's expanded
+    };
+
+    struct parsed_file {
+        std::string path;
+        int64_t modified;
+        int64_t size;
+        uint64_t hash;
+        std::string version;  // the #version line, removed from the text
+        bool once;
+        std::vector<segment> segments;
+    };
+
+    struct expansion {
+        std::unordered_map<std::string, uint32_t> ids;
+        std::vector<std::string> stack;
+        std::vector<std::string> included;
+        std::vector<dependency> dependencies;
+        uint32_t lineOffset;
+    };
+
+    std::vector<std::string> _includeDirectories;
+    bool _checkTimestamps;
+
+    std::mutex _mutex;
+    std::unordered_map<std::string, std::unique_ptr<parsed_file>> _files;
+    std::unordered_map<std::string, std::shared_ptr<const result>> _results;  // by path and defines
+    stats _stats {};
+
+    // The cached parse of a file, re-read first if it changed on disk
+    parsed_file& file(const std::string& path);
+
+    void parse(parsed_file& f, const std::string& text);
+
+    std::string resolve(const parsed_file& from, const segment& s);
+
+    void expand(parsed_file& f, expansion& e, std::string& out);
+
+};
+
+}  // namespace ogu
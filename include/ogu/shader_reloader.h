@@ -0,0 +1,147 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shader.h"
+#include "shader_preprocessor.h"
+
+
+namespace ogu {
+
+// Hot reload for programs built from shader files. It knows which files each stage was built from
+// (includes too, through the shader_preprocessor) and watches their directories with inotify on Linux,
+// or polls their timestamps elsewhere. When a file changes, only the stages that use it are
+// preprocessed and compiled again; the other stages' compiled shaders are kept and attached to the new
+// link. Compiles and links are issued without waiting and only checked once done (in the background
+// with KHR_parallel_shader_compile). The program object handed out stays the same: it switches to the
+// new GL program in one step, keeping its registered uniforms and uniform blocks (see
+// shader_program::replaceHandle). If anything fails the old program stays in use and lastError() says why.
+// Render thread only. uniform<T> handles taken from a program go stale on reload, take them again in
+// the reload callback.
+class shader_reloader {
+public:
+
+    struct stage {
+        std::string path;
+        shader::type type;
+    };
+
+    using reload_callback = std::function<void(shader_program&)>;
+
+    struct stats {
+        uint64_t fileEvents;
+        uint64_t reloads;
+        uint64_t failures;
+        uint64_t stagesCompiled;
+        uint64_t stagesReused;  // kept from the previous version of a reloaded program
+        double lastReloadMs;  // from noticing the change to the swap
+    };
+
+    // The preprocessor reads every file and must outlive the reloader. pollInterval is only used
+    // where inotify isn't available, and polling needs a preprocessor that checks timestamps.
+    explicit shader_reloader(shader_preprocessor& preprocessor,
+        std::chrono::milliseconds pollInterval = std::chrono::milliseconds(250));
+
+    ~shader_reloader();
+
+    shader_reloader(const shader_reloader&) = delete;
+
+    shader_reloader& operator=(const shader_reloader&) = delete;
+
+    // Builds the program now, throwing like shader_program on errors, and keeps it up to date from then
+    // on. The reference stays valid until unload() or the reloader is destroyed.
+    shader_program& load(const std::vector<stage>& stages, const shader_preprocessor::define_list& defines = {},
+        reload_callback onReload = nullptr);
+
+    void unload(const shader_program& program);
+
+    // Once per frame: picks up file changes, starts rebuilding affected programs and swaps in the ones
+    // whose link has finished. Returns the number of programs swapped.
+    size_t update();
+
+    // Why the latest change to the program didn't make it in, empty if it did
+    const std::string& lastError(const shader_program& program) const;
+
+    // False when falling back to polling timestamps
+    inline bool watching() const {
+        return _inotify >= 0;
+    }
+
+    inline const stats& getStats() const {
+        return _stats;
+    }
+
+private:
+
+    using clock = std::chrono::steady_clock;
+
+    struct stage_state {
+        stage source;
+        GLuint shader;
+        uint64_t hash;  // of the preprocessed source
+        std::vector<std::string> dependencies;
+    };
+
+    // A rebuild whose compiles and link have been issued
+    struct pending_link {
+        GLuint program;
+        std::vector<std::pair<size_t, stage_state>> replaced;  // stage index, new state
+        clock::time_point noticed;
+    };
+
+    struct entry {
+        std::unique_ptr<shader_program> program;
+        std::vector<stage_state> stages;
+        shader_preprocessor::define_list defines;
+        reload_callback onReload;
+        std::unique_ptr<pending_link> pending;
+        std::string lastError;
+    };
+
+    shader_preprocessor& _preprocessor;
+    std::vector<std::unique_ptr<entry>> _entries;
+
+    // file -> entries with a stage that reads it
+    std::unordered_map<std::string, std::vector<entry*>> _dependents;
+
+    int _inotify = -1;
+    std::unordered_map<int, std::string> _watchDirectories;  // watch descriptor -> directory with '/'
+    std::unordered_map<std::string, int> _watches;
+
+    std::chrono::milliseconds _pollInterval;
+    clock::time_point _lastPoll;
+
+    stats _stats {};
+
+    entry& find(const shader_program& program) const;
+
+    stage_state compileStage(const stage& s, const shader_preprocessor::define_list& defines);
+
+    void track(entry& e);
+    void untrack(entry& e);
+
+    void watchDirectory(const std::string& directory);
+
+    // Changed files since the last call
+    std::vector<std::string> readEvents();
+
+    void rebuild(entry& e, const std::vector<std::string>& changed, clock::time_point noticed);
+
+    // true if the pending link finished, successfully or not
+    bool finishPending(entry& e);
+
+    static void discard(pending_link& p);
+
+    // Checks the link and, if it failed, the given shaders' compiles. Returns the first info log found,
+    // empty if everything built. Handles deleted by the failing check are zeroed.
+    static std::string checkBuild(GLuint& program, const std::vector<GLuint*>& shaders);
+
+};
+
+}  // namespace ogu
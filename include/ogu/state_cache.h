@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "gl_dispatch.h"
+
+
+namespace ogu {
+
+// Shadow copy of the binding state of the GL context, used by the wrappers to skip binds that
+// wouldn't change anything. There's one cache per thread, since a context is only ever current
+// on one thread; call invalidate() after switching contexts on a thread or after making GL binding
+// calls that don't go through ogu, so the cache doesn't skip binds it shouldn't.
+class state_cache {
+public:
+
+    struct counters {
+        uint64_t issued;
+        uint64_t elided;
+    };
+
+    static state_cache& current();
+
+    void useProgram(GLuint program);
+
+    void bindVertexArray(GLuint vertexArray);
+
+    void bindBuffer(GLenum target, GLuint buffer);
+
+    // Indexed binds are always issued (offset / size aren't tracked) but do update the generic binding
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    void activeTexture(uint32_t unit);
+
+    // Bind to the given texture unit, switching the active unit only if needed
+    void bindTexture(uint32_t unit, GLenum target, GLuint texture);
+
+    // Bind to whichever unit is currently active, e.g. for bind-to-edit
+    void bindTexture(GLenum target, GLuint texture);
+
+    // Objects being deleted are unbound by GL, these keep the cache in sync with that
+    void forgetProgram(GLuint program);
+    void forgetVertexArray(GLuint vertexArray);
+    void forgetBuffer(GLuint buffer);
+    void forgetTexture(GLuint texture);
+
+    // Forget everything, the next bind of each kind will always be issued
+    void invalidate();
+
+    inline const counters& getCounters() const {
+        return _counters;
+    }
+
+    inline void resetCounters() {
+        _counters = {};
+    }
+
+private:
+
+    static constexpr GLuint UNKNOWN = ~0u;
+
+    static constexpr size_t NUM_BUFFER_TARGETS = 14;
+    static constexpr size_t NUM_TEXTURE_TARGETS = 11;
+
+    using texture_unit = std::array<GLuint, NUM_TEXTURE_TARGETS>;
+
+    GLuint _program = UNKNOWN;
+    GLuint _vertexArray = UNKNOWN;
+    std::array<GLuint, NUM_BUFFER_TARGETS> _buffers;
+    uint32_t _activeUnit = UNKNOWN;
+    std::vector<texture_unit> _textureUnits;
+
+    counters _counters {};
+
+    state_cache();
+
+    texture_unit& textureUnit(uint32_t index);
+
+    // returns true if the cached value differs (and updates it), counting the call either way
+    bool update(GLuint& cached, GLuint value);
+
+};
+
+}  // namespace ogu
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "buffer.h"
+
+
+namespace ogu {
+
+// Ring buffer for per-frame dynamic data (vertices, uniforms, ...).
+// The storage is allocated once with glBufferStorage and mapped persistently, then split into
+// numFrames regions. Each frame allocates linearly out of one region, and end_frame() fences
+// that region so it isn't written again until the GPU is done reading it.
+class stream_buffer {
+private:
+
+    buffer _buffer;
+
+    size_t _frameSize;
+    uint32_t _numFrames;
+    bool _coherent;
+
+    uint8_t* _pMapped;
+    std::vector<GLsync> _fences;
+
+    uint32_t _frame = 0;
+    size_t _head = 0;
+
+    uint64_t _fenceWaits = 0;
+
+    void waitForFrame(uint32_t frame);
+
+public:
+
+    struct region {
+        void* pData;
+        intptr_t offset;  // offset from the start of the whole buffer, for bind / draw calls
+        size_t size;
+    };
+
+    // @param coherent if false, the mapping is not GL_MAP_COHERENT_BIT and writes are flushed
+    // explicitly with glFlushMappedBufferRange: write() flushes what it wrote, regions from allocate()
+    // need flush() before any command that reads them is issued
+    stream_buffer(size_t frameSize, uint32_t numFrames = 3, bool coherent = true);
+
+    stream_buffer(stream_buffer&& b);
+
+    ~stream_buffer();
+
+    stream_buffer(const stream_buffer&) = delete;
+
+    stream_buffer& operator=(const stream_buffer&) = delete;
+    stream_buffer& operator=(stream_buffer&&) = delete;
+
+    inline const buffer& getBuffer() const {
+        return _buffer;
+    }
+
+    inline size_t frameSize() const {
+        return _frameSize;
+    }
+
+    inline size_t bytesRemaining() const {
+        return _frameSize - _head;
+    }
+
+    // Number of times end_frame() had to block on a fence because the GPU was still using the next region
+    inline uint64_t fenceWaits() const {
+        return _fenceWaits;
+    }
+
+    // Carve size bytes out of the current frame's region
+    // Throws std::length_error if the region doesn't have enough space left
+    region allocate(size_t size, size_t alignment = 1);
+
+    // Same calling convention as buffer::write, returns the offset of the written data in the buffer
+    template<typename Fn>
+    inline intptr_t write(size_t size, size_t alignment, const Fn& fn);
+
+    // Make writes to an allocated region visible to the GL commands issued after this.
+    // Only needed without coherent mapping, a no-op otherwise.
+    void flush(const region& r) const;
+
+    // Fence the current region and move on to the next one, waiting if the GPU hasn't finished with it
+    void end_frame();
+
+};
+
+template<typename Fn>
+intptr_t stream_buffer::write(size_t size, size_t alignment, const Fn& fn) {
+    region r = allocate(size, alignment);
+    fn(r.pData);
+    flush(r);
+    return r.offset;
+}
+
+}  // namespace ogu
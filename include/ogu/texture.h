@@ -1,6 +1,6 @@
 #pragma once
 
-#include <GL/glew.h>
+#include "gl_dispatch.h"
 
 
 namespace ogu {
@@ -10,8 +10,9 @@ class Texture {
 public:
 
     // i.e, 1D, 2D, 3D but sadly cannot start with a number
+    // 2D arrays keep their layer count in depth, and layers don't shrink with the mip level
     enum Dimension {
-        DIMENSION_1D, DIMENSION_2D, DIMENSION_3D
+        DIMENSION_1D, DIMENSION_2D, DIMENSION_3D, DIMENSION_2D_ARRAY
     };
 
     struct Format {
@@ -30,6 +31,29 @@ public:
         bool hasStencilComponent;
     };
 
+    // Block-compressed formats, all in 4x4 texel blocks. BC needs EXT_texture_compression_s3tc,
+    // RGTC and BPTC (GL 3.0 / 4.2), ETC2 / EAC need GL 4.3 or ES3_compatibility.
+    enum CompressedFormat {
+        BC1_RGB,
+        BC1_RGBA,
+        BC2,
+        BC3,
+        BC4,
+        BC4_SIGNED,
+        BC5,
+        BC5_SIGNED,
+        BC6H_UFLOAT,
+        BC6H_SFLOAT,
+        BC7,
+        ETC2_RGB8,
+        ETC2_RGB8_A1,
+        ETC2_RGBA8,
+        EAC_R11,
+        EAC_R11_SIGNED,
+        EAC_RG11,
+        EAC_RG11_SIGNED
+    };
+
     enum ChannelFormat {
         U8,
         U16,
@@ -64,8 +88,18 @@ public:
 
     // Uninitialized texture, when you know you will call writePixels later (likely with null value to allocate storage)
     Texture(Dimension dimension, DepthFormat format);
+
+    // Uninitialized compressed texture, write it with writeCompressedPixels or allocateStorage + writeCompressedSubPixels.
+    // srgb is only valid for the BC1-3, BC7 and ETC2 formats.
+    Texture(Dimension dimension, CompressedFormat format, bool srgb = false);
+
+    // Bytes per 4x4 block
+    static uint32_t getBlockSize(CompressedFormat format);
+
+    // Levels in the full mip chain down to 1x1. Array layers don't shrink, pass depth 1 for them.
+    static uint32_t fullMipChainLevels(uint32_t width, uint32_t height, uint32_t depth);
     
-    Texture(Texture&& t) { }
+    Texture(Texture&& t);
 
     ~Texture();
 
@@ -78,7 +112,15 @@ public:
     }
 
     inline uint32_t getDepth() const {
-        return height;
+        return depth;
+    }
+
+    inline bool isCompressed() const {
+        return bytesPerBlock != 0;
+    }
+
+    inline GLuint getHandle() const {
+        return handle;
     }
 
     void bind(uint32_t index) const;
@@ -88,9 +130,39 @@ public:
     // @param borderColor should be a pointer to the beginning of an array of 4 floats, or nullptr
     void setEdgeMode(EdgeMode mode, float* borderColor = nullptr) const;
 
+    inline uint32_t getLevels() const {
+        return levels;
+    }
+
+    // Estimated GPU memory: every allocated level at the format's size per texel
+    size_t getMemorySize() const;
+
+    // Estimated GPU memory of a single level, 0 for levels that aren't allocated
+    size_t getLevelMemorySize(uint32_t level) const;
+
+    // Allocate immutable storage with glTexStorage*D, with levels = 0 allocating the full mip chain.
+    // Storage can only be allocated once, after that use writeSubPixels (or writePixels with the same size).
+    void allocateStorage(uint32_t levels, uint32_t width, uint32_t height, uint32_t depth);
+
+    // Respecifies the storage for mutable textures. For immutable textures, only same-size writes are allowed.
     void writePixels(uint32_t width, uint32_t height, uint32_t depth, void* pPixelData);
 
-    void generateMipmaps() const;
+    // Update a region of one mip level with glTexSubImage*D, never reallocates
+    void writeSubPixels(uint32_t level, uint32_t x, uint32_t y, uint32_t z,
+        uint32_t width, uint32_t height, uint32_t depth, const void* pPixelData);
+
+    // Compressed textures only. Respecifies one level of mutable storage with glCompressedTexImage*D;
+    // level 0 sets the size and drops any other levels, levels after it must be written in order.
+    // dataSize is the size of the whole level in bytes.
+    void writeCompressedPixels(uint32_t level, uint32_t width, uint32_t height, uint32_t depth,
+        size_t dataSize, const void* pData);
+
+    // Compressed textures only. Update a block-aligned region of one level with glCompressedTexSubImage*D.
+    void writeCompressedSubPixels(uint32_t level, uint32_t x, uint32_t y, uint32_t z,
+        uint32_t width, uint32_t height, uint32_t depth, size_t dataSize, const void* pData);
+
+    // Fills the levels below 0 from it. Mutable storage grows to the full mip chain.
+    void generateMipmaps();
 
 
 private:
@@ -98,10 +170,14 @@ private:
     GLuint handle;
 
     uint32_t width, height, depth;
+    uint32_t levels;
+    bool immutable;
     GLenum target;
     GLint internalFormat;
     GLenum pixelFormat;
     GLenum componentType;
+    uint32_t bytesPerPixel;
+    uint32_t bytesPerBlock;  // 0 for uncompressed formats
     Dimension dimension;
     //Format format;
 
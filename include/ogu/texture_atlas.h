@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "rect_packer.h"
+#include "texture.h"
+
+
+namespace ogu {
+
+// Packs many small images into the layers of one GL_TEXTURE_2D_ARRAY, so that everything drawn
+// from the atlas shares a single bind. Each layer has its own skyline_packer; images are uploaded
+// as sub-rects when added. When every layer is full the array grows (doubling, up to maxLayers) by
+// copying the old layers into a new texture, which needs ARB_copy_image; without it all maxLayers
+// are allocated up front. Removing an image only marks its space dead, repack() reclaims it.
+// Render thread only. Regions and the texture change on growth and repack(), so look them up again
+// rather than keeping them.
+class texture_atlas {
+public:
+
+    using image_id = uint32_t;
+
+    struct region {
+        uint32_t layer;
+        float u0, v0, u1, v1;
+        uint32_t x, y, width, height;  // in texels, padding not included
+    };
+
+    struct stats {
+        uint32_t layers;
+        size_t images;
+        size_t liveArea;  // texels of images that haven't been removed
+        size_t packedArea;  // texels taken in the packers, including padding and removed images
+    };
+
+    // @param padding texels around each image so filtering doesn't bleed between them, filled with
+    //        copies of the image's edge texels when it is written
+    texture_atlas(uint32_t width, uint32_t height, Texture::Format format,
+        uint32_t initialLayers = 1, uint32_t maxLayers = 16, uint32_t padding = 1);
+
+    texture_atlas(const texture_atlas&) = delete;
+
+    texture_atlas& operator=(const texture_atlas&) = delete;
+
+    // Pack and upload an image, pPixels may be nullptr to fill it later with write().
+    // Returns false if it doesn't fit even after growing to maxLayers.
+    bool add(uint32_t width, uint32_t height, const void* pPixels, image_id& out);
+
+    // Replace the whole image's texels and its padding. Rows are tightly packed, so set
+    // GL_UNPACK_ALIGNMENT to 1 if they might not be 4-byte multiples.
+    void write(image_id id, const void* pPixels);
+
+    void remove(image_id id);
+
+    const region& getRegion(image_id id) const;
+
+    inline Texture& texture() {
+        return *_texture;
+    }
+
+    inline uint32_t layers() const {
+        return (uint32_t) _packers.size();
+    }
+
+    // Pack the live images again from scratch, tallest first, into as few layers as they need (but
+    // at least initialLayers), copying them over on the GPU. Needs ARB_copy_image. Returns false and
+    // changes nothing if they would no longer fit in maxLayers.
+    bool repack();
+
+    stats getStats() const;
+
+private:
+
+    struct image {
+        region r;
+        bool live;
+    };
+
+    uint32_t _width, _height;
+    Texture::Format _format;
+    uint32_t _initialLayers, _maxLayers;
+    uint32_t _padding;
+
+    std::unique_ptr<Texture> _texture;
+    std::vector<skyline_packer> _packers;
+
+    std::vector<image> _images;
+    std::vector<image_id> _freeIds;
+    size_t _liveArea = 0;
+
+    std::vector<uint8_t> _padded;  // write() builds images with their padding here
+
+    std::unique_ptr<Texture> createTexture(uint32_t layers) const;
+
+    void setRegion(region& r, uint32_t layer, const skyline_packer::rect& slot) const;
+
+    void grow(uint32_t layers);
+
+};
+
+}  // namespace ogu
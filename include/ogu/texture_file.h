@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "texture.h"
+
+
+namespace ogu {
+
+// A KTX2 or DDS file memory-mapped and parsed in place. Texel data is never copied on the CPU:
+// upload() hands pointers into the mapping straight to glCompressedTexSubImage*D / glTexSubImage*D.
+// Handles 2D textures, 2D arrays and 3D textures in the block-compressed formats of
+// Texture::CompressedFormat, plus a few common uncompressed ones. Cube maps and supercompressed
+// KTX2 (Basis, zstd) aren't supported. The constructor throws std::runtime_error for anything it
+// can't read.
+class texture_file {
+public:
+
+    struct description {
+        Texture::Dimension dimension;
+        uint32_t width, height;
+        uint32_t depth;  // depth of 3D textures, layer count of arrays, otherwise 1
+        uint32_t levels;
+        bool compressed;
+        Texture::CompressedFormat compressedFormat;  // if compressed
+        bool srgb;
+        Texture::Format format;  // if not compressed
+    };
+
+    // Data of one level, for all layers if layers > 1
+    struct image {
+        const void* pData;
+        size_t size;
+        uint32_t level;
+        uint32_t layer;
+        uint32_t layers;
+    };
+
+    explicit texture_file(const std::string& path);
+
+    ~texture_file();
+
+    texture_file(const texture_file&) = delete;
+
+    texture_file& operator=(const texture_file&) = delete;
+
+    inline const description& getDescription() const {
+        return _description;
+    }
+
+    // In the file's order; KTX2 levels hold all their layers, DDS has one image per layer per level
+    inline const std::vector<image>& images() const {
+        return _images;
+    }
+
+    inline size_t fileSize() const {
+        return _size;
+    }
+
+    // New texture with immutable storage for every level in the file, uploaded from the mapping
+    std::unique_ptr<Texture> createTexture() const;
+
+    // Upload every image into a texture that already has storage of the file's size, format and levels.
+    // Uncompressed rows are tightly packed, so set GL_UNPACK_ALIGNMENT to 1 if they might not be 4-byte multiples.
+    void upload(Texture& texture) const;
+
+private:
+
+    const uint8_t* _pData = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#endif
+
+    description _description {};
+    std::vector<image> _images;
+
+    void unmap();
+
+    void parseKTX2();
+
+    void parseDDS();
+
+    // Bytes in one layer (or the whole volume of a 3D texture) of a level
+    size_t levelSize(uint32_t level) const;
+
+};
+
+}  // namespace ogu
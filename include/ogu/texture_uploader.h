@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+#include "buffer.h"
+#include "texture.h"
+
+
+namespace ogu {
+
+// Asynchronous texture uploads through a persistently mapped GL_PIXEL_UNPACK_BUFFER ring.
+// Any thread can stage() memory, fill it and submit() it; the render thread then calls flush()
+// once per frame, which only issues the glTexSubImage*D calls (reading from the ring, so the
+// driver doesn't copy from client memory) and fences them. Ring memory is reused once its fence
+// has signaled.
+class texture_uploader {
+private:
+
+    struct upload {
+        size_t offset;
+        size_t size;
+        size_t consumed;  // ring bytes used, including alignment and any padding skipped at a wrap
+
+        bool submitted;
+        uint64_t flushSerial;  // 0 until issued
+
+        Texture* pTexture;
+        uint32_t level, x, y, z, width, height, depth;
+    };
+
+    buffer _buffer;
+    uint8_t* _pMapped;
+
+    std::mutex _mutex;
+
+    // uploads in staging order, the front one is the oldest still holding ring memory
+    std::deque<upload> _uploads;
+    uint64_t _frontId = 0;
+
+    size_t _head = 0;
+    size_t _tail = 0;
+    size_t _used = 0;
+
+    std::deque<std::pair<GLsync, uint64_t>> _fences;
+    uint64_t _flushSerial = 0;
+    uint64_t _completedSerial = 0;
+
+    uint64_t _uploadsIssued = 0;
+    uint64_t _bytesIssued = 0;
+    uint64_t _stagingFailures = 0;
+
+    void retire();
+
+public:
+
+    struct staging {
+        void* pData;
+        size_t size;
+        uint64_t id;
+    };
+
+    struct stats {
+        uint64_t uploadsIssued;
+        uint64_t bytesIssued;
+        uint64_t stagingFailures;  // stage() calls that found the ring full
+        size_t bytesInUse;
+        size_t uploadsPending;
+    };
+
+    explicit texture_uploader(size_t stagingSize);
+
+    ~texture_uploader();
+
+    texture_uploader(const texture_uploader&) = delete;
+
+    texture_uploader& operator=(const texture_uploader&) = delete;
+
+    // Thread-safe. Reserve size bytes of staging memory for the caller to fill.
+    // Returns false if the ring doesn't currently have room, try again after the next flush().
+    bool stage(size_t size, staging& out);
+
+    // Thread-safe. Queue the upload of a filled staging region into a region of the texture, which
+    // must have storage allocated and must stay alive until the flush() that issues the upload.
+    void submit(const staging& s, Texture& texture, uint32_t level, uint32_t x, uint32_t y, uint32_t z,
+        uint32_t width, uint32_t height, uint32_t depth);
+
+    // Render thread only. Issue submitted uploads, up to roughly byteBudget bytes (at least one upload
+    // is issued if any are ready), then fence them. Returns the number of bytes issued.
+    size_t flush(size_t byteBudget = SIZE_MAX);
+
+    stats getStats();
+
+};
+
+}  // namespace ogu
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "gl_dispatch.h"
+
+#include <array>
+#include <cstdint>
+
+#include "hash.h"
+#include "init.h"
+#include "instrumentation.h"
+
+
+namespace ogu {
+
+// How to upload a value of type T to a uniform. Specializations are provided for int, unsigned int,
+// float, std::array<T, N> as vectors and std::array<std::array<float, N>, N> as column-major
+// matrices. Specialize this for other math types (e.g. glm) with the same two functions.
+template<typename T>
+struct uniform_traits;
+
+// Pre-resolved uniform location, set() goes straight to glUniform* / glProgramUniform*.
+// Without direct state access the program has to be in use when calling set().
+template<typename T>
+class uniform {
+private:
+
+    GLuint _program;
+    GLint _location;
+
+public:
+
+    uniform() :
+        _program(0), _location(-1)
+    { }
+
+    uniform(GLuint program, GLint location) :
+        _program(program), _location(location)
+    { }
+
+    inline GLuint program() const {
+        return _program;
+    }
+
+    inline GLint location() const {
+        return _location;
+    }
+
+    inline void set(const T& value) const {
+        OGU_COUNT_CALL(UNIFORM);
+        if (getFeatures().directStateAccess) {
+            uniform_traits<T>::set(_program, _location, value);
+        } else {
+            uniform_traits<T>::set(_location, value);
+        }
+    }
+
+};
+
+// Uniform name hashed at compile time, for name-based lookups that don't build or hash a std::string
+struct uniform_name {
+    uint64_t hash;
+
+    template<size_t N>
+    constexpr explicit uniform_name(const char (&name)[N]) :
+        hash(fnv1a(name, N - 1))
+    { }
+
+    constexpr uniform_name(const char* name, size_t length) :
+        hash(fnv1a(name, length))
+    { }
+};
+
+inline namespace literals {
+
+// "color"_uniform
+constexpr uniform_name operator"" _uniform(const char* name, size_t length) {
+    return uniform_name(name, length);
+}
+
+}  // namespace literals
+
+// Scalars
+
+template<>
+struct uniform_traits<int> {
+    static void set(GLint location, int value) { glUniform1i(location, value); }
+    static void set(GLuint program, GLint location, int value) { glProgramUniform1i(program, location, value); }
+};
+
+template<>
+struct uniform_traits<unsigned int> {
+    static void set(GLint location, unsigned int value) { glUniform1ui(location, value); }
+    static void set(GLuint program, GLint location, unsigned int value) { glProgramUniform1ui(program, location, value); }
+};
+
+template<>
+struct uniform_traits<float> {
+    static void set(GLint location, float value) { glUniform1f(location, value); }
+    static void set(GLuint program, GLint location, float value) { glProgramUniform1f(program, location, value); }
+};
+
+// Vectors
+
+template<>
+struct uniform_traits<std::array<float, 2>> {
+    static void set(GLint location, const std::array<float, 2>& v) { glUniform2fv(location, 1, v.data()); }
+    static void set(GLuint program, GLint location, const std::array<float, 2>& v) { glProgramUniform2fv(program, location, 1, v.data()); }
+};
+
+template<>
+struct uniform_traits<std::array<float, 3>> {
+    static void set(GLint location, const std::array<float, 3>& v) { glUniform3fv(location, 1, v.data()); }
+    static void set(GLuint program, GLint location, const std::array<float, 3>& v) { glProgramUniform3fv(program, location, 1, v.data()); }
+};
+
+template<>
+struct uniform_traits<std::array<float, 4>> {
+    static void set(GLint location, const std::array<float, 4>& v) { glUniform4fv(location, 1, v.data()); }
+    static void set(GLuint program, GLint location, const std::array<float, 4>& v) { glProgramUniform4fv(program, location, 1, v.data()); }
+};
+
+template<>
+struct uniform_traits<std::array<int, 2>> {
+    static void set(GLint location, const std::array<int, 2>& v) { glUniform2iv(location, 1, v.data()); }
+    static void set(GLuint program, GLint location, const std::array<int, 2>& v) { glProgramUniform2iv(program, location, 1, v.data()); }
+};
+
+template<>
+struct uniform_traits<std::array<int, 3>> {
+    static void set(GLint location, const std::array<int, 3>& v) { glUniform3iv(location, 1, v.data()); }
+    static void set(GLuint program, GLint location, const std::array<int, 3>& v) { glProgramUniform3iv(program, location, 1, v.data()); }
+};
+
+template<>
+struct uniform_traits<std::array<int, 4>> {
+    static void set(GLint location, const std::array<int, 4>& v) { glUniform4iv(location, 1, v.data()); }
+    static void set(GLuint program, GLint location, const std::array<int, 4>& v) { glProgramUniform4iv(program, location, 1, v.data()); }
+};
+
+template<>
+struct uniform_traits<std::array<unsigned int, 2>> {
+    static void set(GLint location, const std::array<unsigned int, 2>& v) { glUniform2uiv(location, 1, v.data()); }
+    static void set(GLuint program, GLint location, const std::array<unsigned int, 2>& v) { glProgramUniform2uiv(program, location, 1, v.data()); }
+};
+
+template<>
+struct uniform_traits<std::array<unsigned int, 3>> {
+    static void set(GLint location, const std::array<unsigned int, 3>& v) { glUniform3uiv(location, 1, v.data()); }
+    static void set(GLuint program, GLint location, const std::array<unsigned int, 3>& v) { glProgramUniform3uiv(program, location, 1, v.data()); }
+};
+
+template<>
+struct uniform_traits<std::array<unsigned int, 4>> {
+    static void set(GLint location, const std::array<unsigned int, 4>& v) { glUniform4uiv(location, 1, v.data()); }
+    static void set(GLuint program, GLint location, const std::array<unsigned int, 4>& v) { glProgramUniform4uiv(program, location, 1, v.data()); }
+};
+
+// Matrices, column-major (an array of columns)
+
+static_assert(sizeof(std::array<std::array<float, 4>, 4>) == 16 * sizeof(float), "matrix columns must be tightly packed");
+
+template<>
+struct uniform_traits<std::array<std::array<float, 2>, 2>> {
+    static void set(GLint location, const std::array<std::array<float, 2>, 2>& m) { glUniformMatrix2fv(location, 1, GL_FALSE, m[0].data()); }
+    static void set(GLuint program, GLint location, const std::array<std::array<float, 2>, 2>& m) { glProgramUniformMatrix2fv(program, location, 1, GL_FALSE, m[0].data()); }
+};
+
+template<>
+struct uniform_traits<std::array<std::array<float, 3>, 3>> {
+    static void set(GLint location, const std::array<std::array<float, 3>, 3>& m) { glUniformMatrix3fv(location, 1, GL_FALSE, m[0].data()); }
+    static void set(GLuint program, GLint location, const std::array<std::array<float, 3>, 3>& m) { glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, m[0].data()); }
+};
+
+template<>
+struct uniform_traits<std::array<std::array<float, 4>, 4>> {
+    static void set(GLint location, const std::array<std::array<float, 4>, 4>& m) { glUniformMatrix4fv(location, 1, GL_FALSE, m[0].data()); }
+    static void set(GLuint program, GLint location, const std::array<std::array<float, 4>, 4>& m) { glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, m[0].data()); }
+};
+
+}  // namespace ogu
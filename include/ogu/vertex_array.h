@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "buffer.h"
+#include "state_cache.h"
 
 
 namespace ogu {
@@ -31,13 +32,51 @@ struct vertex_buffer_binding {
     uint32_t stride;
     bool instanced;
 
+    // added to every attrib offset, for vertex data that lives in a sub-range of the buffer
+    GLintptr baseOffset;
+
     vertex_buffer_binding(const buffer& buf,
         const std::vector<vertex_attrib_description>& attribs,
         uint32_t stride, bool instanced = false) :
-        buf(buf), attribs(attribs), stride(stride), instanced(instanced)
+        buf(buf), attribs(attribs), stride(stride), instanced(instanced), baseOffset(0)
+    { }
+
+    vertex_buffer_binding(const buffer_range& range,
+        const std::vector<vertex_attrib_description>& attribs,
+        uint32_t stride, bool instanced = false) :
+        buf(*range.buf), attribs(attribs), stride(stride), instanced(instanced), baseOffset(range.offset)
     { }
 };
 
+// Bytes one attribute takes in a vertex, e.g. 12 for three GL_FLOATs
+GLsizei vertexAttribSize(const vertex_attrib_description& a);
+
+// A vertex buffer binding point (ARB_vertex_attrib_binding, or DSA) and the attributes reading from it.
+// Binding points take a stride of 0 literally where glVertexAttribPointer takes it as tightly packed,
+// and limit relative attribute offsets to GL_MAX_VERTEX_ATTRIB_RELATIVE_OFFSET (2047 at least), so
+// buffer bindings that use either get one binding point per attribute, with the attribute's offset
+// moved into the binding point's buffer offset.
+struct vertex_binding_point {
+    uint32_t source;  // index of the buffer binding it reads from
+    GLintptr offset;  // added to that binding's buffer offset
+    GLsizei stride;
+    bool instanced;
+    std::vector<vertex_attrib_description> attribs;  // offsets relative to the binding point
+};
+
+void appendBindingPoints(uint32_t source, const std::vector<vertex_attrib_description>& attribs, uint32_t stride,
+    bool instanced, std::vector<vertex_binding_point>& points);
+
+// Binding points for vertex_buffer_binding or vertex_layout::binding
+template<typename Binding>
+std::vector<vertex_binding_point> vertexBindingPoints(const std::vector<Binding>& bindings) {
+    std::vector<vertex_binding_point> points;
+    for (uint32_t i = 0; i < bindings.size(); ++i) {
+        appendBindingPoints(i, bindings[i].attribs, bindings[i].stride, bindings[i].instanced, points);
+    }
+    return points;
+}
+
 class vertex_array {
 
 public:
@@ -62,7 +101,7 @@ private:
 };
 
 inline void vertex_array::bind() const {
-    glBindVertexArray(_handle);
+    state_cache::current().bindVertexArray(_handle);
 }
 
 } // namespace ogu
\ No newline at end of file
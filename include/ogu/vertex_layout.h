@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "vertex_array.h"
+
+
+namespace ogu {
+
+// The buffer-independent part of a vector of vertex_buffer_binding: attribute formats, strides and
+// instancing per binding point. Hashable, so meshes that share a format can share a VAO.
+class vertex_layout {
+public:
+
+    struct binding {
+        std::vector<vertex_attrib_description> attribs;
+        uint32_t stride;
+        bool instanced;
+    };
+
+    explicit vertex_layout(std::vector<binding> bindings);
+
+    explicit vertex_layout(const std::vector<vertex_buffer_binding>& bindings);
+
+    inline const std::vector<binding>& bindings() const {
+        return _bindings;
+    }
+
+    inline uint64_t hash() const {
+        return _hash;
+    }
+
+    bool operator==(const vertex_layout& other) const;
+
+    inline bool operator!=(const vertex_layout& other) const {
+        return !(*this == other);
+    }
+
+    struct hasher {
+        size_t operator()(const vertex_layout& layout) const {
+            return (size_t) layout.hash();
+        }
+    };
+
+private:
+
+    std::vector<binding> _bindings;
+    uint64_t _hash;
+
+};
+
+// One VAO per distinct vertex_layout. Attribute formats are set once per VAO with
+// glVertexAttribFormat / glVertexAttribBinding (ARB_vertex_attrib_binding), so switching between
+// meshes with the same layout only rebinds vertex buffers, not the VAO. A layout binding may take
+// several binding points (see vertex_binding_point). Without the extension the attribute pointers of
+// the shared VAO are re-specified instead when a buffer changes.
+class vertex_array_cache {
+public:
+
+    struct stats {
+        size_t layouts;
+        uint64_t vaoSwitches;
+        uint64_t bufferBinds;
+        uint64_t elidedBufferBinds;
+    };
+
+    vertex_array_cache() = default;
+
+    ~vertex_array_cache();
+
+    vertex_array_cache(const vertex_array_cache&) = delete;
+
+    vertex_array_cache& operator=(const vertex_array_cache&) = delete;
+
+    // Returns the cached copy of the layout, creating its VAO if it's new. The reference stays valid for
+    // the lifetime of the cache, keep it per mesh to skip hashing the layout on every bind.
+    const vertex_layout& intern(const vertex_layout& layout);
+
+    // Binds the layout's VAO and the given vertex buffers (one per layout binding, size is ignored),
+    // and the index buffer if there is one. The layout must come from intern().
+    void bind(const vertex_layout& layout, const buffer_range* pVertexBuffers, const buffer* pIndexBuffer = nullptr);
+
+    // Per-frame counters cover everything since the last endFrame()
+    inline const stats& frameStats() const {
+        return _frame;
+    }
+
+    inline const stats& lastFrameStats() const {
+        return _lastFrame;
+    }
+
+    void endFrame();
+
+private:
+
+    // by buffer::serial(), GL names are reused once a buffer is deleted
+    struct bound_buffer {
+        uint64_t serial;
+        GLintptr offset;
+    };
+
+    struct vao_entry {
+        GLuint handle;
+        std::vector<vertex_binding_point> points;  // empty without ARB_vertex_attrib_binding
+        std::vector<bound_buffer> vertexBuffers;
+        uint64_t indexBuffer;
+    };
+
+    std::unordered_map<vertex_layout, vao_entry, vertex_layout::hasher> _vaos;
+
+    stats _frame {};
+    stats _lastFrame {};
+
+    void createVertexArray(const vertex_layout& layout, vao_entry& entry);
+
+};
+
+}  // namespace ogu
@@ -1,26 +1,87 @@
 #include "buffer.h"
 
+#include <atomic>
 #include <utility>
 
 
 namespace ogu {
 
+static uint64_t nextSerial() {
+    static std::atomic<uint64_t> serial { 0 };
+    return ++serial;
+}
+
 buffer::buffer(size_t size) :
-        _size(size) {
+        _size(size),
+        _serial(nextSerial()) {
+    OGU_OBJECT_CREATED(BUFFER, size);
+    if (getFeatures().directStateAccess) {
+        glCreateBuffers(1, &_handle);
+        glNamedBufferData(_handle, size, nullptr, GL_STATIC_DRAW);
+        return;
+    }
     glGenBuffers(1, &_handle);
-    glBindBuffer(GL_COPY_WRITE_BUFFER, _handle);
+    bind(GL_COPY_WRITE_BUFFER);
     glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
-    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+buffer::buffer(size_t size, GLbitfield storageFlags, const void* pData) :
+        _size(size),
+        _serial(nextSerial()) {
+    OGU_OBJECT_CREATED(BUFFER, size);
+    if (pData) {
+        OGU_COUNT_CALL(UPLOAD);
+        OGU_COUNT_UPLOAD(size);
+    }
+    if (getFeatures().directStateAccess) {
+        glCreateBuffers(1, &_handle);
+        glNamedBufferStorage(_handle, size, pData, storageFlags);
+        return;
+    }
+    glGenBuffers(1, &_handle);
+    bind(GL_COPY_WRITE_BUFFER);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, size, pData, storageFlags);
 }
 
 buffer::buffer(buffer&& b) :
     _handle(std::move(b._handle)),
-    _size(std::move(b._size))
+    _size(std::move(b._size)),
+    _serial(b._serial)
 {
     b._handle = 0;
 }
 
+void* buffer::map(intptr_t offset, size_t size, GLbitfield accessFlags) const {
+    if (getFeatures().directStateAccess) {
+        return glMapNamedBufferRange(_handle, offset, size, accessFlags);
+    }
+    bind(GL_COPY_WRITE_BUFFER);
+    return glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, accessFlags);
+}
+
+void buffer::flushMappedRange(intptr_t offset, size_t size) const {
+    if (getFeatures().directStateAccess) {
+        glFlushMappedNamedBufferRange(_handle, offset, size);
+        return;
+    }
+    bind(GL_COPY_WRITE_BUFFER);
+    glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, offset, size);
+}
+
+void buffer::unmap() const {
+    if (getFeatures().directStateAccess) {
+        glUnmapNamedBuffer(_handle);
+        return;
+    }
+    bind(GL_COPY_WRITE_BUFFER);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+}
+
 buffer::~buffer() {
+    if (_handle) {
+        state_cache::current().forgetBuffer(_handle);
+        OGU_OBJECT_DESTROYED(BUFFER, _size);
+    }
     glDeleteBuffers(1, &_handle);
 }
 
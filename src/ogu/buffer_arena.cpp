@@ -0,0 +1,140 @@
+#include "buffer_arena.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+
+namespace ogu {
+
+static size_t alignUp(size_t offset, size_t alignment) {
+    return (alignment > 1) ? (offset + alignment - 1) / alignment * alignment : offset;
+}
+
+buffer_arena::page::page(size_t size) :
+        buf(size) {
+    insertFree(0, size);
+}
+
+void buffer_arena::page::insertFree(size_t offset, size_t size) {
+    freeByOffset.emplace(offset, size);
+    freeBySize.emplace(size, offset);
+}
+
+void buffer_arena::page::eraseFree(std::map<size_t, size_t>::iterator it) {
+    auto range = freeBySize.equal_range(it->second);
+    for (auto s = range.first; s != range.second; ++s) {
+        if (s->second == it->first) {
+            freeBySize.erase(s);
+            break;
+        }
+    }
+    freeByOffset.erase(it);
+}
+
+bool buffer_arena::page::tryAllocate(size_t size, size_t alignment, size_t& offsetOut) {
+    // Best fit: smallest free block that still fits once its start is aligned
+    for (auto s = freeBySize.lower_bound(size); s != freeBySize.end(); ++s) {
+        size_t blockOffset = s->second, blockSize = s->first;
+        size_t offset = alignUp(blockOffset, alignment);
+        size_t padding = offset - blockOffset;
+        if (padding + size > blockSize) continue;
+
+        eraseFree(freeByOffset.find(blockOffset));
+        // Give the alignment padding and the tail back to the free list
+        if (padding > 0) insertFree(blockOffset, padding);
+        if (padding + size < blockSize) insertFree(offset + size, blockSize - padding - size);
+
+        offsetOut = offset;
+        return true;
+    }
+    return false;
+}
+
+buffer_arena::buffer_arena(size_t pageSize, size_t maxPages) :
+        _pageSize(pageSize),
+        _maxPages(maxPages) {
+}
+
+buffer_arena::page& buffer_arena::findPage(const buffer* buf) {
+    for (auto& p : _pages) {
+        if (&p->buf == buf) return *p;
+    }
+    throw std::invalid_argument("Buffer range was not allocated from this arena.");
+}
+
+buffer_range buffer_arena::allocate(size_t size, size_t alignment) {
+    if (size == 0 || size > _pageSize) throw std::length_error("Invalid buffer arena allocation size.");
+
+    size_t offset = 0;
+    page* pPage = nullptr;
+    for (auto& p : _pages) {
+        if (p->tryAllocate(size, alignment, offset)) {
+            pPage = p.get();
+            break;
+        }
+    }
+    if (!pPage) {
+        if (_maxPages != 0 && _pages.size() >= _maxPages) throw std::length_error("Buffer arena page limit reached.");
+        _pages.push_back(std::make_unique<page>(_pageSize));
+        pPage = _pages.back().get();
+        pPage->tryAllocate(size, alignment, offset);
+    }
+
+    _used += size;
+    _peakUsed = std::max(_peakUsed, _used);
+    ++_allocationCount;
+
+    return { &pPage->buf, (intptr_t) offset, size };
+}
+
+void buffer_arena::free(const buffer_range& range) {
+    page& p = findPage(range.buf);
+
+    size_t offset = (size_t) range.offset, size = range.size;
+
+    // Coalesce with the following block
+    auto next = p.freeByOffset.lower_bound(offset);
+    if (next != p.freeByOffset.end() && next->first == offset + size) {
+        size += next->second;
+        auto n = next++;
+        p.eraseFree(n);
+    }
+    // Coalesce with the preceding block
+    if (next != p.freeByOffset.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            offset = prev->first;
+            size += prev->second;
+            p.eraseFree(prev);
+        }
+    }
+    p.insertFree(offset, size);
+
+    _used -= range.size;
+    --_allocationCount;
+}
+
+buffer_arena::stats buffer_arena::getStats() const {
+    stats s {};
+    s.pageCount = _pages.size();
+    s.capacity = _pages.size() * _pageSize;
+    s.used = _used;
+    s.peakUsed = _peakUsed;
+    s.allocationCount = _allocationCount;
+    for (const auto& p : _pages) {
+        s.freeBlockCount += p->freeByOffset.size();
+        if (!p->freeBySize.empty()) {
+            s.largestFreeBlock = std::max(s.largestFreeBlock, p->freeBySize.rbegin()->first);
+        }
+    }
+    return s;
+}
+
+size_t buffer_arena::uniformBufferAlignment() {
+    GLint alignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return (size_t) alignment;
+}
+
+}  // namespace ogu
@@ -1,5 +1,7 @@
 #include "buffer_texture.h"
 
+#include "init.h"
+
 #include <cstring>
 #include <utility>
 
@@ -8,7 +10,9 @@ namespace ogu {
 
 buffer_texture::buffer_texture(buffer_texture&& b) :
         _handle(std::move(b._handle)),
-        _buffer(std::move(b._buffer)) { }
+        _buffer(std::move(b._buffer)) {
+    b._handle = 0;
+}
 
 // Make sure the format will translate to one of the supported formats in the table at
 // https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexBuffer.xhtml
@@ -165,9 +169,15 @@ static GLenum getInternalFormat(const buffer_texture::Format& format) {
 buffer_texture::buffer_texture(size_t size, const Format& format, void* pData, uint32_t extraFlags) :
     _buffer(size)
 {
-    glGenTextures(1, &_handle);
-    glBindTexture(GL_TEXTURE_BUFFER, _handle);
-    glTexBuffer(GL_TEXTURE_BUFFER, getInternalFormat(format), _buffer.handle());
+    OGU_OBJECT_CREATED(TEXTURE, 0);
+    if (getFeatures().directStateAccess) {
+        glCreateTextures(GL_TEXTURE_BUFFER, 1, &_handle);
+        glTextureBuffer(_handle, getInternalFormat(format), _buffer.handle());
+    } else {
+        glGenTextures(1, &_handle);
+        state_cache::current().bindTexture(GL_TEXTURE_BUFFER, _handle);
+        glTexBuffer(GL_TEXTURE_BUFFER, getInternalFormat(format), _buffer.handle());
+    }
     if (pData) {
         _buffer.write(0, 0, [&] (void* pBufferData) {
                 memcpy(pBufferData, pData, size);
@@ -176,12 +186,15 @@ buffer_texture::buffer_texture(size_t size, const Format& format, void* pData, u
 }
 
 buffer_texture::~buffer_texture() {
+    if (_handle) {
+        state_cache::current().forgetTexture(_handle);
+        OGU_OBJECT_DESTROYED(TEXTURE, 0);
+    }
     glDeleteTextures(1, &_handle);
 }
 
 void buffer_texture::bind(uint32_t index) const {
-    glActiveTexture(GL_TEXTURE0 + index);
-    glBindTexture(GL_TEXTURE_BUFFER, _handle);
+    state_cache::current().bindTexture(index, GL_TEXTURE_BUFFER, _handle);
 }
 
 }
\ No newline at end of file
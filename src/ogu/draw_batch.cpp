@@ -0,0 +1,179 @@
+#include "draw_batch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "hash.h"
+#include "init.h"
+#include "instrumentation.h"
+
+
+namespace ogu {
+
+static size_t storageBufferAlignment() {
+    static GLint alignment = 0;
+    if (alignment == 0) {
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment = std::max(alignment, 1);
+    }
+    return (size_t) alignment;
+}
+
+draw_batch::draw_batch(uint32_t instanceDataSize, GLuint instanceBinding) :
+        _instanceDataSize(instanceDataSize),
+        _instanceBinding(instanceBinding) {
+    const features& f = getFeatures();
+    if (!f.baseInstance) throw std::runtime_error("draw_batch needs GL 4.2 or ARB_base_instance.");
+    if (instanceDataSize > 0 && !(f.shaderStorageBuffer && f.shaderDrawParameters)) {
+        throw std::runtime_error("draw_batch instance data needs GL 4.6 or ARB_shader_storage_buffer_object "
+            "and ARB_shader_draw_parameters.");
+    }
+}
+
+// Program in the high half so that program switches, the most expensive change, happen least often
+uint64_t draw_batch::stateKey(const draw& d) {
+    uint64_t program = fnv1a_value(d.program);
+    uint64_t state = fnv1a_value(d.layout);
+    for (size_t i = 0; i < d.layout->bindings().size(); ++i) {
+        state = fnv1a_value(d.pVertexBuffers[i].buf, state);
+        state = fnv1a_value(d.pVertexBuffers[i].offset, state);
+    }
+    state = fnv1a_value(d.indexBuffer, state);
+    state = fnv1a_value(d.mode, state);
+    state = fnv1a_value(d.indexType, state);
+    return (program << 32) | (state & 0xffffffffull);
+}
+
+bool draw_batch::sameState(const draw& a, const draw& b) {
+    if (a.program != b.program || a.layout != b.layout || a.indexBuffer != b.indexBuffer
+            || a.mode != b.mode || a.indexType != b.indexType) {
+        return false;
+    }
+    for (size_t i = 0; i < a.layout->bindings().size(); ++i) {
+        if (a.pVertexBuffers[i].buf != b.pVertexBuffers[i].buf
+                || a.pVertexBuffers[i].offset != b.pVertexBuffers[i].offset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void draw_batch::add(const draw& d, const void* pInstanceData) {
+    if (_instanceDataSize > 0) {
+        for (const auto& b : d.layout->bindings()) {
+            // baseInstance is the instance data index, it would offset these attributes too
+            if (b.instanced) throw std::invalid_argument("Instanced vertex bindings can't be used with instance data.");
+        }
+    }
+    _draws.push_back(d);
+    _keys.push_back(stateKey(d));
+    if (_instanceDataSize > 0) {
+        size_t offset = _instanceData.size();
+        _instanceData.resize(offset + _instanceDataSize);
+        if (pInstanceData) {
+            std::memcpy(_instanceData.data() + offset, pInstanceData, _instanceDataSize);
+        }
+    }
+}
+
+void draw_batch::clear() {
+    _draws.clear();
+    _keys.clear();
+    _instanceData.clear();
+    _order.clear();
+    _runStarts.clear();
+}
+
+size_t draw_batch::build() {
+    _order.resize(_draws.size());
+    for (uint32_t i = 0; i < _order.size(); ++i) {
+        _order[i] = i;
+    }
+    // ties broken by index so the queue order is kept within a batch
+    std::sort(_order.begin(), _order.end(), [this] (uint32_t a, uint32_t b) {
+            return _keys[a] != _keys[b] ? _keys[a] < _keys[b] : a < b;
+        });
+
+    _runStarts.clear();
+    for (uint32_t i = 0; i < _order.size(); ++i) {
+        if (i == 0 || !sameState(_draws[_order[i - 1]], _draws[_order[i]])) {
+            _runStarts.push_back(i);
+        }
+    }
+    return _runStarts.size();
+}
+
+void draw_batch::submit(stream_buffer& stream, vertex_array_cache& vertexArrays) {
+    _lastStats = {};
+    if (_draws.empty()) return;
+
+    build();
+    _lastStats.draws = _draws.size();
+    _lastStats.batches = _runStarts.size();
+
+    if (_instanceDataSize > 0) {
+        size_t size = _instanceData.size();
+        intptr_t offset = stream.write(size, storageBufferAlignment(), [this] (void* pData) {
+                uint8_t* pDst = (uint8_t*) pData;
+                for (uint32_t index : _order) {
+                    std::memcpy(pDst, _instanceData.data() + (size_t) index * _instanceDataSize, _instanceDataSize);
+                    pDst += _instanceDataSize;
+                }
+            });
+        state_cache::current().bindBufferRange(GL_SHADER_STORAGE_BUFFER, _instanceBinding,
+            stream.getBuffer().handle(), offset, size);
+    }
+
+    auto command = [this] (uint32_t position) {
+        const draw& d = _draws[_order[position]];
+        return draw_elements_indirect_command {
+            d.indexCount, d.instanceCount, d.firstIndex, d.baseVertex,
+            _instanceDataSize > 0 ? position : d.baseInstance
+        };
+    };
+
+    const bool multiDraw = getFeatures().multiDrawIndirect;
+    intptr_t commandsOffset = 0;
+    if (multiDraw) {
+        commandsOffset = stream.write(_order.size() * sizeof(draw_elements_indirect_command), alignof(GLuint),
+            [&] (void* pData) {
+                auto* pCommands = (draw_elements_indirect_command*) pData;
+                for (uint32_t i = 0; i < _order.size(); ++i) {
+                    pCommands[i] = command(i);
+                }
+            });
+        stream.getBuffer().bind(GL_DRAW_INDIRECT_BUFFER);
+    }
+
+    for (size_t run = 0; run < _runStarts.size(); ++run) {
+        uint32_t first = _runStarts[run];
+        uint32_t end = (run + 1 < _runStarts.size()) ? _runStarts[run + 1] : (uint32_t) _order.size();
+        const draw& d = _draws[_order[first]];
+
+        d.program->use();
+        vertexArrays.bind(*d.layout, d.pVertexBuffers, d.indexBuffer);
+
+        if (multiDraw) {
+            glMultiDrawElementsIndirect(d.mode, d.indexType,
+                (const void*) (commandsOffset + first * sizeof(draw_elements_indirect_command)),
+                (GLsizei) (end - first), 0);
+            ++_lastStats.drawCalls;
+            OGU_COUNT_CALL(DRAW);
+            continue;
+        }
+
+        const size_t indexSize = d.indexType == GL_UNSIGNED_BYTE ? 1 : (d.indexType == GL_UNSIGNED_SHORT ? 2 : 4);
+        for (uint32_t i = first; i < end; ++i) {
+            draw_elements_indirect_command c = command(i);
+            glDrawElementsInstancedBaseVertexBaseInstance(d.mode, c.count, d.indexType,
+                (const void*) (c.firstIndex * indexSize), c.instanceCount, c.baseVertex, c.baseInstance);
+            ++_lastStats.drawCalls;
+            OGU_COUNT_CALL(DRAW);
+        }
+    }
+
+    clear();
+}
+
+}  // namespace ogu
@@ -0,0 +1,17 @@
+#define OGU_GL_DISPATCH_IMPLEMENTATION
+#include "gl_dispatch.h"
+
+
+namespace ogu {
+namespace gl {
+
+dispatch_table table {};
+
+void loadDispatchTable() {
+#define OGU_GL_LOAD_ENTRY(name) table.name = gl##name;
+    OGU_GL_FUNCTIONS(OGU_GL_LOAD_ENTRY)
+#undef OGU_GL_LOAD_ENTRY
+}
+
+}  // namespace gl
+}  // namespace ogu
@@ -0,0 +1,195 @@
+#include "gpu_profiler.h"
+
+#include <stdexcept>
+
+#include "init.h"
+
+
+namespace ogu {
+
+gpu_profiler::gpu_profiler(uint32_t frameLatency, size_t historyFrames) :
+        _epoch(std::chrono::steady_clock::now()),
+        _slots(frameLatency),
+        _historyFrames(historyFrames) {
+    if (frameLatency == 0) throw std::invalid_argument("Profiler needs at least one frame of latency.");
+    if (getFeatures().timerQuery) {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        _gpuOffset = now() - gpuNow;
+    }
+}
+
+gpu_profiler::~gpu_profiler() {
+    for (auto& s : _slots) {
+        if (!s.queries.empty()) glDeleteQueries((GLsizei) s.queries.size(), s.queries.data());
+    }
+}
+
+int64_t gpu_profiler::now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _epoch).count();
+}
+
+int32_t gpu_profiler::nextQuery(slot& s) {
+    if (s.queriesUsed == s.queries.size()) {
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        s.queries.push_back(query);
+    }
+    return (int32_t) s.queriesUsed++;
+}
+
+void gpu_profiler::beginFrame() {
+    if (_inFrame) throw std::logic_error("beginFrame() called twice without endFrame().");
+
+    slot& s = _slots[_current];
+    if (s.pending && !resolve(s)) {
+        // the GPU is more than frameLatency frames behind, rather than wait, lose the results
+        ++_droppedFrames;
+    }
+    s.pending = false;
+    s.number = _frameNumber++;
+    s.nodes.clear();
+    s.queriesUsed = 0;
+    _inFrame = true;
+}
+
+void gpu_profiler::endFrame() {
+    if (!_inFrame) throw std::logic_error("endFrame() called without beginFrame().");
+    if (!_stack.empty()) throw std::logic_error("Profiler scopes still open at the end of the frame.");
+
+    _slots[_current].pending = true;
+    _inFrame = false;
+    _current = (_current + 1) % _slots.size();
+
+    // oldest first, stopping at the first frame the GPU hasn't finished
+    for (size_t i = 0; i < _slots.size(); ++i) {
+        slot& s = _slots[(_current + i) % _slots.size()];
+        if (s.pending && !resolve(s)) break;
+    }
+}
+
+void gpu_profiler::begin(const char* name, bool gpu) {
+    if (!_inFrame) throw std::logic_error("Profiler scope outside of beginFrame() / endFrame().");
+
+    slot& s = _slots[_current];
+    node n {};
+    n.name = name;
+    n.parent = _stack.empty() ? -1 : (int32_t) _stack.back();
+    n.depth = (uint32_t) _stack.size();
+    n.beginQuery = NO_QUERY;
+    n.endQuery = NO_QUERY;
+
+    if (gpu && getFeatures().timerQuery) {
+        n.beginQuery = nextQuery(s);
+        glQueryCounter(s.queries[n.beginQuery], GL_TIMESTAMP);
+    } else if (gpu && _elapsedOwner == -1) {
+        n.beginQuery = nextQuery(s);
+        glBeginQuery(GL_TIME_ELAPSED, s.queries[n.beginQuery]);
+        _elapsedOwner = (int32_t) s.nodes.size();
+    }
+
+    _stack.push_back((uint32_t) s.nodes.size());
+    n.cpuBegin = now();
+    s.nodes.push_back(n);
+}
+
+void gpu_profiler::end() {
+    if (_stack.empty()) throw std::logic_error("Profiler scope ended without a matching begin.");
+
+    slot& s = _slots[_current];
+    uint32_t index = _stack.back();
+    _stack.pop_back();
+    node& n = s.nodes[index];
+    n.cpuEnd = now();
+
+    if (n.beginQuery == NO_QUERY) return;
+    if (getFeatures().timerQuery) {
+        n.endQuery = nextQuery(s);
+        glQueryCounter(s.queries[n.endQuery], GL_TIMESTAMP);
+    } else if (_elapsedOwner == (int32_t) index) {
+        glEndQuery(GL_TIME_ELAPSED);
+        _elapsedOwner = -1;
+    }
+}
+
+bool gpu_profiler::resolve(slot& s) {
+    if (s.queriesUsed > 0) {
+        // queries complete in order, so the last one being available means they all are
+        GLint available = 0;
+        glGetQueryObjectiv(s.queries[s.queriesUsed - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return false;
+    }
+
+    auto result = [&] (int32_t query) {
+        GLuint64 value = 0;
+        glGetQueryObjectui64v(s.queries[query], GL_QUERY_RESULT, &value);
+        return (int64_t) value;
+    };
+
+    frame f;
+    f.number = s.number;
+    f.timings.reserve(s.nodes.size());
+    for (const node& n : s.nodes) {
+        timing t { n.name, n.parent, n.depth, n.cpuBegin, n.cpuEnd, -1, -1 };
+        if (n.beginQuery != NO_QUERY && getFeatures().timerQuery) {
+            t.gpuBegin = result(n.beginQuery) + _gpuOffset;
+            t.gpuEnd = result(n.endQuery) + _gpuOffset;
+        } else if (n.beginQuery != NO_QUERY) {
+            // only a duration, placed at the CPU begin time
+            t.gpuBegin = n.cpuBegin;
+            t.gpuEnd = n.cpuBegin + result(n.beginQuery);
+        }
+        f.timings.push_back(t);
+    }
+
+    _history.push_back(std::move(f));
+    while (_history.size() > _historyFrames) {
+        _history.pop_front();
+    }
+    s.pending = false;
+    return true;
+}
+
+const gpu_profiler::frame* gpu_profiler::lastFrame() const {
+    return _history.empty() ? nullptr : &_history.back();
+}
+
+static void writeJsonString(std::ostream& out, const char* s) {
+    out << '"';
+    for (; *s; ++s) {
+        char c = *s;
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if ((unsigned char) c < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+void gpu_profiler::writeChromeTrace(std::ostream& out) const {
+    bool first = true;
+    auto event = [&] (const char* name, int tid, int64_t begin, int64_t end, uint64_t frameNumber) {
+        out << (first ? "\n" : ",\n") << "{\"name\":";
+        writeJsonString(out, name);
+        // microseconds, with the nanoseconds kept as a fraction
+        out << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid
+            << ",\"ts\":" << begin / 1000 << '.' << (begin % 1000) / 100 << (begin % 100) / 10 << begin % 10
+            << ",\"dur\":" << (end - begin) / 1000 << '.' << ((end - begin) % 1000) / 100 << ((end - begin) % 100) / 10 << (end - begin) % 10
+            << ",\"args\":{\"frame\":" << frameNumber << "}}";
+        first = false;
+    };
+
+    out << "{\"traceEvents\":[";
+    for (const frame& f : _history) {
+        for (const timing& t : f.timings) {
+            event(t.name, 0, t.cpuBegin, t.cpuEnd, f.number);
+            if (t.gpuBegin >= 0) event(t.name, 1, t.gpuBegin, t.gpuEnd, f.number);
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+}  // namespace ogu
@@ -0,0 +1,841 @@
+#include "image_ops.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OGU_IMAGE_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 code is compiled per function with target attributes and only run when the CPU has it
+#if defined(OGU_IMAGE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define OGU_IMAGE_AVX2
+#include <immintrin.h>
+#define OGU_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#endif
+
+
+namespace ogu {
+namespace image_ops {
+
+static simd_level detectSimd() {
+#ifdef OGU_IMAGE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) return simd_level::AVX2;
+#endif
+#ifdef OGU_IMAGE_SSE2
+    return simd_level::SSE2;
+#else
+    return simd_level::SCALAR;
+#endif
+}
+
+static simd_level s_active = supportedSimd();
+
+simd_level supportedSimd() {
+    static const simd_level supported = detectSimd();
+    return supported;
+}
+
+simd_level activeSimd() {
+    return s_active;
+}
+
+void setSimdLimit(simd_level limit) {
+    s_active = std::min(limit, supportedSimd());
+}
+
+// Half floats
+
+static uint16_t floatToHalf(float value) {
+    uint32_t f;
+    std::memcpy(&f, &value, 4);
+    uint32_t sign = (f >> 16) & 0x8000;
+    uint32_t abs = f & 0x7fffffff;
+
+    if (abs >= 0x7f800000) {
+        // infinity stays infinity, NaNs stay quiet NaNs
+        return (uint16_t) (sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0));
+    }
+    if (abs >= 0x477ff000) {
+        // rounds up past the largest half
+        return (uint16_t) (sign | 0x7c00);
+    }
+    if (abs < 0x38800000) {
+        // subnormal half: let the float adder round the mantissa into place
+        float magic;
+        uint32_t magicBits = 0x3f000000;  // 0.5, whose ulp is the smallest subnormal half
+        std::memcpy(&magic, &magicBits, 4);
+        float absValue;
+        std::memcpy(&absValue, &abs, 4);
+        float rounded = absValue + magic;
+        uint32_t bits;
+        std::memcpy(&bits, &rounded, 4);
+        return (uint16_t) (sign | (bits - magicBits));
+    }
+    uint32_t mantissaOdd = (abs >> 13) & 1;
+    abs += 0xc8000fff + mantissaOdd;  // rebias the exponent (-112 << 23) and round to nearest even
+    return (uint16_t) (sign | (abs >> 13));
+}
+
+static float halfToFloat(uint16_t h) {
+    uint32_t sign = (uint32_t) (h & 0x8000) << 16;
+    uint32_t expMantissa = h & 0x7fff;
+    uint32_t bits;
+    if (expMantissa >= 0x7c00) {
+        bits = sign | 0x7f800000 | ((expMantissa & 0x3ff) << 13);
+    } else {
+        // scaling by 2^112 rebiases normals and normalizes subnormals in one go
+        uint32_t shifted = expMantissa << 13;
+        float scaled;
+        std::memcpy(&scaled, &shifted, 4);
+        scaled *= 5.192296858534828e+33f;
+        std::memcpy(&bits, &scaled, 4);
+        bits |= sign;
+    }
+    float f;
+    std::memcpy(&f, &bits, 4);
+    return f;
+}
+
+#ifdef OGU_IMAGE_SSE2
+
+static __m128i floatToHalfSSE2(__m128 f) {
+    const __m128i infinityAsFloat = _mm_set1_epi32(0x7f800000);
+    const __m128i halfMax = _mm_set1_epi32((127 + 16) << 23);  // everything from here rounds to infinity
+    const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+    const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normalBias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+    __m128 sign = _mm_and_ps(f, _mm_set1_ps(-0.0f));
+    __m128 absf = _mm_xor_ps(f, sign);
+    __m128i absi = _mm_castps_si128(absf);
+
+    __m128i isNan = _mm_cmpgt_epi32(absi, infinityAsFloat);
+    __m128i isRegular = _mm_cmpgt_epi32(halfMax, absi);
+    __m128i special = _mm_or_si128(_mm_and_si128(isNan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+
+    __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absi);
+    __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absf, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+    __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absi, 31 - 13), 31);
+    __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absi, normalBias), mantissaOdd), 13);
+
+    __m128i value = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    value = _mm_or_si128(_mm_and_si128(isRegular, value), _mm_andnot_si128(isRegular, special));
+    // arithmetic shift so negative results are sign-extended and survive the signed pack
+    return _mm_or_si128(value, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+static __m128 halfToFloatSSE2(__m128i h) {
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+    __m128i expMantissa = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+    __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, expMantissa), 16);
+    __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMantissa, 13)), magic);
+    __m128i wasInfNan = _mm_cmpgt_epi32(expMantissa, _mm_set1_epi32(0x7bff));
+    __m128 infNanExponent = _mm_and_ps(_mm_castsi128_ps(wasInfNan), _mm_castsi128_ps(_mm_set1_epi32(255 << 23)));
+    return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), infNanExponent));
+}
+
+#endif
+
+#ifdef OGU_IMAGE_AVX2
+
+OGU_TARGET_AVX2 static void floatToHalfAVX2(const float* pSrc, uint16_t* pDst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(pSrc + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i*) (pDst + i), h);
+    }
+    for (; i < count; ++i) {
+        pDst[i] = floatToHalf(pSrc[i]);
+    }
+}
+
+OGU_TARGET_AVX2 static void halfToFloatAVX2(const uint16_t* pSrc, float* pDst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(pDst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*) (pSrc + i))));
+    }
+    for (; i < count; ++i) {
+        pDst[i] = halfToFloat(pSrc[i]);
+    }
+}
+
+#endif
+
+void floatToHalf(const float* pSrc, uint16_t* pDst, size_t count) {
+    size_t i = 0;
+#ifdef OGU_IMAGE_AVX2
+    if (s_active == simd_level::AVX2) {
+        floatToHalfAVX2(pSrc, pDst, count);
+        return;
+    }
+#endif
+#ifdef OGU_IMAGE_SSE2
+    if (s_active >= simd_level::SSE2) {
+        for (; i + 8 <= count; i += 8) {
+            __m128i lo = floatToHalfSSE2(_mm_loadu_ps(pSrc + i));
+            __m128i hi = floatToHalfSSE2(_mm_loadu_ps(pSrc + i + 4));
+            _mm_storeu_si128((__m128i*) (pDst + i), _mm_packs_epi32(lo, hi));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        pDst[i] = floatToHalf(pSrc[i]);
+    }
+}
+
+void halfToFloat(const uint16_t* pSrc, float* pDst, size_t count) {
+    size_t i = 0;
+#ifdef OGU_IMAGE_AVX2
+    if (s_active == simd_level::AVX2) {
+        halfToFloatAVX2(pSrc, pDst, count);
+        return;
+    }
+#endif
+#ifdef OGU_IMAGE_SSE2
+    if (s_active >= simd_level::SSE2) {
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= count; i += 8) {
+            __m128i h = _mm_loadu_si128((const __m128i*) (pSrc + i));
+            _mm_storeu_ps(pDst + i, halfToFloatSSE2(_mm_unpacklo_epi16(h, zero)));
+            _mm_storeu_ps(pDst + i + 4, halfToFloatSSE2(_mm_unpackhi_epi16(h, zero)));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        pDst[i] = halfToFloat(pSrc[i]);
+    }
+}
+
+// Channel conversions
+
+#ifdef OGU_IMAGE_AVX2
+
+OGU_TARGET_AVX2 static size_t expandRGB8ToRGBA8AVX2(const uint8_t* pSrc, uint8_t* pDst, size_t pixels, uint8_t alpha) {
+    // 4 pixels per shuffle; reads 16 bytes for 12, so stop early enough not to read past the end
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alphaMask = _mm_set1_epi32((int32_t) ((uint32_t) alpha << 24));
+    size_t i = 0;
+    for (; i + 6 <= pixels; i += 4) {
+        __m128i rgb = _mm_loadu_si128((const __m128i*) (pSrc + i * 3));
+        _mm_storeu_si128((__m128i*) (pDst + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alphaMask));
+    }
+    return i;
+}
+
+#endif
+
+void expandRGB8ToRGBA8(const uint8_t* pSrc, uint8_t* pDst, size_t pixels, uint8_t alpha) {
+    size_t i = 0;
+#ifdef OGU_IMAGE_AVX2
+    if (s_active == simd_level::AVX2) i = expandRGB8ToRGBA8AVX2(pSrc, pDst, pixels, alpha);
+#endif
+    for (; i < pixels; ++i) {
+        pDst[i * 4 + 0] = pSrc[i * 3 + 0];
+        pDst[i * 4 + 1] = pSrc[i * 3 + 1];
+        pDst[i * 4 + 2] = pSrc[i * 3 + 2];
+        pDst[i * 4 + 3] = alpha;
+    }
+}
+
+#ifdef OGU_IMAGE_AVX2
+
+// 4 pixels per byte shuffle, returns how many pixels were done. Each step loads and stores 16 bytes
+// whatever the channel counts, so it stops while the full 16 still lie inside both images.
+OGU_TARGET_AVX2 static size_t swizzle8AVX2(const uint8_t* pSrc, uint32_t srcComponents, uint8_t* pDst,
+        uint32_t dstComponents, const uint8_t* pSwizzle, size_t pixels) {
+    alignas(16) int8_t shuffle[16], ones[16];
+    for (uint32_t b = 0; b < 16; ++b) {
+        uint32_t pixel = b / dstComponents, c = b % dstComponents;
+        uint8_t sw = pSwizzle[c];
+        bool inPixel = pixel < 4;
+        shuffle[b] = (inPixel && sw < SWIZZLE_ZERO) ? (int8_t) (pixel * srcComponents + sw) : (int8_t) -1;
+        ones[b] = (inPixel && sw == SWIZZLE_ONE) ? (int8_t) -1 : 0;
+    }
+    const __m128i s = _mm_load_si128((const __m128i*) shuffle), o = _mm_load_si128((const __m128i*) ones);
+    size_t i = 0;
+    for (; i + 4 <= pixels && (i * srcComponents + 16 <= pixels * srcComponents)
+            && (i * dstComponents + 16 <= pixels * dstComponents); i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (pSrc + i * srcComponents));
+        _mm_storeu_si128((__m128i*) (pDst + i * dstComponents), _mm_or_si128(_mm_shuffle_epi8(v, s), o));
+    }
+    return i;
+}
+
+#endif
+
+void swizzle8(const uint8_t* pSrc, uint32_t srcComponents, uint8_t* pDst, uint32_t dstComponents,
+        const uint8_t* pSwizzle, size_t pixels) {
+    if (srcComponents == 3 && dstComponents == 4 && pSwizzle[0] == 0 && pSwizzle[1] == 1 && pSwizzle[2] == 2
+            && pSwizzle[3] >= SWIZZLE_ZERO) {
+        expandRGB8ToRGBA8(pSrc, pDst, pixels, pSwizzle[3] == SWIZZLE_ONE ? 255 : 0);
+        return;
+    }
+    for (uint32_t c = 0; c < dstComponents; ++c) {
+        if (pSwizzle[c] < SWIZZLE_ZERO && pSwizzle[c] >= srcComponents) {
+            throw std::invalid_argument("Swizzle reads a channel the source doesn't have.");
+        }
+    }
+    size_t i = 0;
+#ifdef OGU_IMAGE_AVX2
+    if (s_active == simd_level::AVX2) i = swizzle8AVX2(pSrc, srcComponents, pDst, dstComponents, pSwizzle, pixels);
+#endif
+    for (; i < pixels; ++i) {
+        const uint8_t* s = pSrc + i * srcComponents;
+        uint8_t* d = pDst + i * dstComponents;
+        for (uint32_t c = 0; c < dstComponents; ++c) {
+            uint8_t sw = pSwizzle[c];
+            d[c] = (sw == SWIZZLE_ZERO) ? 0 : (sw == SWIZZLE_ONE) ? 255 : s[sw];
+        }
+    }
+}
+
+// 8-bit <-> float
+
+static void u8ToFloat(const uint8_t* pSrc, float* pDst, size_t count) {
+    const float scale = 1.0f / 255.0f;
+    size_t i = 0;
+#ifdef OGU_IMAGE_SSE2
+    if (s_active >= simd_level::SSE2) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 s = _mm_set1_ps(scale);
+        for (; i + 16 <= count; i += 16) {
+            __m128i b = _mm_loadu_si128((const __m128i*) (pSrc + i));
+            __m128i lo = _mm_unpacklo_epi8(b, zero), hi = _mm_unpackhi_epi8(b, zero);
+            _mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), s));
+            _mm_storeu_ps(pDst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), s));
+            _mm_storeu_ps(pDst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), s));
+            _mm_storeu_ps(pDst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), s));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        pDst[i] = pSrc[i] * scale;
+    }
+}
+
+static void floatToU8(const float* pSrc, uint8_t* pDst, size_t count) {
+    size_t i = 0;
+#ifdef OGU_IMAGE_SSE2
+    if (s_active >= simd_level::SSE2) {
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), s = _mm_set1_ps(255.0f);
+        auto convert = [&] (const float* p) {
+            __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p), zero), one);
+            return _mm_cvtps_epi32(_mm_mul_ps(v, s));
+        };
+        for (; i + 16 <= count; i += 16) {
+            __m128i lo = _mm_packs_epi32(convert(pSrc + i), convert(pSrc + i + 4));
+            __m128i hi = _mm_packs_epi32(convert(pSrc + i + 8), convert(pSrc + i + 12));
+            _mm_storeu_si128((__m128i*) (pDst + i), _mm_packus_epi16(lo, hi));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        pDst[i] = (uint8_t) std::lrint(std::min(std::max(pSrc[i], 0.0f), 1.0f) * 255.0f);
+    }
+}
+
+// sRGB transfer function through tables, fine enough that every 8-bit value round-trips
+static constexpr size_t SRGB_ENCODE_SIZE = 16384;
+
+struct srgb_tables {
+    float decode[512];  // sRGB colour, then linear alpha at 256 + value
+    uint8_t encode[SRGB_ENCODE_SIZE + 3];  // padded so 32-bit gathers of the last entries stay inside
+
+    srgb_tables() {
+        for (int i = 0; i < 256; ++i) {
+            float c = i / 255.0f;
+            decode[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            decode[256 + i] = i * (1.0f / 255.0f);
+        }
+        for (size_t i = 0; i < SRGB_ENCODE_SIZE; ++i) {
+            float l = (float) i / (SRGB_ENCODE_SIZE - 1);
+            float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            encode[i] = (uint8_t) std::lrint(std::min(std::max(c, 0.0f), 1.0f) * 255.0f);
+        }
+        encode[SRGB_ENCODE_SIZE] = encode[SRGB_ENCODE_SIZE + 1] = encode[SRGB_ENCODE_SIZE + 2] = 0;
+    }
+};
+
+static const srgb_tables& srgb() {
+    static const srgb_tables tables;
+    return tables;
+}
+
+#ifdef OGU_IMAGE_AVX2
+
+// The table lookups as gathers, 8 channels at a time. With 4 components every fourth channel is
+// alpha, which stays linear; fewer components are all colour. Returns how many channels were done.
+OGU_TARGET_AVX2 static size_t decodeSrgbAVX2(const uint8_t* pSrc, float* pDst, size_t count, uint32_t components) {
+    const float* decode = srgb().decode;
+    const __m256i alphaOffset = components == 4 ? _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256) : _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (pSrc + i))), alphaOffset);
+        _mm256_storeu_ps(pDst + i, _mm256_i32gather_ps(decode, index, 4));
+    }
+    return i;
+}
+
+OGU_TARGET_AVX2 static size_t encodeSrgbAVX2(const float* pSrc, uint8_t* pDst, size_t count, uint32_t components) {
+    const int* encode = (const int*) srgb().encode;
+    const __m256i isAlpha = components == 4 ? _mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1) : _mm256_setzero_si256();
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), half = _mm256_set1_ps(0.5f);
+    const __m256 tableScale = _mm256_set1_ps((float) (SRGB_ENCODE_SIZE - 1)), alphaScale = _mm256_set1_ps(255.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(pSrc + i), zero), one);
+        __m256i index = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, tableScale), half));
+        __m256i colour = _mm256_and_si256(_mm256_i32gather_epi32(encode, index, 1), _mm256_set1_epi32(0xff));
+        __m256i alpha = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, alphaScale), half));
+        __m256i value = _mm256_blendv_epi8(colour, alpha, isAlpha);
+        __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+        _mm_storel_epi64((__m128i*) (pDst + i), _mm_packus_epi16(words, words));
+    }
+    return i;
+}
+
+#endif
+
+// Formats
+
+enum class pixel_type {
+    UNORM8,
+    FLOAT16,
+    FLOAT32
+};
+
+bool supportsFormat(const Texture::Format& format) {
+    if (!Texture::Format::validate(format)) return false;
+    if (format.isFloatingPoint) return format.bitsPerComponent == 16 || format.bitsPerComponent == 32;
+    return format.bitsPerComponent == 8 && format.isNormalized && !format.isSigned;
+}
+
+static pixel_type getPixelType(const Texture::Format& format) {
+    if (!supportsFormat(format)) throw std::invalid_argument("Texture format isn't supported by image_ops.");
+    if (!format.isFloatingPoint) return pixel_type::UNORM8;
+    return format.bitsPerComponent == 16 ? pixel_type::FLOAT16 : pixel_type::FLOAT32;
+}
+
+// One row of pixels into linear floats
+static void decodeRow(const void* pSrc, float* pDst, uint32_t pixels, uint32_t components, pixel_type type, bool srgbEncoded) {
+    size_t count = (size_t) pixels * components;
+    switch (type) {
+    case pixel_type::UNORM8: {
+        const uint8_t* p = static_cast<const uint8_t*>(pSrc);
+        if (!srgbEncoded) {
+            u8ToFloat(p, pDst, count);
+            break;
+        }
+        const float* decode = srgb().decode;
+        size_t i = 0;
+#ifdef OGU_IMAGE_AVX2
+        if (s_active == simd_level::AVX2) i = decodeSrgbAVX2(p, pDst, count, components);
+#endif
+        for (; i < count; ++i) {
+            pDst[i] = decode[(components == 4 && i % 4 == 3) ? 256 + p[i] : p[i]];
+        }
+        break;
+    }
+    case pixel_type::FLOAT16:
+        halfToFloat(static_cast<const uint16_t*>(pSrc), pDst, count);
+        break;
+    case pixel_type::FLOAT32:
+        std::memcpy(pDst, pSrc, count * sizeof(float));
+        break;
+    }
+}
+
+static void encodeRow(const float* pSrc, void* pDst, uint32_t pixels, uint32_t components, pixel_type type, bool srgbEncoded) {
+    size_t count = (size_t) pixels * components;
+    switch (type) {
+    case pixel_type::UNORM8: {
+        uint8_t* p = static_cast<uint8_t*>(pDst);
+        if (!srgbEncoded) {
+            floatToU8(pSrc, p, count);
+            break;
+        }
+        const uint8_t* encode = srgb().encode;
+        size_t i = 0;
+#ifdef OGU_IMAGE_AVX2
+        if (s_active == simd_level::AVX2) i = encodeSrgbAVX2(pSrc, p, count, components);
+#endif
+        for (; i < count; ++i) {
+            float v = std::min(std::max(pSrc[i], 0.0f), 1.0f);
+            p[i] = (components == 4 && i % 4 == 3) ? (uint8_t) (v * 255.0f + 0.5f)
+                : encode[(size_t) (v * (SRGB_ENCODE_SIZE - 1) + 0.5f)];
+        }
+        break;
+    }
+    case pixel_type::FLOAT16:
+        floatToHalf(pSrc, static_cast<uint16_t*>(pDst), count);
+        break;
+    case pixel_type::FLOAT32:
+        std::memcpy(pDst, pSrc, count * sizeof(float));
+        break;
+    }
+}
+
+// Resampling
+
+// For each destination texel, a fixed number of (clamped) source indices and weights summing to 1
+struct filter_taps {
+    uint32_t count;
+    std::vector<uint32_t> index;
+    std::vector<float> weight;
+};
+
+static constexpr double PI = 3.14159265358979323846;
+
+static double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+static filter_taps makeTaps(uint32_t srcSize, uint32_t dstSize, mip_filter filter) {
+    const double scale = (double) srcSize / dstSize;
+    const double radius = (filter == mip_filter::BOX) ? 0.5 * scale : 3.0 * scale;
+    const double beta = 4.0;
+    const double i0Beta = besselI0(beta);
+
+    // weights over a generous window first, then trimmed to the widest run of non-zero ones
+    const uint32_t window = (uint32_t) std::ceil(2.0 * radius) + 2;
+    std::vector<double> w((size_t) dstSize * window);
+    std::vector<int64_t> first(dstSize);
+    std::vector<uint32_t> lead(dstSize), span(dstSize);
+    uint32_t count = 1;
+    for (uint32_t x = 0; x < dstSize; ++x) {
+        double center = (x + 0.5) * scale;
+        first[x] = (int64_t) std::floor(center - radius) - 1;
+        double sum = 0.0;
+        double* wx = &w[(size_t) x * window];
+        for (uint32_t k = 0; k < window; ++k) {
+            int64_t i = first[x] + k;
+            if (filter == mip_filter::BOX) {
+                // overlap of texel [i, i + 1) with the footprint
+                double lo = std::max<double>(i, center - radius), hi = std::min<double>(i + 1, center + radius);
+                wx[k] = std::max(hi - lo, 0.0);
+            } else {
+                double t = (i + 0.5 - center) / scale;
+                double r = t / 3.0;
+                if (std::abs(r) >= 1.0) {
+                    wx[k] = 0.0;
+                } else {
+                    double sinc = (t == 0.0) ? 1.0 : std::sin(PI * t) / (PI * t);
+                    wx[k] = sinc * besselI0(beta * std::sqrt(1.0 - r * r)) / i0Beta;
+                }
+            }
+            sum += wx[k];
+        }
+        uint32_t begin = 0, end = window;
+        while (begin < end && std::abs(wx[begin]) < 1e-9) ++begin;
+        while (end > begin && std::abs(wx[end - 1]) < 1e-9) --end;
+        for (uint32_t k = begin; k < end; ++k) {
+            wx[k] = (sum != 0.0) ? wx[k] / sum : 0.0;
+        }
+        lead[x] = begin;
+        span[x] = end - begin;
+        count = std::max(count, end - begin);
+    }
+
+    filter_taps taps;
+    taps.count = count;
+    taps.index.assign((size_t) dstSize * count, 0);
+    taps.weight.assign((size_t) dstSize * count, 0.0f);
+    for (uint32_t x = 0; x < dstSize; ++x) {
+        for (uint32_t k = 0; k < span[x]; ++k) {
+            int64_t i = first[x] + lead[x] + k;
+            taps.index[(size_t) x * count + k] = (uint32_t) std::min<int64_t>(std::max<int64_t>(i, 0), srcSize - 1);
+            taps.weight[(size_t) x * count + k] = (float) w[(size_t) x * window + lead[x] + k];
+        }
+        // padding taps keep weight 0 and point at a valid texel
+        for (uint32_t k = span[x]; k < count; ++k) {
+            taps.index[(size_t) x * count + k] = taps.index[(size_t) x * count];
+        }
+    }
+    return taps;
+}
+
+// pDst[i] = sum over k of pWeights[k] * ppRows[k][i]
+static void weightedSumScalar(float* pDst, const float* const* ppRows, const float* pWeights, uint32_t n, size_t begin, size_t count) {
+    for (size_t i = begin; i < count; ++i) {
+        float sum = 0.0f;
+        for (uint32_t k = 0; k < n; ++k) {
+            sum += pWeights[k] * ppRows[k][i];
+        }
+        pDst[i] = sum;
+    }
+}
+
+#ifdef OGU_IMAGE_AVX2
+
+OGU_TARGET_AVX2 static void weightedSumAVX2(float* pDst, const float* const* ppRows, const float* pWeights, uint32_t n, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (uint32_t k = 0; k < n; ++k) {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(pWeights[k]), _mm256_loadu_ps(ppRows[k] + i)));
+        }
+        _mm256_storeu_ps(pDst + i, sum);
+    }
+    weightedSumScalar(pDst, ppRows, pWeights, n, i, count);
+}
+
+#endif
+
+static void weightedSum(float* pDst, const float* const* ppRows, const float* pWeights, uint32_t n, size_t count) {
+#ifdef OGU_IMAGE_AVX2
+    if (s_active == simd_level::AVX2) {
+        weightedSumAVX2(pDst, ppRows, pWeights, n, count);
+        return;
+    }
+#endif
+    size_t i = 0;
+#ifdef OGU_IMAGE_SSE2
+    if (s_active >= simd_level::SSE2) {
+        for (; i + 4 <= count; i += 4) {
+            __m128 sum = _mm_setzero_ps();
+            for (uint32_t k = 0; k < n; ++k) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(pWeights[k]), _mm_loadu_ps(ppRows[k] + i)));
+            }
+            _mm_storeu_ps(pDst + i, sum);
+        }
+    }
+#endif
+    weightedSumScalar(pDst, ppRows, pWeights, n, i, count);
+}
+
+// Runs fn(begin, end) over [0, rows) split across threads, on this thread alone for small jobs
+template<typename Fn>
+static void parallelRows(uint32_t rows, size_t workPerRow, uint32_t threads, const Fn& fn) {
+    constexpr size_t MIN_WORK_PER_THREAD = 1 << 15;
+    size_t useful = std::max<size_t>((size_t) rows * workPerRow / MIN_WORK_PER_THREAD, 1);
+    uint32_t n = (uint32_t) std::min<size_t>(std::min<size_t>(threads, useful), rows);
+    if (n <= 1) {
+        fn(0u, rows);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(n - 1);
+    uint32_t per = (rows + n - 1) / n;
+    for (uint32_t t = 1; t < n; ++t) {
+        uint32_t begin = std::min(rows, t * per), end = std::min(rows, begin + per);
+        if (begin < end) workers.emplace_back(fn, begin, end);
+    }
+    fn(0u, std::min(rows, per));
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+// One row, horizontally, with the channel count known so the inner loops unroll
+template<uint32_t C>
+static void filterRowScalar(const float* pSrc, float* pDst, uint32_t begin, uint32_t dstWidth, const filter_taps& taps) {
+    for (uint32_t x = begin; x < dstWidth; ++x) {
+        const uint32_t* idx = &taps.index[(size_t) x * taps.count];
+        const float* w = &taps.weight[(size_t) x * taps.count];
+        float sum[C] = {};
+        for (uint32_t k = 0; k < taps.count; ++k) {
+            const float* p = pSrc + (size_t) idx[k] * C;
+            for (uint32_t c = 0; c < C; ++c) {
+                sum[c] += w[k] * p[c];
+            }
+        }
+        for (uint32_t c = 0; c < C; ++c) {
+            pDst[(size_t) x * C + c] = sum[c];
+        }
+    }
+}
+
+#ifdef OGU_IMAGE_SSE2
+
+// The same sums in the same order as filterRowScalar, so the results are identical. A pixel per
+// vector for 3 and 4 components, two or four pixels side by side for 2 and 1.
+template<uint32_t C>
+static uint32_t filterRowSSE2(const float* pSrc, uint32_t srcWidth, float* pDst, uint32_t dstWidth,
+        const filter_taps& taps);
+
+template<>
+uint32_t filterRowSSE2<4>(const float* pSrc, uint32_t, float* pDst, uint32_t dstWidth, const filter_taps& taps) {
+    for (uint32_t x = 0; x < dstWidth; ++x) {
+        const uint32_t* idx = &taps.index[(size_t) x * taps.count];
+        const float* w = &taps.weight[(size_t) x * taps.count];
+        __m128 sum = _mm_setzero_ps();
+        for (uint32_t k = 0; k < taps.count; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(pSrc + (size_t) idx[k] * 4)));
+        }
+        _mm_storeu_ps(pDst + (size_t) x * 4, sum);
+    }
+    return dstWidth;
+}
+
+template<>
+uint32_t filterRowSSE2<3>(const float* pSrc, uint32_t srcWidth, float* pDst, uint32_t dstWidth,
+        const filter_taps& taps) {
+    // loads and stores take a fourth float from the next pixel, except at the end of the row
+    if (dstWidth == 0) return 0;
+    for (uint32_t x = 0; x + 1 < dstWidth; ++x) {
+        const uint32_t* idx = &taps.index[(size_t) x * taps.count];
+        const float* w = &taps.weight[(size_t) x * taps.count];
+        __m128 sum = _mm_setzero_ps();
+        for (uint32_t k = 0; k < taps.count; ++k) {
+            const float* p = pSrc + (size_t) idx[k] * 3;
+            __m128 v = (idx[k] + 1 < srcWidth) ? _mm_loadu_ps(p) : _mm_setr_ps(p[0], p[1], p[2], 0.0f);
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[k]), v));
+        }
+        _mm_storeu_ps(pDst + (size_t) x * 3, sum);
+    }
+    return dstWidth - 1;
+}
+
+template<>
+uint32_t filterRowSSE2<2>(const float* pSrc, uint32_t, float* pDst, uint32_t dstWidth, const filter_taps& taps) {
+    uint32_t x = 0;
+    for (; x + 2 <= dstWidth; x += 2) {
+        const uint32_t* idx = &taps.index[(size_t) x * taps.count];
+        const float* w = &taps.weight[(size_t) x * taps.count];
+        __m128 sum = _mm_setzero_ps();
+        for (uint32_t k = 0; k < taps.count; ++k) {
+            __m128 v = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*) (pSrc + (size_t) idx[k] * 2));
+            v = _mm_loadh_pi(v, (const __m64*) (pSrc + (size_t) idx[taps.count + k] * 2));
+            __m128 weight = _mm_setr_ps(w[k], w[k], w[taps.count + k], w[taps.count + k]);
+            sum = _mm_add_ps(sum, _mm_mul_ps(weight, v));
+        }
+        _mm_storeu_ps(pDst + (size_t) x * 2, sum);
+    }
+    return x;
+}
+
+template<>
+uint32_t filterRowSSE2<1>(const float* pSrc, uint32_t, float* pDst, uint32_t dstWidth, const filter_taps& taps) {
+    const uint32_t n = taps.count;
+    uint32_t x = 0;
+    for (; x + 4 <= dstWidth; x += 4) {
+        const uint32_t* idx = &taps.index[(size_t) x * n];
+        const float* w = &taps.weight[(size_t) x * n];
+        __m128 sum = _mm_setzero_ps();
+        for (uint32_t k = 0; k < n; ++k) {
+            __m128 v = _mm_setr_ps(pSrc[idx[k]], pSrc[idx[n + k]], pSrc[idx[2 * n + k]], pSrc[idx[3 * n + k]]);
+            __m128 weight = _mm_setr_ps(w[k], w[n + k], w[2 * n + k], w[3 * n + k]);
+            sum = _mm_add_ps(sum, _mm_mul_ps(weight, v));
+        }
+        _mm_storeu_ps(pDst + x, sum);
+    }
+    return x;
+}
+
+#endif
+
+template<uint32_t C>
+static void filterRow(const float* pSrc, uint32_t srcWidth, float* pDst, uint32_t dstWidth, const filter_taps& taps) {
+    uint32_t x = 0;
+#ifdef OGU_IMAGE_SSE2
+    if (s_active >= simd_level::SSE2) x = filterRowSSE2<C>(pSrc, srcWidth, pDst, dstWidth, taps);
+#endif
+    filterRowScalar<C>(pSrc, pDst, x, dstWidth, taps);
+}
+
+// Separable resample of linear float pixels: horizontally into scratch, then vertically
+static void resample(const float* pSrc, uint32_t width, uint32_t height, uint32_t components,
+        float* pDst, uint32_t dstWidth, uint32_t dstHeight, mip_filter filter, uint32_t threads, std::vector<float>& scratch) {
+    filter_taps hTaps = makeTaps(width, dstWidth, filter);
+    filter_taps vTaps = makeTaps(height, dstHeight, filter);
+    const size_t srcRow = (size_t) width * components;
+    const size_t dstRow = (size_t) dstWidth * components;
+    scratch.resize(dstRow * height);
+
+    parallelRows(height, srcRow, threads, [&] (uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            const float* s = pSrc + y * srcRow;
+            float* d = scratch.data() + y * dstRow;
+            switch (components) {
+            case 1: filterRow<1>(s, width, d, dstWidth, hTaps); break;
+            case 2: filterRow<2>(s, width, d, dstWidth, hTaps); break;
+            case 3: filterRow<3>(s, width, d, dstWidth, hTaps); break;
+            default: filterRow<4>(s, width, d, dstWidth, hTaps); break;
+            }
+        }
+    });
+
+    parallelRows(dstHeight, dstRow * vTaps.count, threads, [&] (uint32_t begin, uint32_t end) {
+        std::vector<const float*> rows(vTaps.count);
+        for (uint32_t y = begin; y < end; ++y) {
+            for (uint32_t k = 0; k < vTaps.count; ++k) {
+                rows[k] = scratch.data() + vTaps.index[(size_t) y * vTaps.count + k] * dstRow;
+            }
+            weightedSum(pDst + y * dstRow, rows.data(), &vTaps.weight[(size_t) y * vTaps.count], vTaps.count, dstRow);
+        }
+    });
+}
+
+std::vector<mip_level> generateMipmaps(const void* pLevel0, uint32_t width, uint32_t height,
+        const Texture::Format& format, const mip_options& options) {
+    const pixel_type type = getPixelType(format);
+    const uint32_t components = format.components;
+    const size_t bytesPerPixel = components * format.bitsPerComponent / 8;
+    const bool srgbEncoded = options.srgb && type == pixel_type::UNORM8;
+    const uint32_t threads = options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1) {
+        ++levels;
+    }
+    if (options.levels) levels = std::min(levels, options.levels);
+
+    std::vector<mip_level> result;
+    if (levels <= 1 || width == 0 || height == 0) return result;
+    result.reserve(levels - 1);
+
+    std::vector<float> current((size_t) width * height * components);
+    std::vector<float> next, scratch;
+    parallelRows(height, (size_t) width * components, threads, [&] (uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            decodeRow(static_cast<const uint8_t*>(pLevel0) + y * width * bytesPerPixel,
+                current.data() + (size_t) y * width * components, width, components, type, srgbEncoded);
+        }
+    });
+
+    for (uint32_t level = 1; level < levels; ++level) {
+        uint32_t dstWidth = std::max(width / 2, 1u), dstHeight = std::max(height / 2, 1u);
+        next.resize((size_t) dstWidth * dstHeight * components);
+        resample(current.data(), width, height, components, next.data(), dstWidth, dstHeight, options.filter, threads, scratch);
+
+        mip_level out;
+        out.width = dstWidth;
+        out.height = dstHeight;
+        out.data.resize((size_t) dstWidth * dstHeight * bytesPerPixel);
+        parallelRows(dstHeight, (size_t) dstWidth * components, threads, [&] (uint32_t begin, uint32_t end) {
+            for (uint32_t y = begin; y < end; ++y) {
+                encodeRow(next.data() + (size_t) y * dstWidth * components, out.data.data() + y * dstWidth * bytesPerPixel,
+                    dstWidth, components, type, srgbEncoded);
+            }
+        });
+        result.push_back(std::move(out));
+
+        std::swap(current, next);
+        width = dstWidth;
+        height = dstHeight;
+    }
+    return result;
+}
+
+void uploadMipmaps(Texture& texture, const std::vector<mip_level>& levels, uint32_t firstLevel) {
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const mip_level& l = levels[i];
+        texture.writeSubPixels(firstLevel + (uint32_t) i, 0, 0, 0, l.width, l.height, 1, l.data.data());
+    }
+}
+
+}  // namespace image_ops
+}  // namespace ogu
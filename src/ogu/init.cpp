@@ -0,0 +1,34 @@
+#include "init.h"
+
+#include <stdexcept>
+
+
+namespace ogu {
+
+namespace detail {
+features _features {};
+}  // namespace detail
+
+void init(bool allowDirectStateAccess) {
+    if (glewInit() != GLEW_OK)
+        throw std::runtime_error("Failed to initialize.");
+#ifdef OGU_GL_DISPATCH
+    gl::loadDispatchTable();
+#endif
+
+    features& f = detail::_features;
+    f.directStateAccess = allowDirectStateAccess && (GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access);
+    f.parallelShaderCompile = GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+    f.programInterfaceQuery = GLEW_VERSION_4_3 || GLEW_ARB_program_interface_query;
+    f.vertexAttribBinding = GLEW_VERSION_4_3 || GLEW_ARB_vertex_attrib_binding;
+    f.multiDrawIndirect = GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+    f.baseInstance = GLEW_VERSION_4_2 || GLEW_ARB_base_instance;
+    f.shaderStorageBuffer = GLEW_VERSION_4_3 || GLEW_ARB_shader_storage_buffer_object;
+    f.shaderDrawParameters = GLEW_VERSION_4_6 || GLEW_ARB_shader_draw_parameters;
+    f.timerQuery = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    f.copyImage = GLEW_VERSION_4_3 || GLEW_ARB_copy_image;
+    f.gpuMemoryInfoNVX = GLEW_NVX_gpu_memory_info;
+    f.memInfoATI = GLEW_ATI_meminfo;
+}
+
+}  // namespace ogu
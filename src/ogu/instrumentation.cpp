@@ -0,0 +1,147 @@
+#include "instrumentation.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+
+namespace ogu {
+namespace instrumentation {
+
+static std::atomic<uint64_t> s_frame { 0 };
+static std::atomic<uint64_t> s_calls[CATEGORY_COUNT] {};
+static std::atomic<uint64_t> s_bytesUploaded { 0 };
+static std::atomic<int64_t> s_liveObjects[OBJECT_TYPE_COUNT] {};
+static std::atomic<int64_t> s_memoryBytes[OBJECT_TYPE_COUNT] {};
+
+static snapshot s_lastFrame {};
+
+void countCalls(category c, uint64_t n) {
+    s_calls[(size_t) c].fetch_add(n, std::memory_order_relaxed);
+}
+
+void countUpload(uint64_t bytes) {
+    s_bytesUploaded.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void objectCreated(object_type type, int64_t bytes) {
+    countCalls(category::OBJECT, 1);
+    s_liveObjects[(size_t) type].fetch_add(1, std::memory_order_relaxed);
+    s_memoryBytes[(size_t) type].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void objectDestroyed(object_type type, int64_t bytes) {
+    countCalls(category::OBJECT, 1);
+    s_liveObjects[(size_t) type].fetch_sub(1, std::memory_order_relaxed);
+    s_memoryBytes[(size_t) type].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void objectResized(object_type type, int64_t oldBytes, int64_t newBytes) {
+    s_memoryBytes[(size_t) type].fetch_add(newBytes - oldBytes, std::memory_order_relaxed);
+}
+
+snapshot current() {
+    snapshot s {};
+    s.frame = s_frame.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < CATEGORY_COUNT; ++i) {
+        s.calls[i] = s_calls[i].load(std::memory_order_relaxed);
+    }
+    s.bytesUploaded = s_bytesUploaded.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < OBJECT_TYPE_COUNT; ++i) {
+        s.liveObjects[i] = s_liveObjects[i].load(std::memory_order_relaxed);
+        s.memoryBytes[i] = s_memoryBytes[i].load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+void endFrame() {
+    snapshot s {};
+    s.frame = s_frame.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < CATEGORY_COUNT; ++i) {
+        s.calls[i] = s_calls[i].exchange(0, std::memory_order_relaxed);
+    }
+    s.bytesUploaded = s_bytesUploaded.exchange(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < OBJECT_TYPE_COUNT; ++i) {
+        s.liveObjects[i] = s_liveObjects[i].load(std::memory_order_relaxed);
+        s.memoryBytes[i] = s_memoryBytes[i].load(std::memory_order_relaxed);
+    }
+    s_lastFrame = s;
+}
+
+const snapshot& lastFrame() {
+    return s_lastFrame;
+}
+
+const char* name(category c) {
+    static const char* const names[CATEGORY_COUNT] = { "bind", "uniform", "draw", "upload", "object" };
+    return names[(size_t) c];
+}
+
+const char* name(object_type type) {
+    static const char* const names[OBJECT_TYPE_COUNT] = { "buffer", "texture", "vertex_array", "shader", "program" };
+    return names[(size_t) type];
+}
+
+// snprintf that keeps going after the buffer is full, to report the full length
+class writer {
+private:
+
+    char* _pBuffer;
+    size_t _size;
+    size_t _length = 0;
+
+public:
+
+    writer(char* pBuffer, size_t size) :
+        _pBuffer(pBuffer), _size(size)
+    {
+        if (size > 0) pBuffer[0] = '\0';
+    }
+
+    void print(const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        size_t remaining = _length < _size ? _size - _length : 0;
+        int n = std::vsnprintf(remaining > 0 ? _pBuffer + _length : nullptr, remaining, format, args);
+        va_end(args);
+        if (n > 0) _length += (size_t) n;
+    }
+
+    inline size_t length() const {
+        return _length;
+    }
+
+};
+
+size_t writeText(const snapshot& s, char* pBuffer, size_t size) {
+    writer w(pBuffer, size);
+    w.print("frame %llu\n", (unsigned long long) s.frame);
+    w.print("calls:");
+    for (size_t i = 0; i < CATEGORY_COUNT; ++i) {
+        w.print(" %s %llu", name((category) i), (unsigned long long) s.calls[i]);
+    }
+    w.print("\nuploaded %llu bytes\n", (unsigned long long) s.bytesUploaded);
+    for (size_t i = 0; i < OBJECT_TYPE_COUNT; ++i) {
+        w.print("%s: %lld live, %lld bytes\n", name((object_type) i),
+            (long long) s.liveObjects[i], (long long) s.memoryBytes[i]);
+    }
+    return w.length();
+}
+
+size_t writeJson(const snapshot& s, char* pBuffer, size_t size) {
+    writer w(pBuffer, size);
+    w.print("{\"frame\":%llu,\"calls\":{", (unsigned long long) s.frame);
+    for (size_t i = 0; i < CATEGORY_COUNT; ++i) {
+        w.print("%s\"%s\":%llu", i ? "," : "", name((category) i), (unsigned long long) s.calls[i]);
+    }
+    w.print("},\"bytesUploaded\":%llu,\"objects\":{", (unsigned long long) s.bytesUploaded);
+    for (size_t i = 0; i < OBJECT_TYPE_COUNT; ++i) {
+        w.print("%s\"%s\":{\"live\":%lld,\"bytes\":%lld}", i ? "," : "", name((object_type) i),
+            (long long) s.liveObjects[i], (long long) s.memoryBytes[i]);
+    }
+    w.print("}}");
+    return w.length();
+}
+
+}  // namespace instrumentation
+}  // namespace ogu
@@ -0,0 +1,279 @@
+#include "loader_context.h"
+
+#include "image_ops.h"
+#include "pending_program.h"
+#include "state_cache.h"
+#include "texture_file.h"
+
+#include <algorithm>
+
+#ifdef OGU_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#endif
+
+
+namespace ogu {
+
+namespace detail {
+
+load_state::~load_state() {
+    if (_fence) glDeleteSync(_fence);
+}
+
+bool load_state::ready() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _finished;
+}
+
+void load_state::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _finished; });
+}
+
+void load_state::finish(GLsync fence, std::exception_ptr error) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _fence = fence;
+        _error = error;
+        _finished = true;
+    }
+    _done.notify_all();
+}
+
+void load_state::acquire() {
+    wait();
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_error) std::rethrow_exception(_error);
+    if (_fence) {
+        // deletion is deferred by GL until the wait has been satisfied
+        glWaitSync(_fence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(_fence);
+        _fence = 0;
+    }
+}
+
+}  // namespace detail
+
+loader_context::loader_context(std::function<void()> makeCurrent, std::function<void()> release) :
+        _makeCurrent(std::move(makeCurrent)), _release(std::move(release)) {
+    std::promise<void> started;
+    std::future<void> result = started.get_future();
+    _thread = std::thread(&loader_context::workerMain, this, std::ref(started));
+    try {
+        result.get();
+    } catch (...) {
+        _thread.join();
+        throw;
+    }
+}
+
+loader_context::~loader_context() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_one();
+    _thread.join();
+}
+
+void loader_context::workerMain(std::promise<void>& started) {
+    try {
+        _makeCurrent();
+    } catch (...) {
+        if (_release) _release();
+        started.set_exception(std::current_exception());
+        return;
+    }
+    // everything uploaded here is tightly packed
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    started.set_value();
+
+    for (;;) {
+        job j;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+            if (_stopping) break;
+            j = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        // Other threads delete objects without this thread's cache knowing, and their names get reused
+        state_cache::current().invalidate();
+        clock::time_point start = clock::now();
+        GLsync fence = 0;
+        std::exception_ptr error;
+        try {
+            j.run(j.bytes);
+            fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            // the render context can only wait on a fence that has reached the GPU
+            glFlush();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        clock::time_point end = clock::now();
+        j.state->finish(fence, error);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        accumulator& a = _accumulators[(size_t) j.type];
+        double latencyMs = std::chrono::duration<double, std::milli>(end - j.submitted).count();
+        if (error) {
+            ++a.failed;
+        } else {
+            ++a.completed;
+            a.bytes += j.bytes;
+            a.latencyMs += latencyMs;
+            a.maxLatencyMs = std::max(a.maxLatencyMs, latencyMs);
+        }
+        a.runMs += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    std::deque<job> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        cancelled.swap(_jobs);
+    }
+    for (job& j : cancelled) {
+        j.state->finish(0, std::make_exception_ptr(std::runtime_error("loader_context destroyed before the job ran.")));
+    }
+    // the last references to unclaimed results may go here, while the context is still current
+    cancelled.clear();
+    if (_release) _release();
+}
+
+void loader_context::enqueue(job j) {
+    j.submitted = clock::now();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stopping) throw std::logic_error("loader_context is shutting down.");
+        _jobs.push_back(std::move(j));
+    }
+    _wake.notify_one();
+}
+
+load_ticket<buffer> loader_context::createBuffer(std::vector<uint8_t> data, GLbitfield storageFlags) {
+    if (data.empty()) throw std::invalid_argument("Buffer data is empty.");
+    size_t size = data.size();
+    return submit<buffer>(job_type::BUFFER, [data = std::move(data), storageFlags] () {
+        return std::make_unique<buffer>(data.size(), storageFlags, data.data());
+    }, size);
+}
+
+load_ticket<Texture> loader_context::createTexture(std::string path) {
+    return submitSized<Texture>(job_type::TEXTURE, 0, [path = std::move(path)] (size_t& bytes) {
+        texture_file file(path);
+        bytes = file.fileSize();
+        return file.createTexture();
+    });
+}
+
+load_ticket<Texture> loader_context::createTexture(Texture::Dimension dimension, Texture::Format format, uint32_t levels,
+        uint32_t width, uint32_t height, uint32_t depth, std::vector<uint8_t> pixels) {
+    if (!Texture::Format::validate(format)) throw std::invalid_argument("Invalid texture format.");
+    size_t size = (size_t) width * height * depth * (format.components * format.bitsPerComponent / 8);
+    if (pixels.size() < size) throw std::invalid_argument("Not enough pixel data for the texture size.");
+    levels = std::max(levels, 1u);
+    return submit<Texture>(job_type::TEXTURE, [=, pixels = std::move(pixels)] () {
+        auto texture = std::make_unique<Texture>(dimension, format);
+        texture->allocateStorage(levels, width, height, depth);
+        texture->writeSubPixels(0, 0, 0, 0, width, height, depth, pixels.data());
+        if (levels > 1 && dimension == Texture::DIMENSION_2D && image_ops::supportsFormat(format)) {
+            image_ops::mip_options options;
+            options.levels = levels;
+            // a background loader shouldn't take every core from the frame
+            options.threads = 1;
+            image_ops::uploadMipmaps(*texture, image_ops::generateMipmaps(pixels.data(), width, height, format, options));
+        }
+        return texture;
+    }, size);
+}
+
+load_ticket<shader_program> loader_context::createProgram(std::vector<shader_source> stages) {
+    size_t size = 0;
+    for (const shader_source& stage : stages) {
+        for (const std::string& source : stage.sources) {
+            size += source.size();
+        }
+    }
+    return submit<shader_program>(job_type::PROGRAM, [stages = std::move(stages)] () {
+        pending_program pending(stages);
+        return std::make_unique<shader_program>(pending.get());
+    }, size);
+}
+
+loader_context::stats loader_context::getStats() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats s {};
+    for (size_t i = 0; i < JOB_TYPES; ++i) {
+        const accumulator& a = _accumulators[i];
+        job_stats& js = s.jobs[i];
+        js.completed = a.completed;
+        js.failed = a.failed;
+        js.bytes = a.bytes;
+        js.meanLatencyMs = a.completed ? a.latencyMs / (double) a.completed : 0.0;
+        js.maxLatencyMs = a.maxLatencyMs;
+        uint64_t jobs = a.completed + a.failed;
+        js.meanRunMs = jobs ? a.runMs / (double) jobs : 0.0;
+        js.jobsPerSecond = (a.runMs > 0.0) ? (double) a.completed * 1000.0 / a.runMs : 0.0;
+        js.bytesPerSecond = (a.runMs > 0.0) ? (double) a.bytes * 1000.0 / a.runMs : 0.0;
+    }
+    s.queued = _jobs.size();
+    return s;
+}
+
+#ifdef OGU_EGL
+std::unique_ptr<loader_context> loader_context::createSurfaceless(int majorVersion, int minorVersion, bool coreProfile) {
+    EGLDisplay display = eglGetCurrentDisplay();
+    EGLContext share = eglGetCurrentContext();
+    if (display == EGL_NO_DISPLAY || share == EGL_NO_CONTEXT) throw std::runtime_error("No current EGL context to share with.");
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!extensions || !std::strstr(extensions, "EGL_KHR_surfaceless_context")) {
+        throw std::runtime_error("EGL_KHR_surfaceless_context isn't supported.");
+    }
+
+    // same config and client API as the context being shared with
+    EGLint configId = 0, clientType = EGL_OPENGL_API;
+    eglQueryContext(display, share, EGL_CONFIG_ID, &configId);
+    eglQueryContext(display, share, EGL_CONTEXT_CLIENT_TYPE, &clientType);
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    if (configId != 0) {
+        const EGLint configAttribs[] = { EGL_CONFIG_ID, configId, EGL_NONE };
+        EGLint count = 0;
+        if (!eglChooseConfig(display, configAttribs, &config, 1, &count) || count == 0) config = EGL_NO_CONFIG_KHR;
+    }
+
+    std::vector<EGLint> attribs;
+    if (majorVersion > 0) {
+        attribs.insert(attribs.end(), { EGL_CONTEXT_MAJOR_VERSION, majorVersion, EGL_CONTEXT_MINOR_VERSION, minorVersion });
+    }
+    if (coreProfile && clientType == EGL_OPENGL_API) {
+        attribs.insert(attribs.end(), { EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT });
+    }
+    attribs.push_back(EGL_NONE);
+
+    EGLenum previousApi = eglQueryAPI();
+    eglBindAPI((EGLenum) clientType);
+    EGLContext context = eglCreateContext(display, config, share, attribs.data());
+    eglBindAPI(previousApi);
+    if (context == EGL_NO_CONTEXT) {
+        throw std::runtime_error("eglCreateContext failed with error " + std::to_string(eglGetError()) + ".");
+    }
+
+    return std::make_unique<loader_context>(
+        [display, context, clientType] () {
+            eglBindAPI((EGLenum) clientType);
+            if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+                throw std::runtime_error("eglMakeCurrent failed with error " + std::to_string(eglGetError()) + ".");
+            }
+        },
+        [display, context] () {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(display, context);
+        });
+}
+#endif
+
+}  // namespace ogu
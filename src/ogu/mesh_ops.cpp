@@ -0,0 +1,556 @@
+#include "mesh_ops.h"
+
+#include "hash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+
+namespace ogu {
+namespace mesh_ops {
+
+static constexpr uint32_t NONE = ~0u;
+
+cache_stats analyzeVertexCache(const uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+    cache_stats result {};
+    if (indexCount < 3 || vertexCount == 0) return result;
+
+    // a vertex is in the FIFO while fewer than cacheSize others were pushed after it
+    std::vector<uint32_t> pushedAt(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t time = cacheSize + 1;
+    size_t misses = 0, unique = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t v = pIndices[i];
+        if (time - pushedAt[v] > cacheSize) {
+            pushedAt[v] = time++;
+            ++misses;
+        }
+        if (!referenced[v]) {
+            referenced[v] = true;
+            ++unique;
+        }
+    }
+    result.acmr = (float) misses / (float) (indexCount / 3);
+    result.atvr = (float) misses / (float) unique;
+    return result;
+}
+
+static const float* position(const mesh& m, uint32_t v) {
+    return reinterpret_cast<const float*>(m.vertices.data() + (size_t) v * m.stride + m.positionOffset);
+}
+
+// Keeps the vertices that remap[v] == v and renumbers everything in their original order
+static void compact(mesh& m, std::vector<uint32_t>& remap) {
+    const size_t vertexCount = m.vertexCount();
+    uint32_t next = 0;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (remap[v] == v) {
+            if (next != v) std::memcpy(&m.vertices[(size_t) next * m.stride], &m.vertices[v * m.stride], m.stride);
+            remap[v] = next++;
+        } else {
+            remap[v] = remap[remap[v]];  // the kept vertex always comes first
+        }
+    }
+    m.vertices.resize((size_t) next * m.stride);
+    for (uint32_t& i : m.indices) {
+        i = remap[i];
+    }
+}
+
+size_t weldVertices(mesh& m, float epsilon) {
+    const size_t vertexCount = m.vertexCount();
+    const uint32_t stride = m.stride;
+    const bool snap = epsilon > 0.0f;
+    if (snap && m.positionOffset + 3 * sizeof(float) > stride) throw std::invalid_argument("Position outside the vertex.");
+
+    // snapped positions, or nothing when comparing whole vertices
+    std::vector<int64_t> grid(snap ? vertexCount * 3 : 0);
+    for (size_t v = 0; snap && v < vertexCount; ++v) {
+        float p[3];
+        std::memcpy(p, position(m, (uint32_t) v), sizeof(p));
+        for (int c = 0; c < 3; ++c) {
+            grid[v * 3 + c] = (int64_t) std::floor(p[c] / epsilon + 0.5f);
+        }
+    }
+    auto bytes = [&] (size_t v) {
+        return reinterpret_cast<const char*>(m.vertices.data() + v * stride);
+    };
+    // bytes before and after the position
+    const uint32_t posBegin = snap ? m.positionOffset : stride, posEnd = snap ? m.positionOffset + 3 * sizeof(float) : stride;
+    auto hashVertex = [&] (size_t v) {
+        uint64_t h = fnv1a(bytes(v), posBegin);
+        h = fnv1a(bytes(v) + posEnd, stride - posEnd, h);
+        if (snap) h = fnv1a(reinterpret_cast<const char*>(&grid[v * 3]), 3 * sizeof(int64_t), h);
+        return h;
+    };
+    auto equal = [&] (size_t a, size_t b) {
+        return std::memcmp(bytes(a), bytes(b), posBegin) == 0
+            && std::memcmp(bytes(a) + posEnd, bytes(b) + posEnd, stride - posEnd) == 0
+            && (!snap || std::memcmp(&grid[a * 3], &grid[b * 3], 3 * sizeof(int64_t)) == 0);
+    };
+
+    // open addressing, at most half full
+    size_t tableSize = 16;
+    while (tableSize < vertexCount * 2) {
+        tableSize *= 2;
+    }
+    std::vector<uint32_t> table(tableSize, NONE);
+    std::vector<uint32_t> remap(vertexCount);
+    size_t removed = 0;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        size_t slot = (size_t) hashVertex(v) & (tableSize - 1);
+        while (table[slot] != NONE && !equal(table[slot], v)) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if (table[slot] == NONE) {
+            table[slot] = (uint32_t) v;
+            remap[v] = (uint32_t) v;
+        } else {
+            remap[v] = table[slot];
+            ++removed;
+        }
+    }
+
+    compact(m, remap);
+
+    size_t out = 0;
+    for (size_t t = 0; t + 2 < m.indices.size(); t += 3) {
+        uint32_t a = m.indices[t], b = m.indices[t + 1], c = m.indices[t + 2];
+        if (a == b || b == c || c == a) continue;
+        m.indices[out++] = a;
+        m.indices[out++] = b;
+        m.indices[out++] = c;
+    }
+    m.indices.resize(out);
+    return removed;
+}
+
+// Triangles around each vertex, as offsets into one array
+struct adjacency {
+    std::vector<uint32_t> offsets;  // vertexCount + 1
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> triangles;
+
+    adjacency(const uint32_t* pIndices, size_t indexCount, size_t vertexCount) :
+            offsets(vertexCount + 1, 0), counts(vertexCount, 0), triangles(indexCount) {
+        for (size_t i = 0; i < indexCount; ++i) {
+            ++counts[pIndices[i]];
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            offsets[v + 1] = offsets[v] + counts[v];
+        }
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indexCount; ++i) {
+            triangles[fill[pIndices[i]]++] = (uint32_t) (i / 3);
+        }
+    }
+};
+
+// Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+static constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+static constexpr uint32_t FORSYTH_VALENCE_TABLE = 32;
+
+struct forsyth_scores {
+    float cache[FORSYTH_CACHE_SIZE];
+    float valence[FORSYTH_VALENCE_TABLE];
+
+    forsyth_scores() {
+        const float cacheDecayPower = 1.5f, lastTriScore = 0.75f;
+        for (uint32_t i = 0; i < FORSYTH_CACHE_SIZE; ++i) {
+            // the three vertices of the last triangle get a fixed score so it isn't simply repeated
+            cache[i] = (i < 3) ? lastTriScore
+                : std::pow(1.0f - (float) (i - 3) / (float) (FORSYTH_CACHE_SIZE - 3), cacheDecayPower);
+        }
+        for (uint32_t i = 0; i < FORSYTH_VALENCE_TABLE; ++i) {
+            valence[i] = valenceScore(i);
+        }
+    }
+
+    // few remaining triangles boost a vertex, to finish it off and avoid lonely triangles later
+    static float valenceScore(uint32_t remaining) {
+        const float valenceBoostScale = 2.0f, valenceBoostPower = 0.5f;
+        return remaining ? valenceBoostScale * std::pow((float) remaining, -valenceBoostPower) : 0.0f;
+    }
+
+    inline float score(uint32_t cachePosition, uint32_t remaining) const {
+        if (remaining == 0) return -1.0f;
+        float s = (cachePosition < FORSYTH_CACHE_SIZE) ? cache[cachePosition] : 0.0f;
+        return s + (remaining < FORSYTH_VALENCE_TABLE ? valence[remaining] : valenceScore(remaining));
+    }
+};
+
+static void forsyth(uint32_t* pIndices, size_t indexCount, size_t vertexCount) {
+    static const forsyth_scores scores;
+    const size_t triangleCount = indexCount / 3;
+    adjacency adj(pIndices, indexCount, vertexCount);
+    std::vector<uint32_t>& remaining = adj.counts;
+
+    std::vector<uint32_t> cachePosition(vertexCount, NONE);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        vertexScore[v] = scores.score(NONE, remaining[v]);
+    }
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    uint32_t best = NONE;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const uint32_t* tri = pIndices + t * 3;
+        triangleScore[t] = vertexScore[tri[0]] + vertexScore[tri[1]] + vertexScore[tri[2]];
+        if (triangleScore[t] > bestScore) {
+            bestScore = triangleScore[t];
+            best = (uint32_t) t;
+        }
+    }
+
+    std::vector<uint32_t> output(indexCount);
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3], newCache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t cacheCount = 0;
+    size_t cursor = 0;
+    for (size_t out = 0; out < triangleCount; ++out) {
+        if (best == NONE) {
+            // nothing near the cache scores: restart from the next triangle left in input order
+            while (emitted[cursor]) {
+                ++cursor;
+            }
+            best = (uint32_t) cursor;
+        }
+        const uint32_t tri[3] = { pIndices[best * 3], pIndices[best * 3 + 1], pIndices[best * 3 + 2] };
+        std::memcpy(&output[out * 3], tri, sizeof(tri));
+        emitted[best] = true;
+
+        uint32_t newCount = 0;
+        for (uint32_t v : tri) {
+            uint32_t* pBegin = &adj.triangles[adj.offsets[v]];
+            uint32_t* pEnd = pBegin + remaining[v];
+            *std::find(pBegin, pEnd, best) = pEnd[-1];
+            --remaining[v];
+            // a degenerate triangle names a vertex twice
+            if (std::find(newCache, newCache + newCount, v) == newCache + newCount) newCache[newCount++] = v;
+        }
+        for (uint32_t i = 0; i < cacheCount; ++i) {
+            uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) newCache[newCount++] = v;
+        }
+        // the overflow past the cache size drops out now, but still needs its score updated
+        for (uint32_t i = FORSYTH_CACHE_SIZE; i < newCount; ++i) {
+            cachePosition[newCache[i]] = NONE;
+        }
+        for (uint32_t i = 0; i < std::min(newCount, FORSYTH_CACHE_SIZE); ++i) {
+            cachePosition[newCache[i]] = i;
+        }
+        for (uint32_t i = 0; i < newCount; ++i) {
+            uint32_t v = newCache[i];
+            vertexScore[v] = scores.score(cachePosition[v], remaining[v]);
+        }
+
+        best = NONE;
+        bestScore = -1.0f;
+        for (uint32_t i = 0; i < newCount; ++i) {
+            uint32_t v = newCache[i];
+            const uint32_t* pTriangles = &adj.triangles[adj.offsets[v]];
+            for (uint32_t k = 0; k < remaining[v]; ++k) {
+                uint32_t t = pTriangles[k];
+                const uint32_t* p = pIndices + (size_t) t * 3;
+                triangleScore[t] = vertexScore[p[0]] + vertexScore[p[1]] + vertexScore[p[2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+        cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+        std::memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+    }
+    std::memcpy(pIndices, output.data(), indexCount * sizeof(uint32_t));
+}
+
+// Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+static void tipsify(uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+    const size_t triangleCount = indexCount / 3;
+    adjacency adj(pIndices, indexCount, vertexCount);
+    std::vector<uint32_t>& live = adj.counts;
+    std::vector<uint32_t> pushedAt(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+
+    uint32_t time = cacheSize + 1;
+    size_t cursor = 0;
+    uint32_t fan = 0;
+    while (fan < vertexCount && live[fan] == 0) {
+        ++fan;
+    }
+    while (fan < vertexCount) {
+        candidates.clear();
+        for (uint32_t k = adj.offsets[fan]; k < adj.offsets[fan + 1]; ++k) {
+            uint32_t t = adj.triangles[k];
+            if (emitted[t]) continue;
+            emitted[t] = true;
+            for (int c = 0; c < 3; ++c) {
+                uint32_t v = pIndices[(size_t) t * 3 + c];
+                output.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - pushedAt[v] > cacheSize) pushedAt[v] = time++;
+            }
+        }
+
+        // the candidate that will still be in the cache after its remaining triangles, oldest first
+        uint32_t next = NONE;
+        uint32_t bestPriority = 0;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) continue;
+            uint32_t priority = 0;
+            if (time - pushedAt[v] + 2 * live[v] <= cacheSize) priority = time - pushedAt[v];
+            if (next == NONE || priority > bestPriority) {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+        if (next == NONE) {
+            while (!deadEnds.empty() && next == NONE) {
+                uint32_t v = deadEnds.back();
+                deadEnds.pop_back();
+                if (live[v] > 0) next = v;
+            }
+        }
+        if (next == NONE) {
+            while (cursor < vertexCount && live[cursor] == 0) {
+                ++cursor;
+            }
+            next = (cursor < vertexCount) ? (uint32_t) cursor : NONE;
+        }
+        fan = (next == NONE) ? (uint32_t) vertexCount : next;
+    }
+    std::memcpy(pIndices, output.data(), indexCount * sizeof(uint32_t));
+}
+
+void optimizeVertexCache(uint32_t* pIndices, size_t indexCount, size_t vertexCount,
+        cache_algorithm algorithm, uint32_t cacheSize) {
+    if (indexCount % 3 != 0) throw std::invalid_argument("Index count isn't a multiple of 3.");
+    if (indexCount == 0) return;
+    if (algorithm == cache_algorithm::FORSYTH) {
+        forsyth(pIndices, indexCount, vertexCount);
+    } else {
+        tipsify(pIndices, indexCount, vertexCount, std::max(cacheSize, 3u));
+    }
+}
+
+void optimizeOverdraw(mesh& m, uint32_t cacheSize, float threshold) {
+    const size_t indexCount = m.indices.size();
+    const size_t triangleCount = indexCount / 3;
+    const size_t vertexCount = m.vertexCount();
+    if (triangleCount < 2) return;
+    if (m.positionOffset + 3 * sizeof(float) > m.stride) throw std::invalid_argument("Position outside the vertex.");
+    const uint32_t* pIndices = m.indices.data();
+
+    // hard boundaries where all three vertices of a triangle miss, i.e. the order restarted cold
+    std::vector<uint32_t> pushedAt(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    auto missCount = [&] (size_t t) {
+        uint32_t misses = 0;
+        for (int c = 0; c < 3; ++c) {
+            uint32_t v = pIndices[t * 3 + c];
+            if (time - pushedAt[v] > cacheSize) {
+                pushedAt[v] = time++;
+                ++misses;
+            }
+        }
+        return misses;
+    };
+    std::vector<uint32_t> hard { 0 };
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (missCount(t) == 3 && t > 0) hard.push_back((uint32_t) t);
+    }
+    hard.push_back((uint32_t) triangleCount);
+
+    // soft boundaries inside each, restarting the simulated cache with each cluster
+    std::vector<uint32_t> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); ++h) {
+        const uint32_t begin = hard[h], end = hard[h + 1];
+        time += cacheSize + 1;
+        uint32_t misses = 0;
+        for (uint32_t t = begin; t < end; ++t) {
+            misses += missCount(t);
+        }
+        const float clusterAcmr = (float) misses / (float) (end - begin);
+
+        time += cacheSize + 1;
+        clusters.push_back(begin);
+        uint32_t start = begin;
+        misses = 0;
+        for (uint32_t t = begin; t < end; ++t) {
+            misses += missCount(t);
+            if (t + 1 < end && (float) misses / (float) (t + 1 - start) <= threshold * clusterAcmr) {
+                clusters.push_back(t + 1);
+                start = t + 1;
+                misses = 0;
+                time += cacheSize + 1;
+            }
+        }
+    }
+    clusters.push_back((uint32_t) triangleCount);
+
+    // area-weighted centroid and normal per cluster
+    struct cluster {
+        uint32_t begin, end;
+        float centroid[3];
+        float normal[3];
+        float sortKey;
+    };
+    std::vector<cluster> sorted(clusters.size() - 1);
+    float meshCentroid[3] = {};
+    float meshArea = 0.0f;
+    for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+        cluster& cl = sorted[c];
+        cl = { clusters[c], clusters[c + 1], {}, {}, 0.0f };
+        float area = 0.0f;
+        for (uint32_t t = cl.begin; t < cl.end; ++t) {
+            float p[3][3];
+            for (int k = 0; k < 3; ++k) {
+                std::memcpy(p[k], position(m, pIndices[(size_t) t * 3 + k]), sizeof(p[k]));
+            }
+            float e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+            float e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float a = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; ++k) {
+                cl.normal[k] += n[k];
+                cl.centroid[k] += a * (p[0][k] + p[1][k] + p[2][k]) / 3.0f;
+            }
+            area += a;
+        }
+        for (int k = 0; k < 3; ++k) {
+            meshCentroid[k] += cl.centroid[k];
+            cl.centroid[k] = (area > 0.0f) ? cl.centroid[k] / area : 0.0f;
+        }
+        meshArea += area;
+    }
+    for (int k = 0; k < 3; ++k) {
+        meshCentroid[k] = (meshArea > 0.0f) ? meshCentroid[k] / meshArea : 0.0f;
+    }
+    for (cluster& cl : sorted) {
+        cl.sortKey = 0.0f;
+        for (int k = 0; k < 3; ++k) {
+            cl.sortKey += (cl.centroid[k] - meshCentroid[k]) * cl.normal[k];
+        }
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [] (const cluster& a, const cluster& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+    for (const cluster& cl : sorted) {
+        output.insert(output.end(), pIndices + (size_t) cl.begin * 3, pIndices + (size_t) cl.end * 3);
+    }
+    m.indices = std::move(output);
+}
+
+void optimizeVertexFetch(mesh& m) {
+    const size_t vertexCount = m.vertexCount();
+    const uint32_t stride = m.stride;
+    std::vector<uint32_t> remap(vertexCount, NONE);
+    std::vector<uint8_t> vertices;
+    vertices.reserve(m.vertices.size());
+    uint32_t next = 0;
+    for (uint32_t& i : m.indices) {
+        if (remap[i] == NONE) {
+            remap[i] = next++;
+            vertices.insert(vertices.end(), m.vertices.begin() + (size_t) i * stride,
+                m.vertices.begin() + ((size_t) i + 1) * stride);
+        }
+        i = remap[i];
+    }
+    m.vertices = std::move(vertices);
+}
+
+optimize_report optimizeMesh(mesh& m, const optimize_options& options) {
+    if (m.stride == 0 || m.vertices.size() % m.stride != 0) throw std::invalid_argument("Vertex data isn't a whole number of vertices.");
+    if (m.indices.size() % 3 != 0) throw std::invalid_argument("Index count isn't a multiple of 3.");
+    const size_t vertexCount = m.vertexCount();
+    for (uint32_t i : m.indices) {
+        if (i >= vertexCount) throw std::invalid_argument("Index out of range.");
+    }
+
+    optimize_report report {};
+    report.verticesBefore = vertexCount;
+    report.trianglesBefore = m.indices.size() / 3;
+    report.before = analyzeVertexCache(m.indices.data(), m.indices.size(), vertexCount, options.cacheSize);
+
+    if (options.weld) weldVertices(m, options.weldEpsilon);
+    optimizeVertexCache(m.indices.data(), m.indices.size(), m.vertexCount(), options.algorithm, options.cacheSize);
+    if (options.overdraw) optimizeOverdraw(m, options.cacheSize, options.overdrawThreshold);
+    if (options.fetch) optimizeVertexFetch(m);
+
+    report.verticesAfter = m.vertexCount();
+    report.trianglesAfter = m.indices.size() / 3;
+    report.after = analyzeVertexCache(m.indices.data(), m.indices.size(), m.vertexCount(), options.cacheSize);
+    return report;
+}
+
+std::vector<optimize_report> optimizeMeshes(std::vector<mesh>& meshes, const optimize_options& options, uint32_t threads) {
+    std::vector<optimize_report> reports(meshes.size());
+    if (threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u);
+    threads = (uint32_t) std::min<size_t>(threads, meshes.size());
+
+    // meshes vary a lot in size, so workers take the next one rather than a fixed share
+    std::atomic<size_t> next { 0 };
+    std::exception_ptr error;
+    std::atomic<bool> failed { false };
+    auto work = [&] () {
+        for (size_t i = next++; i < meshes.size() && !failed; i = next++) {
+            try {
+                reports[i] = optimizeMesh(meshes[i], options);
+            } catch (...) {
+                if (!failed.exchange(true)) error = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (uint32_t t = 1; t < threads; ++t) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& w : workers) {
+        w.join();
+    }
+    if (error) std::rethrow_exception(error);
+    return reports;
+}
+
+mesh_buffers uploadMesh(const mesh& m, GLbitfield storageFlags) {
+    const size_t vertexCount = m.vertexCount();
+    if (vertexCount == 0 || m.indices.empty()) throw std::invalid_argument("Empty mesh.");
+
+    const bool shortIndices = vertexCount <= 0x10000;
+    std::vector<uint16_t> shorts;
+    const void* pIndexData = m.indices.data();
+    size_t indexSize = m.indices.size() * sizeof(uint32_t);
+    if (shortIndices) {
+        shorts.assign(m.indices.begin(), m.indices.end());
+        pIndexData = shorts.data();
+        indexSize = shorts.size() * sizeof(uint16_t);
+    }
+    return mesh_buffers {
+        buffer(m.vertices.size(), storageFlags, m.vertices.data()),
+        buffer(indexSize, storageFlags, pIndexData),
+        (GLenum) (shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT),
+        (uint32_t) m.indices.size(),
+        (uint32_t) vertexCount,
+        m.stride
+    };
+}
+
+}  // namespace mesh_ops
+}  // namespace ogu
@@ -0,0 +1,435 @@
+#include "mock_gl.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include "state_cache.h"
+
+
+namespace ogu {
+
+static mock_gl* s_pCurrent = nullptr;
+
+template<typename T>
+static uint64_t toArg(T value) {
+    if constexpr (std::is_pointer<T>::value) {
+        return (uint64_t) (uintptr_t) value;
+    } else if constexpr (std::is_floating_point<T>::value) {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(T));
+        return bits;
+    } else {
+        return (uint64_t) value;
+    }
+}
+
+struct mock_gl_backend {
+
+    using ep = gl_entry_point;
+
+    template<typename... Args>
+    static mock_gl& record(gl_entry_point entryPoint, Args... args) {
+        static_assert(sizeof...(Args) <= 16, "too many arguments to record");
+        const uint64_t values[sizeof...(Args) + 1] = { toArg(args)..., 0 };
+        s_pCurrent->record(entryPoint, values, (uint32_t) sizeof...(Args));
+        return *s_pCurrent;
+    }
+
+    // Default stand-in for an entry point: count, record, return zero
+    template<gl_entry_point Id, typename Fn>
+    struct recorder;
+
+    template<gl_entry_point Id, typename R, typename... Args>
+    struct recorder<Id, R (GLAPIENTRY*)(Args...)> {
+        static R GLAPIENTRY call(Args... args) {
+            record(Id, args...);
+            return R();
+        }
+    };
+
+    // Object names
+
+    static void generate(mock_gl& m, GLsizei n, GLuint* pNames, std::unordered_set<GLuint>& objects) {
+        for (GLsizei i = 0; i < n; ++i) {
+            pNames[i] = m._nextName++;
+            objects.insert(pNames[i]);
+        }
+    }
+
+    static void erase(GLsizei n, const GLuint* pNames, std::unordered_set<GLuint>& objects) {
+        for (GLsizei i = 0; i < n; ++i) {
+            objects.erase(pNames[i]);
+        }
+    }
+
+    static void GLAPIENTRY genBuffers(GLsizei n, GLuint* pNames) {
+        mock_gl& m = record(ep::GenBuffers, n, pNames);
+        for (GLsizei i = 0; i < n; ++i) {
+            pNames[i] = m._nextName++;
+            m._buffers[pNames[i]];
+        }
+    }
+
+    static void GLAPIENTRY createBuffers(GLsizei n, GLuint* pNames) {
+        mock_gl& m = record(ep::CreateBuffers, n, pNames);
+        for (GLsizei i = 0; i < n; ++i) {
+            pNames[i] = m._nextName++;
+            m._buffers[pNames[i]];
+        }
+    }
+
+    static void GLAPIENTRY deleteBuffers(GLsizei n, const GLuint* pNames) {
+        mock_gl& m = record(ep::DeleteBuffers, n, pNames);
+        for (GLsizei i = 0; i < n; ++i) {
+            m._buffers.erase(pNames[i]);
+        }
+    }
+
+    static void GLAPIENTRY genTextures(GLsizei n, GLuint* pNames) {
+        mock_gl& m = record(ep::GenTextures, n, pNames);
+        generate(m, n, pNames, m._textures);
+    }
+
+    static void GLAPIENTRY createTextures(GLenum target, GLsizei n, GLuint* pNames) {
+        mock_gl& m = record(ep::CreateTextures, target, n, pNames);
+        generate(m, n, pNames, m._textures);
+    }
+
+    static void GLAPIENTRY deleteTextures(GLsizei n, const GLuint* pNames) {
+        erase(n, pNames, record(ep::DeleteTextures, n, pNames)._textures);
+    }
+
+    static void GLAPIENTRY genVertexArrays(GLsizei n, GLuint* pNames) {
+        mock_gl& m = record(ep::GenVertexArrays, n, pNames);
+        generate(m, n, pNames, m._vertexArrays);
+    }
+
+    static void GLAPIENTRY createVertexArrays(GLsizei n, GLuint* pNames) {
+        mock_gl& m = record(ep::CreateVertexArrays, n, pNames);
+        generate(m, n, pNames, m._vertexArrays);
+    }
+
+    static void GLAPIENTRY deleteVertexArrays(GLsizei n, const GLuint* pNames) {
+        erase(n, pNames, record(ep::DeleteVertexArrays, n, pNames)._vertexArrays);
+    }
+
+    static GLuint GLAPIENTRY createShader(GLenum type) {
+        mock_gl& m = record(ep::CreateShader, type);
+        m._shaders.insert(m._nextName);
+        return m._nextName++;
+    }
+
+    static void GLAPIENTRY deleteShader(GLuint shader) {
+        record(ep::DeleteShader, shader)._shaders.erase(shader);
+    }
+
+    static GLuint GLAPIENTRY createProgram() {
+        mock_gl& m = record(ep::CreateProgram);
+        m._programs.insert(m._nextName);
+        return m._nextName++;
+    }
+
+    static void GLAPIENTRY deleteProgram(GLuint program) {
+        record(ep::DeleteProgram, program)._programs.erase(program);
+    }
+
+    // Buffer storage
+
+    static void store(std::vector<uint8_t>& storage, GLsizeiptr size, const void* pData) {
+        storage.assign((size_t) size, 0);
+        if (pData) std::memcpy(storage.data(), pData, (size_t) size);
+    }
+
+    static void GLAPIENTRY bindBuffer(GLenum target, GLuint buffer) {
+        record(ep::BindBuffer, target, buffer)._boundBuffers[target] = buffer;
+    }
+
+    static void GLAPIENTRY bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+        record(ep::BindBufferBase, target, index, buffer)._boundBuffers[target] = buffer;
+    }
+
+    static void GLAPIENTRY bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+        record(ep::BindBufferRange, target, index, buffer, offset, size)._boundBuffers[target] = buffer;
+    }
+
+    static void GLAPIENTRY bufferData(GLenum target, GLsizeiptr size, const void* pData, GLenum usage) {
+        mock_gl& m = record(ep::BufferData, target, size, pData, usage);
+        store(m._buffers[m._boundBuffers[target]], size, pData);
+    }
+
+    static void GLAPIENTRY bufferStorage(GLenum target, GLsizeiptr size, const void* pData, GLbitfield flags) {
+        mock_gl& m = record(ep::BufferStorage, target, size, pData, flags);
+        store(m._buffers[m._boundBuffers[target]], size, pData);
+    }
+
+    static void GLAPIENTRY namedBufferData(GLuint buffer, GLsizeiptr size, const void* pData, GLenum usage) {
+        store(record(ep::NamedBufferData, buffer, size, pData, usage)._buffers[buffer], size, pData);
+    }
+
+    static void GLAPIENTRY namedBufferStorage(GLuint buffer, GLsizeiptr size, const void* pData, GLbitfield flags) {
+        store(record(ep::NamedBufferStorage, buffer, size, pData, flags)._buffers[buffer], size, pData);
+    }
+
+    static void* map(mock_gl& m, GLuint buffer, GLintptr offset, GLsizeiptr length) {
+        auto it = m._buffers.find(buffer);
+        if (it == m._buffers.end() || (size_t) (offset + length) > it->second.size()) return nullptr;
+        return it->second.data() + offset;
+    }
+
+    static void* GLAPIENTRY mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+        mock_gl& m = record(ep::MapBufferRange, target, offset, length, access);
+        return map(m, m._boundBuffers[target], offset, length);
+    }
+
+    static void* GLAPIENTRY mapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+        return map(record(ep::MapNamedBufferRange, buffer, offset, length, access), buffer, offset, length);
+    }
+
+    static GLboolean GLAPIENTRY unmapBuffer(GLenum target) {
+        record(ep::UnmapBuffer, target);
+        return GL_TRUE;
+    }
+
+    static GLboolean GLAPIENTRY unmapNamedBuffer(GLuint buffer) {
+        record(ep::UnmapNamedBuffer, buffer);
+        return GL_TRUE;
+    }
+
+    // Sync objects
+
+    static GLsync GLAPIENTRY fenceSync(GLenum condition, GLbitfield flags) {
+        mock_gl& m = record(ep::FenceSync, condition, flags);
+        uintptr_t sync = m._nextName++;
+        m._syncs.insert(sync);
+        return (GLsync) sync;
+    }
+
+    static GLenum GLAPIENTRY clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+        record(ep::ClientWaitSync, sync, flags, timeout);
+        return GL_ALREADY_SIGNALED;
+    }
+
+    static void GLAPIENTRY deleteSync(GLsync sync) {
+        record(ep::DeleteSync, sync)._syncs.erase((uintptr_t) sync);
+    }
+
+    // Queries
+
+    static void GLAPIENTRY genQueries(GLsizei n, GLuint* pNames) {
+        mock_gl& m = record(ep::GenQueries, n, pNames);
+        generate(m, n, pNames, m._queries);
+    }
+
+    static void GLAPIENTRY deleteQueries(GLsizei n, const GLuint* pNames) {
+        erase(n, pNames, record(ep::DeleteQueries, n, pNames)._queries);
+    }
+
+    static void GLAPIENTRY getQueryObjectiv(GLuint query, GLenum pname, GLint* pParams) {
+        record(ep::GetQueryObjectiv, query, pname, pParams);
+        *pParams = (pname == GL_QUERY_RESULT_AVAILABLE) ? GL_TRUE : 0;
+    }
+
+    static void GLAPIENTRY getQueryObjectui64v(GLuint query, GLenum pname, GLuint64* pParams) {
+        mock_gl& m = record(ep::GetQueryObjectui64v, query, pname, pParams);
+        m._gpuClock += 1000;
+        *pParams = m._gpuClock;
+    }
+
+    static void GLAPIENTRY getInteger64v(GLenum pname, GLint64* pData) {
+        mock_gl& m = record(ep::GetInteger64v, pname, pData);
+        *pData = (pname == GL_TIMESTAMP) ? (GLint64) m._gpuClock : 0;
+    }
+
+    static void GLAPIENTRY getIntegerv(GLenum pname, GLint* pData) {
+        mock_gl& m = record(ep::GetIntegerv, pname, pData);
+        auto it = m._integers.find(pname);
+        *pData = (it != m._integers.end()) ? it->second : 0;
+    }
+
+    static const GLubyte* GLAPIENTRY getString(GLenum name) {
+        record(ep::GetString, name);
+        switch (name) {
+        case GL_VENDOR: return (const GLubyte*) "ogu";
+        case GL_RENDERER: return (const GLubyte*) "mock_gl";
+        case GL_VERSION: return (const GLubyte*) "4.6 mock_gl";
+        case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte*) "4.60";
+        default: return (const GLubyte*) "";
+        }
+    }
+
+    static void GLAPIENTRY getShaderiv(GLuint shader, GLenum pname, GLint* pParams) {
+        mock_gl& m = record(ep::GetShaderiv, shader, pname, pParams);
+        if (pname == GL_COMPLETION_STATUS_KHR) *pParams = m._complete ? GL_TRUE : GL_FALSE;
+        else *pParams = (pname == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+    }
+
+    static void GLAPIENTRY getProgramiv(GLuint program, GLenum pname, GLint* pParams) {
+        mock_gl& m = record(ep::GetProgramiv, program, pname, pParams);
+        if (pname == GL_COMPLETION_STATUS_KHR) *pParams = m._complete ? GL_TRUE : GL_FALSE;
+        else *pParams = (pname == GL_LINK_STATUS) ? GL_TRUE : 0;
+    }
+
+    static void GLAPIENTRY getProgramInterfaceiv(GLuint program, GLenum interface, GLenum pname, GLint* pParams) {
+        record(ep::GetProgramInterfaceiv, program, interface, pname, pParams);
+        *pParams = 0;
+    }
+
+    static void GLAPIENTRY getShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* pLength, GLchar* pInfoLog) {
+        record(ep::GetShaderInfoLog, shader, bufSize, pLength, pInfoLog);
+        if (pLength) *pLength = 0;
+        if (bufSize > 0) pInfoLog[0] = '\0';
+    }
+
+    static void GLAPIENTRY getProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* pLength, GLchar* pInfoLog) {
+        record(ep::GetProgramInfoLog, program, bufSize, pLength, pInfoLog);
+        if (pLength) *pLength = 0;
+        if (bufSize > 0) pInfoLog[0] = '\0';
+    }
+
+    static GLint GLAPIENTRY getUniformLocation(GLuint program, const GLchar* name) {
+        record(ep::GetUniformLocation, program, name);
+        return -1;
+    }
+
+    static GLint GLAPIENTRY getAttribLocation(GLuint program, const GLchar* name) {
+        record(ep::GetAttribLocation, program, name);
+        return -1;
+    }
+
+    static void install() {
+        gl::dispatch_table& t = gl::table;
+#define OGU_GL_MOCK_ENTRY(name) t.name = &recorder<ep::name, decltype(t.name)>::call;
+        OGU_GL_FUNCTIONS(OGU_GL_MOCK_ENTRY)
+#undef OGU_GL_MOCK_ENTRY
+
+        t.GenBuffers = &genBuffers;
+        t.CreateBuffers = &createBuffers;
+        t.DeleteBuffers = &deleteBuffers;
+        t.GenTextures = &genTextures;
+        t.CreateTextures = &createTextures;
+        t.DeleteTextures = &deleteTextures;
+        t.GenVertexArrays = &genVertexArrays;
+        t.CreateVertexArrays = &createVertexArrays;
+        t.DeleteVertexArrays = &deleteVertexArrays;
+        t.CreateShader = &createShader;
+        t.DeleteShader = &deleteShader;
+        t.CreateProgram = &createProgram;
+        t.DeleteProgram = &deleteProgram;
+
+        t.BindBuffer = &bindBuffer;
+        t.BindBufferBase = &bindBufferBase;
+        t.BindBufferRange = &bindBufferRange;
+        t.BufferData = &bufferData;
+        t.BufferStorage = &bufferStorage;
+        t.NamedBufferData = &namedBufferData;
+        t.NamedBufferStorage = &namedBufferStorage;
+        t.MapBufferRange = &mapBufferRange;
+        t.MapNamedBufferRange = &mapNamedBufferRange;
+        t.UnmapBuffer = &unmapBuffer;
+        t.UnmapNamedBuffer = &unmapNamedBuffer;
+
+        t.FenceSync = &fenceSync;
+        t.ClientWaitSync = &clientWaitSync;
+        t.DeleteSync = &deleteSync;
+
+        t.GenQueries = &genQueries;
+        t.DeleteQueries = &deleteQueries;
+        t.GetQueryObjectiv = &getQueryObjectiv;
+        t.GetQueryObjectui64v = &getQueryObjectui64v;
+        t.GetInteger64v = &getInteger64v;
+
+        t.GetIntegerv = &getIntegerv;
+        t.GetString = &getString;
+        t.GetShaderiv = &getShaderiv;
+        t.GetProgramiv = &getProgramiv;
+        t.GetProgramInterfaceiv = &getProgramInterfaceiv;
+        t.GetShaderInfoLog = &getShaderInfoLog;
+        t.GetProgramInfoLog = &getProgramInfoLog;
+        t.GetUniformLocation = &getUniformLocation;
+        t.GetAttribLocation = &getAttribLocation;
+    }
+
+};
+
+mock_gl::mock_gl(const features& f) :
+        _previous(gl::table),
+        _previousFeatures(getFeatures()) {
+    if (s_pCurrent) throw std::logic_error("Only one mock_gl can exist at a time.");
+    s_pCurrent = this;
+    mock_gl_backend::install();
+    detail::_features = f;
+
+    _integers[GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT] = 256;
+    _integers[GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT] = 256;
+    _integers[GL_MAX_VERTEX_ATTRIB_RELATIVE_OFFSET] = 2047;
+    state_cache::current().invalidate();
+}
+
+mock_gl::~mock_gl() {
+    gl::table = _previous;
+    detail::_features = _previousFeatures;
+    s_pCurrent = nullptr;
+    // Objects the library still owns will be deleted through whatever table is installed now
+    state_cache::current().invalidate();
+}
+
+mock_gl& mock_gl::current() {
+    if (!s_pCurrent) throw std::logic_error("No mock_gl installed.");
+    return *s_pCurrent;
+}
+
+const char* mock_gl::name(gl_entry_point entryPoint) {
+    static const char* const names[] = {
+#define OGU_GL_ENTRY_NAME(name) "gl" #name,
+        OGU_GL_FUNCTIONS(OGU_GL_ENTRY_NAME)
+#undef OGU_GL_ENTRY_NAME
+    };
+    return names[(size_t) entryPoint];
+}
+
+uint64_t mock_gl::count(const std::string& name) const {
+    for (size_t i = 0; i < _counts.size(); ++i) {
+        if (name == mock_gl::name((gl_entry_point) i)) return _counts[i];
+    }
+    throw std::invalid_argument("Unknown GL entry point " + name);
+}
+
+uint64_t mock_gl::totalCalls() const {
+    uint64_t total = 0;
+    for (uint64_t c : _counts) {
+        total += c;
+    }
+    return total;
+}
+
+void mock_gl::reset() {
+    _counts.fill(0);
+    _calls.clear();
+}
+
+mock_gl::object_counts mock_gl::liveObjects() const {
+    return { _buffers.size(), _textures.size(), _vertexArrays.size(), _shaders.size(), _programs.size(), _syncs.size(),
+        _queries.size() };
+}
+
+void mock_gl::setInteger(GLenum pname, GLint value) {
+    _integers[pname] = value;
+}
+
+const std::vector<uint8_t>* mock_gl::bufferStorage(GLuint buffer) const {
+    auto it = _buffers.find(buffer);
+    return it != _buffers.end() ? &it->second : nullptr;
+}
+
+void mock_gl::record(gl_entry_point entryPoint, const uint64_t* pArgs, uint32_t argCount) {
+    ++_counts[(size_t) entryPoint];
+    if (!_recording) return;
+    call c {};
+    c.entryPoint = entryPoint;
+    c.argCount = argCount;
+    std::memcpy(c.args, pArgs, argCount * sizeof(uint64_t));
+    _calls.push_back(c);
+}
+
+}  // namespace ogu
@@ -0,0 +1,99 @@
+#include "pending_program.h"
+
+#include <stdexcept>
+#include <utility>
+
+#include "init.h"
+
+
+namespace ogu {
+
+pending_program::pending_program(const std::vector<shader_source>& stages) {
+    // Compile status isn't checked here, glLinkProgram waits for the compiles itself
+    for (const auto& stage : stages) {
+        _shaders.push_back(shader::compile(stage.sources, stage.type));
+    }
+
+    _program = glCreateProgram();
+    for (GLuint s : _shaders) {
+        glAttachShader(_program, s);
+    }
+    glLinkProgram(_program);
+}
+
+pending_program::pending_program(pending_program&& p) :
+        _shaders(std::move(p._shaders)),
+        _program(p._program) {
+    p._shaders.clear();
+    p._program = 0;
+}
+
+pending_program::~pending_program() {
+    release();
+    glDeleteProgram(_program);
+}
+
+void pending_program::release() {
+    for (GLuint s : _shaders) {
+        if (_program) glDetachShader(_program, s);
+        glDeleteShader(s);
+    }
+    _shaders.clear();
+}
+
+bool pending_program::ready() const {
+    if (!_program) throw std::logic_error("Pending program has already been retrieved.");
+    if (!getFeatures().parallelShaderCompile) return true;
+
+    GLint complete = GL_FALSE;
+    glGetProgramiv(_program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+shader_program pending_program::get() {
+    if (!_program) throw std::logic_error("Pending program has already been retrieved.");
+
+    GLint status;
+    glGetProgramiv(_program, GL_LINK_STATUS, &status);
+    if (!status) {
+        GLuint program = _program;
+        std::vector<GLuint> shaders = std::move(_shaders);
+        _program = 0;
+        _shaders.clear();
+        for (GLuint s : shaders) {
+            glDetachShader(program, s);
+        }
+
+        // A compile error is the more useful message, so report that first if there is one
+        try {
+            for (GLuint& s : shaders) {
+                GLuint shader = s;
+                s = 0;
+                shader::checkCompileStatus(shader);
+                glDeleteShader(shader);
+            }
+        } catch (...) {
+            for (GLuint s : shaders) {
+                glDeleteShader(s);
+            }
+            glDeleteProgram(program);
+            throw;
+        }
+        shader_program::checkLinkStatus(program);
+    }
+
+    release();
+    GLuint program = _program;
+    _program = 0;
+    return shader_program(program);
+}
+
+void pending_program::setMaxCompilerThreads(GLuint count) {
+    if (GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(count);
+    } else if (GLEW_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(count);
+    }
+}
+
+}  // namespace ogu
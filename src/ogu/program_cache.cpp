@@ -0,0 +1,164 @@
+#include "program_cache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include "hash.h"
+
+
+namespace ogu {
+
+static constexpr uint32_t ENTRY_MAGIC = 0x5055474f;  // "OGUP"
+static constexpr uint32_t ENTRY_VERSION = 1;
+
+struct entry_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+    double compileSeconds;
+};
+
+static std::string glString(GLenum name) {
+    const GLubyte* s = glGetString(name);
+    return s ? reinterpret_cast<const char*>(s) : "";
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+program_cache::program_cache(const std::string& directory) :
+        _directory(directory) {
+    _driverId = glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+
+    GLint numFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    _binariesSupported = numFormats > 0;
+}
+
+uint64_t program_cache::key(const std::vector<shader_source>& stages) const {
+    uint64_t hash = fnv1a(_driverId);
+    for (const auto& stage : stages) {
+        hash = fnv1a_value(stage.type, hash);
+        hash = fnv1a_value(stage.sources.size(), hash);
+        for (const auto& source : stage.sources) {
+            // include the length so moving text between strings changes the key
+            hash = fnv1a_value(source.size(), hash);
+            hash = fnv1a(source, hash);
+        }
+    }
+    return hash;
+}
+
+std::string program_cache::entryPath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) key);
+    return _directory + "/" + name;
+}
+
+GLuint program_cache::loadBinary(uint64_t key, double& recordedSeconds, bool& rejected) const {
+    std::ifstream file(entryPath(key), std::ios::binary);
+    if (!file) return 0;
+
+    entry_header header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return 0;
+    if (header.magic != ENTRY_MAGIC || header.version != ENTRY_VERSION || header.key != key) return 0;
+
+    std::vector<char> binary(header.binaryLength);
+    if (!file.read(binary.data(), binary.size())) return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, binary.data(), header.binaryLength);
+
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status) {
+        glDeleteProgram(program);
+        rejected = true;
+        return 0;
+    }
+
+    recordedSeconds = header.compileSeconds;
+    return program;
+}
+
+void program_cache::storeBinary(uint64_t key, GLuint program, double compileSeconds) const {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    entry_header header {};
+    header.magic = ENTRY_MAGIC;
+    header.version = ENTRY_VERSION;
+    header.key = key;
+    header.compileSeconds = compileSeconds;
+
+    std::vector<char> binary(length);
+    GLenum format;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+    header.binaryFormat = format;
+    header.binaryLength = (uint32_t) length;
+
+    // Write to a temporary file and rename it into place, so other processes never see a partial entry
+    std::string path = entryPath(key);
+    std::string tempPath = path + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()))
+        + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), binary.size());
+        if (!file) {
+            file.close();
+            std::remove(tempPath.c_str());
+            return;
+        }
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+    }
+}
+
+shader_program program_cache::load(const std::vector<shader_source>& stages) {
+    uint64_t k = key(stages);
+
+    if (_binariesSupported) {
+        auto start = std::chrono::steady_clock::now();
+        double recordedSeconds = 0.0;
+        bool rejected = false;
+        GLuint program = loadBinary(k, recordedSeconds, rejected);
+        if (rejected) ++_stats.rejected;
+        if (program) {
+            ++_stats.hits;
+            double saved = recordedSeconds - secondsSince(start);
+            if (saved > 0.0) _stats.secondsSaved += saved;
+            return shader_program(program);
+        }
+    }
+
+    ++_stats.misses;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<shader> shaders;
+    shaders.reserve(stages.size());
+    for (const auto& stage : stages) {
+        shaders.emplace_back(stage.sources, stage.type);
+    }
+    std::vector<const shader*> pShaders;
+    for (const auto& s : shaders) {
+        pShaders.push_back(&s);
+    }
+    GLuint program = shader_program::link(pShaders.data(), pShaders.size(), _binariesSupported);
+    double compileSeconds = secondsSince(start);
+
+    if (_binariesSupported) {
+        storeBinary(k, program, compileSeconds);
+    }
+    return shader_program(program);
+}
+
+}  // namespace ogu
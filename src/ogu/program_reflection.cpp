@@ -0,0 +1,300 @@
+#include "program_reflection.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "init.h"
+
+
+namespace ogu {
+
+using member_list = std::vector<std::pair<GLint, program_reflection::variable>>;
+
+template<typename T>
+static void sortByHash(std::vector<T>& table) {
+    std::sort(table.begin(), table.end(), [] (const T& a, const T& b) {
+            return a.nameHash < b.nameHash;
+        });
+}
+
+// Groups members by block, sorted by offset within each block, and points each block at its range
+static void attachMembers(std::vector<program_reflection::block>& blocks, member_list& members,
+        std::vector<program_reflection::variable>& blockMembers) {
+    std::sort(members.begin(), members.end(), [] (const member_list::value_type& a, const member_list::value_type& b) {
+            return a.first != b.first ? a.first < b.first : a.second.offset < b.second.offset;
+        });
+    for (auto& b : blocks) {
+        auto range = std::equal_range(members.begin(), members.end(), member_list::value_type((GLint) b.index, {}),
+            [] (const member_list::value_type& a, const member_list::value_type& b) {
+                return a.first < b.first;
+            });
+        b.firstMember = (uint32_t) blockMembers.size();
+        b.memberCount = (uint32_t) (range.second - range.first);
+        for (auto it = range.first; it != range.second; ++it) {
+            blockMembers.push_back(it->second);
+        }
+    }
+}
+
+static bool isBuiltIn(const char* name) {
+    return name[0] == 'g' && name[1] == 'l' && name[2] == '_';
+}
+
+program_reflection::program_reflection(GLuint program) {
+    if (getFeatures().programInterfaceQuery) {
+        reflectInterfaceQuery(program);
+    } else {
+        reflectLegacy(program);
+    }
+    sortTables();
+}
+
+uint32_t program_reflection::addName(const char* name, uint32_t length) {
+    uint32_t offset = (uint32_t) _names.size();
+    _names.append(name, length);
+    return offset;
+}
+
+void program_reflection::reflectInterfaceQuery(GLuint program) {
+    std::vector<char> nameBuffer;
+    auto resourceName = [&] (GLenum interface, GLuint index, GLint nameLength, variable& v) {
+        nameBuffer.resize(nameLength);
+        glGetProgramResourceName(program, interface, index, nameLength, nullptr, nameBuffer.data());
+        v.nameLength = (uint32_t) (nameLength - 1);
+        v.nameOffset = addName(nameBuffer.data(), v.nameLength);
+        v.nameHash = fnv1a(nameBuffer.data(), v.nameLength);
+    };
+
+    auto reflectBlocks = [&] (GLenum interface, std::vector<block>& blocks) {
+        GLint count = 0;
+        glGetProgramInterfaceiv(program, interface, GL_ACTIVE_RESOURCES, &count);
+        const GLenum props[] = { GL_NAME_LENGTH, GL_BUFFER_DATA_SIZE };
+        for (GLint i = 0; i < count; ++i) {
+            GLint values[2];
+            glGetProgramResourceiv(program, interface, i, 2, props, 2, nullptr, values);
+            variable v {};
+            resourceName(interface, i, values[0], v);
+            block b {};
+            b.nameHash = v.nameHash;
+            b.nameOffset = v.nameOffset;
+            b.nameLength = v.nameLength;
+            b.index = (GLuint) i;
+            b.dataSize = values[1];
+            blocks.push_back(b);
+        }
+    };
+
+    // Uniforms, both default-block and block members
+    {
+        member_list members;
+        GLint count = 0;
+        glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+        const GLenum props[] = { GL_NAME_LENGTH, GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION,
+            GL_BLOCK_INDEX, GL_OFFSET, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE };
+        for (GLint i = 0; i < count; ++i) {
+            GLint values[8];
+            glGetProgramResourceiv(program, GL_UNIFORM, i, 8, props, 8, nullptr, values);
+            variable v {};
+            resourceName(GL_UNIFORM, i, values[0], v);
+            v.type = (GLenum) values[1];
+            v.arraySize = values[2];
+            v.location = values[3];
+            v.offset = values[5];
+            v.arrayStride = values[6];
+            v.matrixStride = values[7];
+            if (values[4] == -1) {
+                _uniforms.push_back(v);
+            } else {
+                members.emplace_back(values[4], v);
+            }
+        }
+        reflectBlocks(GL_UNIFORM_BLOCK, _uniformBlocks);
+        attachMembers(_uniformBlocks, members, _blockMembers);
+    }
+
+    // Shader storage blocks and their buffer variables
+    {
+        member_list members;
+        GLint count = 0;
+        glGetProgramInterfaceiv(program, GL_BUFFER_VARIABLE, GL_ACTIVE_RESOURCES, &count);
+        const GLenum props[] = { GL_NAME_LENGTH, GL_TYPE, GL_ARRAY_SIZE,
+            GL_BLOCK_INDEX, GL_OFFSET, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE };
+        for (GLint i = 0; i < count; ++i) {
+            GLint values[7];
+            glGetProgramResourceiv(program, GL_BUFFER_VARIABLE, i, 7, props, 7, nullptr, values);
+            variable v {};
+            resourceName(GL_BUFFER_VARIABLE, i, values[0], v);
+            v.type = (GLenum) values[1];
+            v.arraySize = values[2];
+            v.location = -1;
+            v.offset = values[4];
+            v.arrayStride = values[5];
+            v.matrixStride = values[6];
+            members.emplace_back(values[3], v);
+        }
+        reflectBlocks(GL_SHADER_STORAGE_BLOCK, _storageBlocks);
+        attachMembers(_storageBlocks, members, _blockMembers);
+    }
+
+    // Vertex inputs
+    {
+        GLint count = 0;
+        glGetProgramInterfaceiv(program, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES, &count);
+        const GLenum props[] = { GL_NAME_LENGTH, GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION };
+        for (GLint i = 0; i < count; ++i) {
+            GLint values[4];
+            glGetProgramResourceiv(program, GL_PROGRAM_INPUT, i, 4, props, 4, nullptr, values);
+            variable v {};
+            resourceName(GL_PROGRAM_INPUT, i, values[0], v);
+            if (isBuiltIn(_names.c_str() + v.nameOffset)) {
+                _names.resize(v.nameOffset);
+                continue;
+            }
+            v.type = (GLenum) values[1];
+            v.arraySize = values[2];
+            v.location = values[3];
+            v.offset = -1;
+            _inputs.push_back(v);
+        }
+    }
+}
+
+void program_reflection::reflectLegacy(GLuint program) {
+    std::vector<char> nameBuffer;
+    auto setName = [&] (GLsizei length, variable& v) {
+        v.nameLength = (uint32_t) length;
+        v.nameOffset = addName(nameBuffer.data(), v.nameLength);
+        v.nameHash = fnv1a(nameBuffer.data(), v.nameLength);
+    };
+
+    // Uniforms
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        nameBuffer.resize(maxLength + 1);
+
+        std::vector<GLuint> indices(count);
+        for (GLint i = 0; i < count; ++i) {
+            indices[i] = (GLuint) i;
+        }
+        const GLenum props[] = { GL_UNIFORM_TYPE, GL_UNIFORM_SIZE, GL_UNIFORM_BLOCK_INDEX,
+            GL_UNIFORM_OFFSET, GL_UNIFORM_ARRAY_STRIDE, GL_UNIFORM_MATRIX_STRIDE };
+        std::vector<GLint> values[6];
+        for (int p = 0; p < 6; ++p) {
+            values[p].resize(count);
+            if (count > 0) glGetActiveUniformsiv(program, count, indices.data(), props[p], values[p].data());
+        }
+
+        member_list members;
+        for (GLint i = 0; i < count; ++i) {
+            GLsizei length = 0;
+            glGetActiveUniformName(program, i, (GLsizei) nameBuffer.size(), &length, nameBuffer.data());
+            variable v {};
+            setName(length, v);
+            v.type = (GLenum) values[0][i];
+            v.arraySize = values[1][i];
+            v.offset = values[3][i];
+            v.arrayStride = values[4][i];
+            v.matrixStride = values[5][i];
+            if (values[2][i] == -1) {
+                // no way around a location query per uniform without program interface query
+                v.location = glGetUniformLocation(program, nameBuffer.data());
+                _uniforms.push_back(v);
+            } else {
+                v.location = -1;
+                members.emplace_back(values[2][i], v);
+            }
+        }
+
+        GLint blockCount = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+        for (GLint i = 0; i < blockCount; ++i) {
+            GLint nameLength = 0, dataSize = 0;
+            glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_NAME_LENGTH, &nameLength);
+            glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+            nameBuffer.resize(std::max<size_t>(nameBuffer.size(), nameLength + 1));
+            GLsizei length = 0;
+            glGetActiveUniformBlockName(program, i, (GLsizei) nameBuffer.size(), &length, nameBuffer.data());
+            variable v {};
+            setName(length, v);
+            block b {};
+            b.nameHash = v.nameHash;
+            b.nameOffset = v.nameOffset;
+            b.nameLength = v.nameLength;
+            b.index = (GLuint) i;
+            b.dataSize = dataSize;
+            _uniformBlocks.push_back(b);
+        }
+        attachMembers(_uniformBlocks, members, _blockMembers);
+    }
+
+    // Vertex inputs
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+        glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+        nameBuffer.resize(std::max<size_t>(nameBuffer.size(), maxLength + 1));
+        for (GLint i = 0; i < count; ++i) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveAttrib(program, i, (GLsizei) nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+            if (isBuiltIn(nameBuffer.data())) continue;
+            variable v {};
+            setName(length, v);
+            v.type = type;
+            v.arraySize = size;
+            v.location = glGetAttribLocation(program, nameBuffer.data());
+            v.offset = -1;
+            _inputs.push_back(v);
+        }
+    }
+}
+
+void program_reflection::sortTables() {
+    sortByHash(_uniforms);
+    sortByHash(_uniformBlocks);
+    sortByHash(_storageBlocks);
+    sortByHash(_inputs);
+}
+
+template<typename T>
+const T* program_reflection::find(const std::vector<T>& table, const std::string& name) const {
+    uint64_t hash = fnv1a(name);
+    auto it = std::lower_bound(table.begin(), table.end(), hash, [] (const T& entry, uint64_t hash) {
+            return entry.nameHash < hash;
+        });
+    for (; it != table.end() && it->nameHash == hash; ++it) {
+        if (_names.compare(it->nameOffset, it->nameLength, name) == 0) return &*it;
+    }
+    return nullptr;
+}
+
+const program_reflection::variable* program_reflection::findUniform(const std::string& name) const {
+    const variable* v = find(_uniforms, name);
+    // arrays are reported as "name[0]", but GL accepts just "name" too
+    if (!v && (name.empty() || name.back() != ']')) v = find(_uniforms, name + "[0]");
+    return v;
+}
+
+const program_reflection::variable* program_reflection::findUniform(uniform_name name) const {
+    auto it = std::lower_bound(_uniforms.begin(), _uniforms.end(), name.hash, [] (const variable& entry, uint64_t hash) {
+            return entry.nameHash < hash;
+        });
+    return (it != _uniforms.end() && it->nameHash == name.hash) ? &*it : nullptr;
+}
+
+const program_reflection::block* program_reflection::findUniformBlock(const std::string& name) const {
+    return find(_uniformBlocks, name);
+}
+
+const program_reflection::block* program_reflection::findStorageBlock(const std::string& name) const {
+    return find(_storageBlocks, name);
+}
+
+const program_reflection::variable* program_reflection::findInput(const std::string& name) const {
+    return find(_inputs, name);
+}
+
+}  // namespace ogu
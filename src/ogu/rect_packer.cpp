@@ -0,0 +1,83 @@
+#include "rect_packer.h"
+
+#include <algorithm>
+
+
+namespace ogu {
+
+skyline_packer::skyline_packer(uint32_t width, uint32_t height) :
+        _width(width), _height(height) {
+    reset();
+}
+
+void skyline_packer::reset() {
+    _skyline.clear();
+    _skyline.push_back({ 0, 0, _width });
+    _usedArea = 0;
+}
+
+bool skyline_packer::fit(size_t i, uint32_t width, uint32_t height, uint32_t& y) const {
+    uint32_t x = _skyline[i].x;
+    if (width > _width - x) return false;
+    // the rectangle rests on the highest segment under it
+    uint32_t top = 0;
+    uint32_t remaining = width;
+    for (size_t j = i; remaining > 0; ++j) {
+        top = std::max(top, _skyline[j].y);
+        if (height > _height - top) return false;
+        remaining -= std::min(remaining, _skyline[j].width);
+    }
+    y = top;
+    return true;
+}
+
+bool skyline_packer::insert(uint32_t width, uint32_t height, rect& out) {
+    if (width == 0 || height == 0) return false;
+
+    size_t best = _skyline.size();
+    uint32_t bestTop = UINT32_MAX, bestWidth = UINT32_MAX, bestY = 0;
+    for (size_t i = 0; i < _skyline.size(); ++i) {
+        uint32_t y;
+        if (!fit(i, width, height, y)) continue;
+        uint32_t top = y + height;
+        if (top < bestTop || (top == bestTop && _skyline[i].width < bestWidth)) {
+            best = i;
+            bestTop = top;
+            bestWidth = _skyline[i].width;
+            bestY = y;
+        }
+    }
+    if (best == _skyline.size()) return false;
+
+    out = { _skyline[best].x, bestY, width, height };
+    _usedArea += (size_t) width * height;
+
+    // the new segment covers the rectangle's top, shorten or remove the ones it now hides
+    _skyline.insert(_skyline.begin() + best, { out.x, bestTop, width });
+    uint32_t right = out.x + width;
+    size_t i = best + 1;
+    while (i < _skyline.size() && _skyline[i].x < right) {
+        segment& s = _skyline[i];
+        uint32_t end = s.x + s.width;
+        if (end <= right) {
+            _skyline.erase(_skyline.begin() + i);
+        } else {
+            s.width = end - right;
+            s.x = right;
+            break;
+        }
+    }
+
+    // merge neighbours at the same height
+    for (size_t j = 0; j + 1 < _skyline.size();) {
+        if (_skyline[j].y == _skyline[j + 1].y) {
+            _skyline[j].width += _skyline[j + 1].width;
+            _skyline.erase(_skyline.begin() + j + 1);
+        } else {
+            ++j;
+        }
+    }
+    return true;
+}
+
+}  // namespace ogu
@@ -0,0 +1,180 @@
+#include "render_queue.h"
+
+#include <stdexcept>
+#include <utility>
+
+#include "init.h"
+#include "instrumentation.h"
+
+
+namespace ogu {
+
+void* command_buffer::record(uint64_t key, command_type type, size_t payloadSize) {
+    const size_t alignment = alignof(std::max_align_t);
+    size_t size = (sizeof(commands::header) + payloadSize + alignment - 1) & ~(alignment - 1);
+    if (size > CHUNK_SIZE) throw std::length_error("Command larger than a command buffer chunk.");
+
+    if (_chunks.empty() || _chunkHead + size > CHUNK_SIZE) {
+        if (!_chunks.empty()) ++_chunk;
+        if (_chunk == _chunks.size()) {
+            _chunks.emplace_back(new uint8_t[CHUNK_SIZE]);
+        }
+        _chunkHead = 0;
+    }
+
+    auto* pHeader = (commands::header*) (_chunks[_chunk].get() + _chunkHead);
+    pHeader->type = type;
+    pHeader->size = (uint32_t) payloadSize;
+    _chunkHead += size;
+    _bytesUsed += size;
+    _entries.push_back({ key, pHeader });
+    return pHeader + 1;
+}
+
+void command_buffer::bindProgram(uint64_t key, const shader_program& program) {
+    auto* pCommand = (commands::bind_program*) record(key, command_type::BIND_PROGRAM, sizeof(commands::bind_program));
+    pCommand->program = &program;
+}
+
+void command_buffer::bindVertexArray(uint64_t key, const vertex_array& vertexArray) {
+    auto* pCommand = (commands::bind_vertex_array*) record(key, command_type::BIND_VERTEX_ARRAY,
+        sizeof(commands::bind_vertex_array));
+    pCommand->vertexArray = &vertexArray;
+}
+
+void command_buffer::bindTexture(uint64_t key, uint32_t unit, const Texture& texture) {
+    auto* pCommand = (commands::bind_texture*) record(key, command_type::BIND_TEXTURE, sizeof(commands::bind_texture));
+    pCommand->texture = &texture;
+    pCommand->unit = unit;
+}
+
+void command_buffer::drawElements(uint64_t key, GLenum mode, GLsizei count, GLenum indexType, uintptr_t indexOffset,
+        GLsizei instanceCount, GLint baseVertex) {
+    auto* pCommand = (commands::draw_elements*) record(key, command_type::DRAW_ELEMENTS, sizeof(commands::draw_elements));
+    *pCommand = { mode, count, indexType, instanceCount, baseVertex, indexOffset };
+}
+
+void command_buffer::drawArrays(uint64_t key, GLenum mode, GLint first, GLsizei count, GLsizei instanceCount) {
+    auto* pCommand = (commands::draw_arrays*) record(key, command_type::DRAW_ARRAYS, sizeof(commands::draw_arrays));
+    *pCommand = { mode, first, count, instanceCount };
+}
+
+void command_buffer::reset() {
+    _chunk = 0;
+    _chunkHead = 0;
+    _bytesUsed = 0;
+    _entries.clear();
+}
+
+command_buffer render_queue::acquire() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_free.empty()) return command_buffer();
+    command_buffer commands = std::move(_free.back());
+    _free.pop_back();
+    return commands;
+}
+
+void render_queue::submit(command_buffer&& commands) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _submitted.push_back(std::move(commands));
+}
+
+void render_queue::sort(std::vector<command_buffer::entry>& entries, std::vector<command_buffer::entry>& scratch) {
+    const size_t n = entries.size();
+    if (n < 2) return;
+    scratch.resize(n);
+
+    // all eight histograms in one pass, then skip the digits every key agrees on
+    size_t counts[8][256] = {};
+    for (const auto& e : entries) {
+        for (int digit = 0; digit < 8; ++digit) {
+            ++counts[digit][(e.key >> (digit * 8)) & 0xff];
+        }
+    }
+
+    auto* pSrc = &entries;
+    auto* pDst = &scratch;
+    for (int digit = 0; digit < 8; ++digit) {
+        size_t* count = counts[digit];
+        if (count[((*pSrc)[0].key >> (digit * 8)) & 0xff] == n) continue;
+
+        size_t offset = 0;
+        for (int i = 0; i < 256; ++i) {
+            size_t c = count[i];
+            count[i] = offset;
+            offset += c;
+        }
+        for (const auto& e : *pSrc) {
+            (*pDst)[count[(e.key >> (digit * 8)) & 0xff]++] = e;
+        }
+        std::swap(pSrc, pDst);
+    }
+    if (pSrc != &entries) entries.swap(scratch);
+}
+
+void render_queue::replay(const commands::header& command) {
+    const void* pPayload = &command + 1;
+    switch (command.type) {
+    case command_type::BIND_PROGRAM:
+        static_cast<const commands::bind_program*>(pPayload)->program->use();
+        break;
+    case command_type::BIND_VERTEX_ARRAY:
+        static_cast<const commands::bind_vertex_array*>(pPayload)->vertexArray->bind();
+        break;
+    case command_type::BIND_TEXTURE: {
+        auto* c = static_cast<const commands::bind_texture*>(pPayload);
+        c->texture->bind(c->unit);
+        break;
+    }
+    case command_type::SET_UNIFORM: {
+        auto* c = static_cast<const commands::set_uniform*>(pPayload);
+        // uniform<T>::set falls back to glUniform*, which sets the program in use
+        if (!getFeatures().directStateAccess) state_cache::current().useProgram(c->program);
+        c->set(c->program, c->location, c + 1);
+        break;
+    }
+    case command_type::DRAW_ELEMENTS: {
+        auto* c = static_cast<const commands::draw_elements*>(pPayload);
+        glDrawElementsInstancedBaseVertex(c->mode, c->count, c->indexType, (const void*) c->indexOffset,
+            c->instanceCount, c->baseVertex);
+        OGU_COUNT_CALL(DRAW);
+        break;
+    }
+    case command_type::DRAW_ARRAYS: {
+        auto* c = static_cast<const commands::draw_arrays*>(pPayload);
+        glDrawArraysInstanced(c->mode, c->first, c->count, c->instanceCount);
+        OGU_COUNT_CALL(DRAW);
+        break;
+    }
+    }
+}
+
+void render_queue::execute() {
+    std::vector<command_buffer> submitted;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        submitted.swap(_submitted);
+    }
+
+    _lastStats = {};
+    _lastStats.buffers = submitted.size();
+    _entries.clear();
+    for (const auto& commands : submitted) {
+        _entries.insert(_entries.end(), commands.entries().begin(), commands.entries().end());
+        _lastStats.bytes += commands.bytesUsed();
+    }
+    _lastStats.commands = _entries.size();
+
+    sort(_entries, _scratch);
+    for (const auto& e : _entries) {
+        replay(*e.pCommand);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& commands : submitted) {
+        commands.reset();
+        _free.push_back(std::move(commands));
+    }
+}
+
+}  // namespace ogu
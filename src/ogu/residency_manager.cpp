@@ -0,0 +1,245 @@
+#include "residency_manager.h"
+
+#include "init.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace ogu {
+
+residency_manager::residency_manager(size_t budgetBytes, uint32_t maxReloadsPerFrame) :
+        _budget(budgetBytes), _maxReloadsPerFrame(maxReloadsPerFrame) {
+}
+
+residency_manager::texture_id residency_manager::addTexture(texture_source source, uint32_t maxDroppedLevels, bool loadNow) {
+    texture_id id;
+    if (!_freeIds.empty()) {
+        id = _freeIds.back();
+        _freeIds.pop_back();
+    } else {
+        id = (texture_id) _entries.size();
+        _entries.emplace_back();
+    }
+
+    entry& e = _entries[id];
+    e.source = std::move(source);
+    e.texture.reset();
+    e.maxDroppedLevels = maxDroppedLevels;
+    e.droppedLevels = 0;
+    e.lastUsed = 0;
+    e.bytes = 0;
+    e.active = true;
+
+    if (loadNow) load(e, 0);
+    return id;
+}
+
+void residency_manager::removeTexture(texture_id id) {
+    entry& e = _entries.at(id);
+    if (!e.active) return;
+    release(e);
+    e.source = nullptr;
+    e.active = false;
+    _freeIds.push_back(id);
+}
+
+Texture* residency_manager::bind(texture_id id, uint32_t unit) {
+    entry& e = _entries.at(id);
+    if (!e.active) throw std::invalid_argument("Texture id has been removed.");
+    if (!e.texture) load(e, e.droppedLevels);
+    e.lastUsed = _frame;
+    e.texture->bind(unit);
+    return e.texture.get();
+}
+
+Texture* residency_manager::get(texture_id id) const {
+    return _entries.at(id).texture.get();
+}
+
+uint32_t residency_manager::droppedLevels(texture_id id) const {
+    return _entries.at(id).droppedLevels;
+}
+
+void residency_manager::track(const buffer& b) {
+    auto result = _buffers.emplace(&b, b.size());
+    if (result.second) _bufferBytes += b.size();
+}
+
+void residency_manager::untrack(const buffer& b) {
+    auto it = _buffers.find(&b);
+    if (it == _buffers.end()) return;
+    _bufferBytes -= it->second;
+    _buffers.erase(it);
+}
+
+void residency_manager::track(const Texture& t) {
+    if (std::find(_textures.begin(), _textures.end(), &t) == _textures.end()) {
+        _textures.push_back(&t);
+    }
+}
+
+void residency_manager::untrack(const Texture& t) {
+    auto it = std::find(_textures.begin(), _textures.end(), &t);
+    if (it != _textures.end()) {
+        *it = _textures.back();
+        _textures.pop_back();
+    }
+}
+
+size_t residency_manager::trackedBytes() const {
+    size_t bytes = _bufferBytes;
+    for (const Texture* t : _textures) {
+        bytes += t->getMemorySize();
+    }
+    return bytes;
+}
+
+void residency_manager::load(entry& e, uint32_t droppedLevels) {
+    // free the old storage first so the two never have to fit at once
+    release(e);
+    e.texture = e.source(droppedLevels);
+    if (!e.texture) throw std::runtime_error("Texture source returned no texture.");
+    ++_reloads;
+
+    e.droppedLevels = droppedLevels;
+    e.bytes = e.texture->getMemorySize();
+    _textureBytes += e.bytes;
+
+    // at least one level always stays, now that the full chain length is known
+    uint32_t fullLevels = e.texture->getLevels() + droppedLevels;
+    e.maxDroppedLevels = std::min(e.maxDroppedLevels, fullLevels > 0 ? fullLevels - 1 : 0);
+}
+
+void residency_manager::release(entry& e) {
+    if (!e.texture) return;
+    _textureBytes -= e.bytes;
+    e.bytes = 0;
+    e.texture.reset();
+}
+
+size_t residency_manager::evict(entry& e, size_t want) {
+    const Texture& t = *e.texture;
+    size_t before = e.bytes;
+
+    uint32_t allowed = std::min(e.maxDroppedLevels - std::min(e.maxDroppedLevels, e.droppedLevels),
+        t.getLevels() > 0 ? t.getLevels() - 1 : 0);
+    uint32_t drop = 0;
+    size_t freed = 0;
+    while (drop < allowed && freed < want) {
+        freed += t.getLevelMemorySize(drop++);
+    }
+
+    if (drop > 0 && freed >= want) {
+        load(e, e.droppedLevels + drop);
+        ++_levelDrops;
+    } else {
+        // dropping levels isn't enough, next time it comes back as small as allowed
+        release(e);
+        e.droppedLevels = e.maxDroppedLevels;
+        ++_releases;
+    }
+    return before > e.bytes ? before - e.bytes : 0;
+}
+
+void residency_manager::update() {
+    size_t used = _textureBytes + trackedBytes();
+
+    if (used > _budget) {
+        std::vector<texture_id> candidates;
+        for (texture_id id = 0; id < _entries.size(); ++id) {
+            if (_entries[id].active && _entries[id].texture) candidates.push_back(id);
+        }
+        // least recently bound first, the ones bound this frame end up last
+        std::sort(candidates.begin(), candidates.end(), [this] (texture_id a, texture_id b) {
+            return _entries[a].lastUsed < _entries[b].lastUsed;
+        });
+        for (texture_id id : candidates) {
+            if (used <= _budget) break;
+            size_t freed = evict(_entries[id], used - _budget);
+            used -= std::min(used, freed);
+        }
+        // reloads may have come out larger than estimated, so measure again
+        used = _textureBytes + trackedBytes();
+        if (used > _budget) ++_overBudgetFrames;
+    } else {
+        uint32_t reloads = 0;
+        for (entry& e : _entries) {
+            if (reloads >= _maxReloadsPerFrame) break;
+            if (!e.active || !e.texture || e.droppedLevels == 0 || e.lastUsed != _frame) continue;
+
+            // each restored level is estimated from how much the top two resident levels differ
+            const Texture& t = *e.texture;
+            size_t levelBytes = t.getLevelMemorySize(0);
+            size_t growth = (t.getLevels() > 1 && t.getLevelMemorySize(1) > 0)
+                ? std::max<size_t>(levelBytes / t.getLevelMemorySize(1), 1) : 4;
+            uint32_t target = e.droppedLevels;
+            size_t extra = 0;
+            while (target > 0) {
+                levelBytes *= growth;
+                if (used + extra + levelBytes > _budget) break;
+                extra += levelBytes;
+                --target;
+            }
+            if (target == e.droppedLevels) continue;
+
+            size_t before = e.bytes;
+            load(e, target);
+            used = used - before + e.bytes;
+            ++reloads;
+        }
+    }
+
+    ++_frame;
+}
+
+bool residency_manager::queryDriverMemory(driver_memory& out) {
+    if (getFeatures().gpuMemoryInfoNVX) {
+        GLint totalKb = 0, availableKb = 0;
+        glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &totalKb);
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &availableKb);
+        out.totalBytes = (size_t) totalKb * 1024;
+        out.availableBytes = (size_t) availableKb * 1024;
+        return true;
+    }
+    if (getFeatures().memInfoATI) {
+        // total free, largest free block, total auxiliary free, largest auxiliary free block
+        GLint info[4] = {};
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, info);
+        out.totalBytes = 0;
+        out.availableBytes = (size_t) info[0] * 1024;
+        return true;
+    }
+    return false;
+}
+
+bool residency_manager::calibrate(size_t reserveBytes) {
+    driver_memory memory;
+    if (!queryDriverMemory(memory)) return false;
+    size_t usable = _textureBytes + trackedBytes() + memory.availableBytes;
+    _budget = usable > reserveBytes ? usable - reserveBytes : 0;
+    return true;
+}
+
+residency_manager::stats residency_manager::getStats() const {
+    stats s {};
+    s.budgetBytes = _budget;
+    s.textureBytes = _textureBytes;
+    s.trackedBytes = trackedBytes();
+    for (const entry& e : _entries) {
+        if (!e.active) continue;
+        if (!e.texture) {
+            ++s.texturesEvicted;
+        } else {
+            ++s.texturesResident;
+            if (e.droppedLevels > 0) ++s.texturesReduced;
+        }
+    }
+    s.levelDrops = _levelDrops;
+    s.releases = _releases;
+    s.reloads = _reloads;
+    s.overBudgetFrames = _overBudgetFrames;
+    return s;
+}
+
+}  // namespace ogu
@@ -1,14 +1,16 @@
 #include "shader.h"
 
+#include <algorithm>
 #include <stdexcept>
+#include <utility>
 
 #define SHADER_PROGRAM_ERR_NO_ACTIVE_UNIFORM 0
 
 
 namespace ogu {
 
-shader::shader(const std::vector<std::string>& sources, shader::type type) {
-    handle = glCreateShader((GLenum) type);
+GLuint shader::compile(const std::vector<std::string>& sources, shader::type type) {
+    GLuint handle = glCreateShader((GLenum) type);
 
     std::vector<const GLchar*> codeStrings(sources.size());
     for (auto i = 0u; i < sources.size(); ++i)
@@ -16,62 +18,127 @@ shader::shader(const std::vector<std::string>& sources, shader::type type) {
 
     glShaderSource(handle, sources.size(), codeStrings.data(), nullptr);
     glCompileShader(handle);
+    return handle;
+}
 
+void shader::checkCompileStatus(GLuint shader) {
     GLint status;
-    glGetShaderiv(handle, GL_COMPILE_STATUS, &status);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
     if (!status) {
         GLint infoLogLength;
-        glGetShaderiv(handle, GL_INFO_LOG_LENGTH, &infoLogLength);
-        std::vector<char> infoLog(infoLogLength);
-        glGetShaderInfoLog(handle, infoLogLength, nullptr, infoLog.data());
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLogLength);
+        std::vector<char> infoLog(infoLogLength + 1);
+        glGetShaderInfoLog(shader, infoLogLength, nullptr, infoLog.data());
+        glDeleteShader(shader);
         throw std::runtime_error(std::string("Shader compile failed. ") + infoLog.data());
     }
 }
 
+shader::shader(const std::vector<std::string>& sources, shader::type type) {
+    handle = compile(sources, type);
+    checkCompileStatus(handle);
+    OGU_OBJECT_CREATED(SHADER, 0);
+}
+
+shader::shader(shader&& s) :
+        handle(s.handle) {
+    s.handle = 0;
+}
+
 shader::~shader() {
+    if (handle) OGU_OBJECT_DESTROYED(SHADER, 0);
     glDeleteShader(handle);
 }
 
-shader_program::shader_program(const std::initializer_list<shader>& shaders) {
-    handle = glCreateProgram();
-    for (const auto& shader : shaders) {
-        glAttachShader(handle, shader.handle);
+void shader_program::checkLinkStatus(GLuint program) {
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status) {
+        GLint infoLogLength;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &infoLogLength);
+        std::vector<char> infoLog(infoLogLength + 1);
+        glGetProgramInfoLog(program, infoLogLength, nullptr, infoLog.data());
+        glDeleteProgram(program);
+        throw std::runtime_error(std::string("Shader program link failed.") + infoLog.data());
     }
+}
 
-    glLinkProgram(handle);
+GLuint shader_program::link(const shader* const* pShaders, size_t count, bool binaryRetrievable) {
+    GLuint program = glCreateProgram();
+    if (binaryRetrievable) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        glAttachShader(program, pShaders[i]->handle);
+    }
 
-    for (const auto& shader : shaders) {
-        glDetachShader(handle, shader.handle);
+    glLinkProgram(program);
+
+    for (size_t i = 0; i < count; ++i) {
+        glDetachShader(program, pShaders[i]->handle);
     }
 
-    GLint status;
-    glGetProgramiv(handle, GL_LINK_STATUS, &status);
-    if (!status) {
-        GLint infoLogLength;
-        glGetProgramiv(handle, GL_INFO_LOG_LENGTH, &infoLogLength);
-        std::vector<char> infoLog(infoLogLength);
-        glGetProgramInfoLog(handle, infoLogLength, nullptr, infoLog.data());
-        throw std::runtime_error(std::string("Shader program link failed.") + infoLog.data());
+    checkLinkStatus(program);
+    return program;
+}
+
+shader_program::shader_program(GLuint handle) :
+        handle(handle),
+        reflection(handle) {
+    OGU_OBJECT_CREATED(PROGRAM, 0);
+}
+
+shader_program::shader_program(const std::initializer_list<shader>& shaders) {
+    std::vector<const shader*> pShaders;
+    for (const auto& shader : shaders) {
+        pShaders.push_back(&shader);
     }
+    handle = link(pShaders.data(), pShaders.size(), false);
+    reflection = program_reflection(handle);
+    OGU_OBJECT_CREATED(PROGRAM, 0);
+}
 
-    
+shader_program::shader_program(shader_program&& p) :
+        handle(p.handle),
+        uniformLocations(std::move(p.uniformLocations)),
+        uniformBufferIndices(std::move(p.uniformBufferIndices)),
+        uniformHashes(std::move(p.uniformHashes)),
+        num_ubo_bindings(p.num_ubo_bindings),
+        reflection(std::move(p.reflection)) {
+    p.handle = 0;
 }
 
 shader_program::~shader_program() {
+    if (handle) {
+        state_cache::current().forgetProgram(handle);
+        OGU_OBJECT_DESTROYED(PROGRAM, 0);
+    }
     glDeleteProgram(handle);
 }
 
 void shader_program::addUniform(const std::string& name) {
-    GLint location = glGetUniformLocation(handle, name.c_str());
+    // Only individual array elements ("name[3]") aren't in the reflected table
+    const auto* pUniform = reflection.findUniform(name);
+    GLint location = pUniform ? pUniform->location
+        : (!name.empty() && name.back() == ']' ? glGetUniformLocation(handle, name.c_str()) : -1);
     #if SHADER_PROGRAM_ERR_NO_ACTIVE_UNIFORM == 1
     if (location == -1) throw std::runtime_error("Uniform name \"" + name + "\" is not an active uniform in the program.");
     #endif
     uniformLocations[name] = location;
+
+    uint64_t hash = fnv1a(name);
+    auto it = std::lower_bound(uniformHashes.begin(), uniformHashes.end(), std::make_pair(hash, INT32_MIN));
+    if (it != uniformHashes.end() && it->first == hash) {
+        it->second = location;
+    } else {
+        uniformHashes.emplace(it, hash, location);
+    }
 }
 
 void shader_program::addUniformBuffer(const std::string& name) {
     auto& i = uniformBufferIndices[name];
-    i.index = glGetUniformBlockIndex(handle, name.c_str());
+    const auto* pBlock = reflection.findUniformBlock(name);
+    i.index = pBlock ? (GLint) pBlock->index : (GLint) GL_INVALID_INDEX;
     i.binding = num_ubo_bindings++;
     #if SHADER_PROGRAM_ERR_NO_ACTIVE_UNIFORM == 1
     if (index == -1) throw std::runtime_error("Uniform block name \"" + name + "\" is not an active uniform block in the program.");
@@ -79,20 +146,139 @@ void shader_program::addUniformBuffer(const std::string& name) {
     glUniformBlockBinding(handle, i.index, i.binding);
 }
 
+enum class uniform_base {
+    FLOAT,
+    INT,
+    UINT
+};
+
+// Component type, count and (for square matrices) column count of the uniform types whose values are
+// copied when a program is replaced
+static bool uniformShape(GLenum type, uniform_base& base, int& components, int& columns) {
+    columns = 0;
+    switch (type) {
+    case GL_FLOAT: base = uniform_base::FLOAT; components = 1; return true;
+    case GL_FLOAT_VEC2: base = uniform_base::FLOAT; components = 2; return true;
+    case GL_FLOAT_VEC3: base = uniform_base::FLOAT; components = 3; return true;
+    case GL_FLOAT_VEC4: base = uniform_base::FLOAT; components = 4; return true;
+    case GL_FLOAT_MAT2: base = uniform_base::FLOAT; components = 4; columns = 2; return true;
+    case GL_FLOAT_MAT3: base = uniform_base::FLOAT; components = 9; columns = 3; return true;
+    case GL_FLOAT_MAT4: base = uniform_base::FLOAT; components = 16; columns = 4; return true;
+    case GL_INT:
+    case GL_BOOL: base = uniform_base::INT; components = 1; return true;
+    case GL_INT_VEC2:
+    case GL_BOOL_VEC2: base = uniform_base::INT; components = 2; return true;
+    case GL_INT_VEC3:
+    case GL_BOOL_VEC3: base = uniform_base::INT; components = 3; return true;
+    case GL_INT_VEC4:
+    case GL_BOOL_VEC4: base = uniform_base::INT; components = 4; return true;
+    case GL_UNSIGNED_INT: base = uniform_base::UINT; components = 1; return true;
+    case GL_UNSIGNED_INT_VEC2: base = uniform_base::UINT; components = 2; return true;
+    case GL_UNSIGNED_INT_VEC3: base = uniform_base::UINT; components = 3; return true;
+    case GL_UNSIGNED_INT_VEC4: base = uniform_base::UINT; components = 4; return true;
+    // samplers and images hold their unit
+    case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_CUBE_SHADOW: case GL_SAMPLER_BUFFER: case GL_SAMPLER_2D_RECT:
+    case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_CUBE_MAP_ARRAY:
+    case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_2D_ARRAY: case GL_INT_SAMPLER_BUFFER:
+    case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D: case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+    case GL_IMAGE_2D: case GL_IMAGE_3D: case GL_IMAGE_2D_ARRAY: case GL_IMAGE_CUBE: case GL_IMAGE_BUFFER:
+    case GL_INT_IMAGE_2D: case GL_UNSIGNED_INT_IMAGE_2D:
+        base = uniform_base::INT; components = 1; return true;
+    default:
+        return false;
+    }
+}
+
+static void copyUniform(GLuint from, GLint fromLocation, GLuint to, GLint toLocation, GLenum type) {
+    uniform_base base;
+    int components, columns;
+    if (!uniformShape(type, base, components, columns)) return;
+    const bool dsa = getFeatures().directStateAccess;
+    if (!dsa) state_cache::current().useProgram(to);
+
+    if (base == uniform_base::FLOAT) {
+        GLfloat v[16];
+        glGetUniformfv(from, fromLocation, v);
+        switch (columns ? columns + 3 : components) {
+        case 1: dsa ? glProgramUniform1f(to, toLocation, v[0]) : glUniform1f(toLocation, v[0]); break;
+        case 2: dsa ? glProgramUniform2fv(to, toLocation, 1, v) : glUniform2fv(toLocation, 1, v); break;
+        case 3: dsa ? glProgramUniform3fv(to, toLocation, 1, v) : glUniform3fv(toLocation, 1, v); break;
+        case 4: dsa ? glProgramUniform4fv(to, toLocation, 1, v) : glUniform4fv(toLocation, 1, v); break;
+        case 5: dsa ? glProgramUniformMatrix2fv(to, toLocation, 1, GL_FALSE, v) : glUniformMatrix2fv(toLocation, 1, GL_FALSE, v); break;
+        case 6: dsa ? glProgramUniformMatrix3fv(to, toLocation, 1, GL_FALSE, v) : glUniformMatrix3fv(toLocation, 1, GL_FALSE, v); break;
+        case 7: dsa ? glProgramUniformMatrix4fv(to, toLocation, 1, GL_FALSE, v) : glUniformMatrix4fv(toLocation, 1, GL_FALSE, v); break;
+        }
+    } else if (base == uniform_base::INT) {
+        GLint v[4];
+        glGetUniformiv(from, fromLocation, v);
+        switch (components) {
+        case 1: dsa ? glProgramUniform1i(to, toLocation, v[0]) : glUniform1i(toLocation, v[0]); break;
+        case 2: dsa ? glProgramUniform2iv(to, toLocation, 1, v) : glUniform2iv(toLocation, 1, v); break;
+        case 3: dsa ? glProgramUniform3iv(to, toLocation, 1, v) : glUniform3iv(toLocation, 1, v); break;
+        case 4: dsa ? glProgramUniform4iv(to, toLocation, 1, v) : glUniform4iv(toLocation, 1, v); break;
+        }
+    } else {
+        GLuint v[4];
+        glGetUniformuiv(from, fromLocation, v);
+        switch (components) {
+        case 1: dsa ? glProgramUniform1ui(to, toLocation, v[0]) : glUniform1ui(toLocation, v[0]); break;
+        case 2: dsa ? glProgramUniform2uiv(to, toLocation, 1, v) : glUniform2uiv(toLocation, 1, v); break;
+        case 3: dsa ? glProgramUniform3uiv(to, toLocation, 1, v) : glUniform3uiv(toLocation, 1, v); break;
+        case 4: dsa ? glProgramUniform4uiv(to, toLocation, 1, v) : glUniform4uiv(toLocation, 1, v); break;
+        }
+    }
+}
+
+void shader_program::replaceHandle(GLuint program) {
+    program_reflection newReflection(program);
+
+    // values set once, e.g. sampler units, would otherwise silently go back to zero
+    uniformHashes.clear();
+    for (auto& u : uniformLocations) {
+        const auto* pOld = reflection.findUniform(u.first);
+        const auto* pNew = newReflection.findUniform(u.first);
+        GLint location = pNew ? pNew->location
+            : (!u.first.empty() && u.first.back() == ']' ? glGetUniformLocation(program, u.first.c_str()) : -1);
+        if (pOld && pNew && pOld->type == pNew->type && pNew->arraySize == 1 && u.second != -1 && location != -1) {
+            copyUniform(handle, u.second, program, location, pNew->type);
+        }
+        u.second = location;
+        uniformHashes.emplace_back(fnv1a(u.first), location);
+    }
+    std::sort(uniformHashes.begin(), uniformHashes.end());
+
+    for (auto& b : uniformBufferIndices) {
+        const auto* pBlock = newReflection.findUniformBlock(b.first);
+        b.second.index = pBlock ? (GLint) pBlock->index : (GLint) GL_INVALID_INDEX;
+        if (pBlock) glUniformBlockBinding(program, b.second.index, b.second.binding);
+    }
+
+    state_cache::current().forgetProgram(handle);
+    glDeleteProgram(handle);
+    handle = program;
+    reflection = std::move(newReflection);
+}
+
 // Scalar types: int, unsigned int, float
 
 template<>
 void shader_program::setUniform(const std::string& name, int value) const {
+    OGU_COUNT_CALL(UNIFORM);
     glUniform1i(uniformLocations.at(name), value);
 }
 
 template<>
 void shader_program::setUniform(const std::string& name, unsigned int value) const {
+    OGU_COUNT_CALL(UNIFORM);
     glUniform1ui(uniformLocations.at(name), value);
 }
 
 template<>
 void shader_program::setUniform(const std::string& name, float value) const {
+    OGU_COUNT_CALL(UNIFORM);
     glUniform1f(uniformLocations.at(name), value);
 }
 
@@ -100,16 +286,26 @@ GLint shader_program::getUniformLocation(const std::string& name) const {
     return uniformLocations.at(name);
 }
 
+GLint shader_program::getUniformLocation(uniform_name name) const {
+    auto it = std::lower_bound(uniformHashes.begin(), uniformHashes.end(), std::make_pair(name.hash, INT32_MIN));
+    if (it == uniformHashes.end() || it->first != name.hash) throw std::out_of_range("Uniform has not been added to the program.");
+    return it->second;
+}
+
 void shader_program::bindUniformBuffer(const std::string& name, const buffer& buffer) const {
     const auto& i = uniformBufferIndices.at(name);
     // glUniformBlockBinding(handle, i.index, i.binding);
-    glBindBufferBase(GL_UNIFORM_BUFFER, i.binding, buffer.handle());
+    state_cache::current().bindBufferBase(GL_UNIFORM_BUFFER, i.binding, buffer.handle());
 }
 
 void shader_program::bindUniformBuffer(const std::string& name, const buffer& buffer, intptr_t offset, size_t size) const {
     const auto& i = uniformBufferIndices.at(name);
     // glUniformBlockBinding(handle, i.index, i.binding);
-    glBindBufferRange(GL_UNIFORM_BUFFER, i.binding, buffer.handle(), offset, size);
+    state_cache::current().bindBufferRange(GL_UNIFORM_BUFFER, i.binding, buffer.handle(), offset, size);
+}
+
+void shader_program::bindUniformBuffer(const std::string& name, const buffer_range& range) const {
+    bindUniformBuffer(name, *range.buf, range.offset, range.size);
 }
 
 }  // namespace ogu
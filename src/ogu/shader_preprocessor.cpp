@@ -0,0 +1,345 @@
+#include "shader_preprocessor.h"
+
+#include "hash.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+
+
+namespace ogu {
+
+// Nesting deeper than this is taken to be a cycle the guards didn't catch
+static constexpr size_t MAX_INCLUDE_DEPTH = 64;
+
+static bool fileStatus(const std::string& path, int64_t& modified, int64_t& size) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+#if defined(__linux__)
+    modified = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+    modified = (int64_t) st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    modified = (int64_t) st.st_mtime * 1000000000;
+#endif
+    size = (int64_t) st.st_size;
+    return true;
+}
+
+std::string shader_preprocessor::normalizePath(const std::string& path) {
+    std::string p = path;
+    std::replace(p.begin(), p.end(), '\\', '/');
+    const bool absolute = !p.empty() && p[0] == '/';
+
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    while (begin <= p.size()) {
+        size_t end = p.find('/', begin);
+        if (end == std::string::npos) end = p.size();
+        std::string part = p.substr(begin, end - begin);
+        if (part == "..") {
+            if (!parts.empty() && parts.back() != "..") {
+                parts.pop_back();
+            } else if (!absolute) {
+                parts.push_back(part);
+            }
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        begin = end + 1;
+    }
+
+    std::string result = absolute ? "/" : "";
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (i) result += '/';
+        result += parts[i];
+    }
+    return result.empty() ? "." : result;
+}
+
+static std::string directoryOf(const std::string& path) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) return "";
+    return path.substr(0, slash + 1);
+}
+
+shader_preprocessor::shader_preprocessor(std::vector<std::string> includeDirectories, bool checkTimestamps) :
+        _includeDirectories(std::move(includeDirectories)), _checkTimestamps(checkTimestamps) {
+    for (std::string& dir : _includeDirectories) {
+        dir = normalizePath(dir) + '/';
+    }
+}
+
+// "#  name  rest", false if the line isn't a directive
+static bool parseDirective(const std::string& line, std::string& name, std::string& rest) {
+    size_t i = line.find_first_not_of(" \t");
+    if (i == std::string::npos || line[i] != '#') return false;
+    i = line.find_first_not_of(" \t", i + 1);
+    if (i == std::string::npos) return false;
+    size_t end = i;
+    while (end < line.size() && (std::isalnum((unsigned char) line[end]) || line[end] == '_')) {
+        ++end;
+    }
+    name = line.substr(i, end - i);
+    size_t restBegin = line.find_first_not_of(" \t", end);
+    size_t restEnd = line.find_last_not_of(" \t\r");
+    rest = (restBegin == std::string::npos || restEnd < restBegin) ? "" : line.substr(restBegin, restEnd - restBegin + 1);
+    return true;
+}
+
+// Whether the line has code outside comments, updating the block comment state across lines
+static bool hasCode(const std::string& line, bool& inComment) {
+    bool code = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        if (inComment) {
+            if (line.compare(i, 2, "*/") == 0) {
+                inComment = false;
+                ++i;
+            }
+        } else if (line.compare(i, 2, "/*") == 0) {
+            inComment = true;
+            ++i;
+        } else if (line.compare(i, 2, "//") == 0) {
+            break;
+        } else if (!std::isspace((unsigned char) line[i])) {
+            code = true;
+        }
+    }
+    return code;
+}
+
+void shader_preprocessor::parse(parsed_file& f, const std::string& text) {
+    f.version.clear();
+    f.once = false;
+    f.segments.clear();
+
+    // for spotting an #ifndef X / #define X ... #endif guard around the whole file
+    std::string guard;
+    bool codeBeforeGuard = false, guardDefined = false, lastIsEndif = false;
+
+    segment current { "", 1, "", false, "" };
+    bool inComment = false;
+    uint32_t lineNumber = 0;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(begin, end - begin);
+        begin = end + 1;
+        ++lineNumber;
+
+        bool commentAtStart = inComment;
+        bool code = hasCode(line, inComment);
+        std::string name, rest;
+        if (commentAtStart || !code || !parseDirective(line, name, rest)) {
+            current.text += line;
+            current.text += '\n';
+            if (code) {
+                if (guard.empty()) codeBeforeGuard = true;
+                lastIsEndif = false;
+            }
+            continue;
+        }
+
+        lastIsEndif = (name == "endif");
+        if (name == "ifndef" && guard.empty() && !codeBeforeGuard) {
+            guard = rest;
+        } else if (name == "define" && !guard.empty() && !guardDefined) {
+            guardDefined = rest.compare(0, guard.size(), guard) == 0
+                && (rest.size() == guard.size() || std::isspace((unsigned char) rest[guard.size()]));
+        } else if (guard.empty()) {
+            codeBeforeGuard = true;
+        }
+
+        if (name == "version") {
+            if (f.version.empty()) f.version = line;
+            current.text += '\n';
+        } else if (name == "pragma" && rest == "once") {
+            f.once = true;
+            current.text += '\n';
+        } else if (name == "include") {
+            char close = rest.empty() ? 0 : (rest[0] == '"' ? '"' : (rest[0] == '<' ? '>' : 0));
+            size_t closeAt = close ? rest.find(close, 1) : std::string::npos;
+            if (closeAt == std::string::npos || closeAt == 1) {
+                throw std::runtime_error(f.path + ":" + std::to_string(lineNumber) + ": malformed #include.");
+            }
+            if (!current.text.empty()) f.segments.push_back(std::move(current));
+            f.segments.push_back({ "", lineNumber, rest.substr(1, closeAt - 1), close == '>', "" });
+            current = { "", lineNumber + 1, "", false, "" };
+        } else {
+            current.text += line;
+            current.text += '\n';
+        }
+    }
+    if (!current.text.empty()) f.segments.push_back(std::move(current));
+    if (!guard.empty() && guardDefined && lastIsEndif) f.once = true;
+}
+
+shader_preprocessor::parsed_file& shader_preprocessor::file(const std::string& path) {
+    auto it = _files.find(path);
+    int64_t modified = 0, size = 0;
+    if (it != _files.end()) {
+        if (!_checkTimestamps) {
+            ++_stats.fileHits;
+            return *it->second;
+        }
+        if (fileStatus(path, modified, size) && modified == it->second->modified && size == it->second->size) {
+            ++_stats.fileHits;
+            return *it->second;
+        }
+    } else if (!fileStatus(path, modified, size)) {
+        throw std::runtime_error("Can't find shader file " + path + ".");
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Can't read shader file " + path + ".");
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    std::string text = contents.str();
+    uint64_t hash = fnv1a(text);
+    ++_stats.fileReads;
+
+    if (it == _files.end()) {
+        it = _files.emplace(path, std::make_unique<parsed_file>()).first;
+        it->second->path = path;
+    } else if (it->second->hash == hash) {
+        // touched but not changed
+        it->second->modified = modified;
+        it->second->size = size;
+        ++_stats.fileHits;
+        return *it->second;
+    }
+    parsed_file& f = *it->second;
+    f.modified = modified;
+    f.size = size;
+    f.hash = hash;
+    try {
+        parse(f, text);
+    } catch (...) {
+        _files.erase(it);
+        throw;
+    }
+    return f;
+}
+
+std::string shader_preprocessor::resolve(const parsed_file& from, const segment& s) {
+    int64_t modified, size;
+    if (!s.angled) {
+        std::string candidate = normalizePath(directoryOf(from.path) + s.include);
+        if (_files.count(candidate) || fileStatus(candidate, modified, size)) return candidate;
+    }
+    for (const std::string& dir : _includeDirectories) {
+        std::string candidate = normalizePath(dir + s.include);
+        if (_files.count(candidate) || fileStatus(candidate, modified, size)) return candidate;
+    }
+    throw std::runtime_error(from.path + ":" + std::to_string(s.firstLine) + ": can't find include " + s.include + ".");
+}
+
+void shader_preprocessor::expand(parsed_file& f, expansion& e, std::string& out) {
+    if (std::find(e.stack.begin(), e.stack.end(), f.path) != e.stack.end() || e.stack.size() >= MAX_INCLUDE_DEPTH) {
+        throw std::runtime_error("Circular #include of " + f.path + ".");
+    }
+    auto id = e.ids.find(f.path);
+    if (id == e.ids.end()) {
+        id = e.ids.emplace(f.path, (uint32_t) e.dependencies.size()).first;
+        e.dependencies.push_back({ f.path, f.hash });
+    }
+    if (f.once) e.included.push_back(f.path);
+    e.stack.push_back(f.path);
+
+    for (segment& s : f.segments) {
+        if (s.include.empty()) {
+            out += "#line " + std::to_string(s.firstLine - e.lineOffset) + ' ' + std::to_string(id->second) + '\n';
+            out += s.text;
+            continue;
+        }
+        if (s.resolved.empty()) s.resolved = resolve(f, s);
+        if (std::find(e.included.begin(), e.included.end(), s.resolved) != e.included.end()) continue;
+        expand(file(s.resolved), e, out);
+    }
+    e.stack.pop_back();
+}
+
+std::shared_ptr<const shader_preprocessor::result> shader_preprocessor::process(const std::string& path,
+        const define_list& defines) {
+    const std::string root = normalizePath(path);
+    std::string key = root;
+    for (const auto& d : defines) {
+        key += '\0';
+        key += d.first;
+        key += '\0';
+        key += d.second;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto cached = _results.find(key);
+    if (cached != _results.end()) {
+        // still valid if none of the files it was built from changed
+        bool valid = true;
+        for (const dependency& d : cached->second->dependencies) {
+            if (file(d.path).hash != d.hash) {
+                valid = false;
+                break;
+            }
+        }
+        if (valid) {
+            ++_stats.resultHits;
+            return cached->second;
+        }
+    }
+
+    parsed_file& f = file(root);
+    expansion e;
+    // before GLSL 3.30 (ES 3.00) #line N gives the next line the number N + 1
+    e.lineOffset = 0;
+    std::string version;
+    if (!f.version.empty()) {
+        std::string name, rest;
+        parseDirective(f.version, name, rest);
+        int number = std::atoi(rest.c_str());
+        bool es = rest.find("es") != std::string::npos;
+        e.lineOffset = (number >= 330 || (es && number >= 300)) ? 0 : 1;
+        version = f.version;
+        if (!version.empty() && version.back() == '\r') version.pop_back();
+        version += '\n';
+    } else {
+        e.lineOffset = 1;
+    }
+
+    auto r = std::make_shared<result>();
+    r->source = version;
+    for (const auto& d : defines) {
+        r->source += "#define " + d.first + (d.second.empty() ? "" : " " + d.second) + '\n';
+    }
+    expand(f, e, r->source);
+    r->hash = fnv1a(r->source);
+    r->dependencies = std::move(e.dependencies);
+    ++_stats.builds;
+
+    _results[key] = r;
+    return r;
+}
+
+void shader_preprocessor::invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // results are rechecked against their files' hashes, so they don't need dropping
+    _files.erase(normalizePath(path));
+}
+
+void shader_preprocessor::invalidateAll() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _files.clear();
+    _results.clear();
+}
+
+shader_preprocessor::stats shader_preprocessor::getStats() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+}  // namespace ogu
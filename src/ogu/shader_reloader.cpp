@@ -0,0 +1,358 @@
+#include "shader_reloader.h"
+
+#include "init.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+
+namespace ogu {
+
+static std::string directoryOf(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return (slash == std::string::npos) ? "" : path.substr(0, slash + 1);
+}
+
+std::string shader_reloader::checkBuild(GLuint& program, const std::vector<GLuint*>& shaders) {
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked) return "";
+    for (GLuint* pShader : shaders) {
+        GLuint handle = *pShader;
+        *pShader = 0;
+        try {
+            shader::checkCompileStatus(handle);
+        } catch (const std::exception& e) {
+            return e.what();
+        }
+        *pShader = handle;
+    }
+    GLuint handle = program;
+    program = 0;
+    try {
+        shader_program::checkLinkStatus(handle);
+    } catch (const std::exception& e) {
+        return e.what();
+    }
+    return "Shader program link failed.";
+}
+
+shader_reloader::shader_reloader(shader_preprocessor& preprocessor, std::chrono::milliseconds pollInterval) :
+        _preprocessor(preprocessor), _pollInterval(pollInterval), _lastPoll(clock::now()) {
+#ifdef __linux__
+    _inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+shader_reloader::~shader_reloader() {
+    for (auto& e : _entries) {
+        if (e->pending) discard(*e->pending);
+        for (stage_state& s : e->stages) {
+            glDeleteShader(s.shader);
+        }
+    }
+#ifdef __linux__
+    if (_inotify >= 0) close(_inotify);
+#endif
+}
+
+shader_reloader::stage_state shader_reloader::compileStage(const stage& s, const shader_preprocessor::define_list& defines) {
+    auto result = _preprocessor.process(s.path, defines);
+    stage_state state { s, shader::compile({ result->source }, s.type), result->hash, {} };
+    for (const auto& d : result->dependencies) {
+        state.dependencies.push_back(d.path);
+    }
+    ++_stats.stagesCompiled;
+    return state;
+}
+
+shader_program& shader_reloader::load(const std::vector<stage>& stages, const shader_preprocessor::define_list& defines,
+        reload_callback onReload) {
+    auto e = std::make_unique<entry>();
+    e->defines = defines;
+    e->onReload = std::move(onReload);
+    auto deleteShaders = [&e] () {
+        for (stage_state& s : e->stages) {
+            glDeleteShader(s.shader);
+        }
+    };
+
+    try {
+        for (const stage& s : stages) {
+            e->stages.push_back(compileStage(s, defines));
+        }
+    } catch (...) {
+        deleteShaders();
+        throw;
+    }
+    GLuint program = glCreateProgram();
+    std::vector<GLuint*> shaders;
+    for (stage_state& s : e->stages) {
+        glAttachShader(program, s.shader);
+        shaders.push_back(&s.shader);
+    }
+    glLinkProgram(program);
+    std::string error = checkBuild(program, shaders);
+    if (!error.empty()) {
+        glDeleteProgram(program);
+        deleteShaders();
+        throw std::runtime_error(error);
+    }
+
+    e->program = std::unique_ptr<shader_program>(new shader_program(program));
+    track(*e);
+    _entries.push_back(std::move(e));
+    return *_entries.back()->program;
+}
+
+void shader_reloader::unload(const shader_program& program) {
+    entry& e = find(program);
+    if (e.pending) discard(*e.pending);
+    for (stage_state& s : e.stages) {
+        glDeleteShader(s.shader);
+    }
+    untrack(e);
+    _entries.erase(std::find_if(_entries.begin(), _entries.end(), [&e] (const std::unique_ptr<entry>& p) {
+        return p.get() == &e;
+    }));
+}
+
+shader_reloader::entry& shader_reloader::find(const shader_program& program) const {
+    for (const auto& e : _entries) {
+        if (e->program.get() == &program) return *e;
+    }
+    throw std::invalid_argument("Program isn't managed by this shader_reloader.");
+}
+
+const std::string& shader_reloader::lastError(const shader_program& program) const {
+    return find(program).lastError;
+}
+
+void shader_reloader::track(entry& e) {
+    for (const stage_state& s : e.stages) {
+        for (const std::string& path : s.dependencies) {
+            auto& dependents = _dependents[path];
+            if (std::find(dependents.begin(), dependents.end(), &e) == dependents.end()) dependents.push_back(&e);
+            watchDirectory(directoryOf(path));
+        }
+    }
+}
+
+void shader_reloader::untrack(entry& e) {
+    for (const stage_state& s : e.stages) {
+        for (const std::string& path : s.dependencies) {
+            auto it = _dependents.find(path);
+            if (it == _dependents.end()) continue;
+            it->second.erase(std::remove(it->second.begin(), it->second.end(), &e), it->second.end());
+            if (it->second.empty()) _dependents.erase(it);
+        }
+    }
+}
+
+void shader_reloader::watchDirectory(const std::string& directory) {
+#ifdef __linux__
+    if (_inotify < 0 || _watches.count(directory)) return;
+    // the directory rather than the file, so editors that save by renaming a new file over it are seen
+    int wd = inotify_add_watch(_inotify, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) return;
+    _watches[directory] = wd;
+    _watchDirectories[wd] = directory;
+#else
+    (void) directory;
+#endif
+}
+
+std::vector<std::string> shader_reloader::readEvents() {
+    std::vector<std::string> changed;
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t n = read(_inotify, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        for (char* p = buffer; p < buffer + n; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len) {
+            const inotify_event* pEvent = reinterpret_cast<inotify_event*>(p);
+            auto dir = _watchDirectories.find(pEvent->wd);
+            if (pEvent->len == 0 || dir == _watchDirectories.end()) continue;
+            std::string path = dir->second + pEvent->name;
+            if (_dependents.count(path) && std::find(changed.begin(), changed.end(), path) == changed.end()) {
+                changed.push_back(path);
+            }
+        }
+    }
+#endif
+    return changed;
+}
+
+void shader_reloader::discard(pending_link& p) {
+    glDeleteProgram(p.program);
+    for (auto& r : p.replaced) {
+        glDeleteShader(r.second.shader);
+    }
+    p.program = 0;
+    p.replaced.clear();
+}
+
+void shader_reloader::rebuild(entry& e, const std::vector<std::string>& changed, clock::time_point noticed) {
+    // the newest version of each stage, a link still in flight or the one in use; the stages the link
+    // in flight replaces are checked again, in case it has to be superseded
+    std::vector<const stage_state*> latest(e.stages.size());
+    std::vector<bool> affected(e.stages.size(), false);
+    for (size_t i = 0; i < e.stages.size(); ++i) {
+        latest[i] = &e.stages[i];
+        for (const std::string& path : e.stages[i].dependencies) {
+            if (std::find(changed.begin(), changed.end(), path) != changed.end()) affected[i] = true;
+        }
+    }
+    if (e.pending) {
+        for (const auto& r : e.pending->replaced) {
+            latest[r.first] = &r.second;
+            affected[r.first] = true;
+        }
+    }
+
+    std::vector<uint64_t> hashes(e.stages.size(), 0);
+    bool upToDate = true;
+    try {
+        for (size_t i = 0; i < e.stages.size(); ++i) {
+            if (!affected[i]) continue;
+            // saved without a real change, or only a part of an include this stage doesn't reach
+            hashes[i] = _preprocessor.process(e.stages[i].source.path, e.defines)->hash;
+            if (hashes[i] != latest[i]->hash) upToDate = false;
+        }
+    } catch (const std::exception& ex) {
+        if (e.pending) discard(*e.pending);
+        e.pending.reset();
+        e.lastError = ex.what();
+        ++_stats.failures;
+        return;
+    }
+    // nothing new, so a link in flight carries on (polling reports every file as changed)
+    if (upToDate) return;
+
+    auto p = std::make_unique<pending_link>();
+    p->program = 0;
+    p->noticed = noticed;
+    std::vector<bool> reused(e.stages.size(), false);
+    if (e.pending) {
+        // the superseded link's compiles that are still current are reused, the rest go with it
+        auto& replaced = e.pending->replaced;
+        for (auto it = replaced.begin(); it != replaced.end();) {
+            if (hashes[it->first] == it->second.hash) {
+                reused[it->first] = true;
+                p->replaced.push_back(std::move(*it));
+                it = replaced.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        p->noticed = std::min(noticed, e.pending->noticed);
+        discard(*e.pending);
+        e.pending.reset();
+    }
+    try {
+        for (size_t i = 0; i < e.stages.size(); ++i) {
+            if (!affected[i] || reused[i] || hashes[i] == e.stages[i].hash) continue;
+            p->replaced.emplace_back(i, compileStage(e.stages[i].source, e.defines));
+        }
+    } catch (const std::exception& ex) {
+        discard(*p);
+        e.lastError = ex.what();
+        ++_stats.failures;
+        return;
+    }
+    std::sort(p->replaced.begin(), p->replaced.end(), [] (const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    if (p->replaced.empty()) return;
+
+    p->program = glCreateProgram();
+    for (size_t i = 0, r = 0; i < e.stages.size(); ++i) {
+        bool replaced = r < p->replaced.size() && p->replaced[r].first == i;
+        glAttachShader(p->program, replaced ? p->replaced[r++].second.shader : e.stages[i].shader);
+    }
+    glLinkProgram(p->program);
+    e.pending = std::move(p);
+}
+
+bool shader_reloader::finishPending(entry& e) {
+    pending_link& p = *e.pending;
+    if (getFeatures().parallelShaderCompile) {
+        GLint complete = GL_FALSE;
+        glGetProgramiv(p.program, GL_COMPLETION_STATUS_KHR, &complete);
+        if (!complete) return false;
+    }
+
+    std::vector<GLuint*> shaders;
+    for (auto& r : p.replaced) {
+        shaders.push_back(&r.second.shader);
+    }
+    std::string error = checkBuild(p.program, shaders);
+    if (!error.empty()) {
+        discard(p);
+        e.pending.reset();
+        e.lastError = error;
+        ++_stats.failures;
+        return true;
+    }
+
+    untrack(e);
+    for (auto& r : p.replaced) {
+        // still attached to the old program, GL deletes it along with that
+        glDeleteShader(e.stages[r.first].shader);
+        e.stages[r.first] = std::move(r.second);
+    }
+    _stats.stagesReused += e.stages.size() - p.replaced.size();
+    e.program->replaceHandle(p.program);
+    track(e);
+
+    _stats.lastReloadMs = std::chrono::duration<double, std::milli>(clock::now() - p.noticed).count();
+    ++_stats.reloads;
+    e.lastError.clear();
+    e.pending.reset();
+    if (e.onReload) e.onReload(*e.program);
+    return true;
+}
+
+size_t shader_reloader::update() {
+    clock::time_point now = clock::now();
+    std::vector<std::string> changed;
+    if (_inotify >= 0) {
+        changed = readEvents();
+        _stats.fileEvents += changed.size();
+        // events can come faster than timestamps tick, so don't let the preprocessor trust them
+        for (const std::string& path : changed) {
+            _preprocessor.invalidate(path);
+        }
+    } else if (now - _lastPoll >= _pollInterval) {
+        // every file is a candidate, the preprocessor's timestamp checks and the hashes sort them out
+        _lastPoll = now;
+        for (const auto& d : _dependents) {
+            changed.push_back(d.first);
+        }
+    }
+
+    if (!changed.empty()) {
+        std::unordered_set<entry*> affected;
+        for (const std::string& path : changed) {
+            auto it = _dependents.find(path);
+            if (it != _dependents.end()) affected.insert(it->second.begin(), it->second.end());
+        }
+        for (entry* e : affected) {
+            rebuild(*e, changed, now);
+        }
+    }
+
+    size_t swapped = 0;
+    for (auto& e : _entries) {
+        if (e->pending && finishPending(*e) && e->lastError.empty()) ++swapped;
+    }
+    return swapped;
+}
+
+}  // namespace ogu
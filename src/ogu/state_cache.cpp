@@ -0,0 +1,190 @@
+#include "state_cache.h"
+
+#include "instrumentation.h"
+
+
+namespace ogu {
+
+static size_t bufferTargetIndex(GLenum target) {
+    switch (target) {
+    case GL_ARRAY_BUFFER: return 0;
+    case GL_ELEMENT_ARRAY_BUFFER: return 1;
+    case GL_COPY_READ_BUFFER: return 2;
+    case GL_COPY_WRITE_BUFFER: return 3;
+    case GL_PIXEL_PACK_BUFFER: return 4;
+    case GL_PIXEL_UNPACK_BUFFER: return 5;
+    case GL_UNIFORM_BUFFER: return 6;
+    case GL_TEXTURE_BUFFER: return 7;
+    case GL_TRANSFORM_FEEDBACK_BUFFER: return 8;
+    case GL_DRAW_INDIRECT_BUFFER: return 9;
+    case GL_DISPATCH_INDIRECT_BUFFER: return 10;
+    case GL_SHADER_STORAGE_BUFFER: return 11;
+    case GL_ATOMIC_COUNTER_BUFFER: return 12;
+    case GL_QUERY_BUFFER: return 13;
+    }
+    return ~(size_t) 0;
+}
+
+static size_t textureTargetIndex(GLenum target) {
+    switch (target) {
+    case GL_TEXTURE_1D: return 0;
+    case GL_TEXTURE_2D: return 1;
+    case GL_TEXTURE_3D: return 2;
+    case GL_TEXTURE_1D_ARRAY: return 3;
+    case GL_TEXTURE_2D_ARRAY: return 4;
+    case GL_TEXTURE_RECTANGLE: return 5;
+    case GL_TEXTURE_CUBE_MAP: return 6;
+    case GL_TEXTURE_CUBE_MAP_ARRAY: return 7;
+    case GL_TEXTURE_BUFFER: return 8;
+    case GL_TEXTURE_2D_MULTISAMPLE: return 9;
+    case GL_TEXTURE_2D_MULTISAMPLE_ARRAY: return 10;
+    }
+    return ~(size_t) 0;
+}
+
+state_cache& state_cache::current() {
+    static thread_local state_cache cache;
+    return cache;
+}
+
+state_cache::state_cache() {
+    invalidate();
+}
+
+void state_cache::invalidate() {
+    _program = UNKNOWN;
+    _vertexArray = UNKNOWN;
+    _buffers.fill(UNKNOWN);
+    _activeUnit = UNKNOWN;
+    for (auto& u : _textureUnits) {
+        u.fill(UNKNOWN);
+    }
+}
+
+bool state_cache::update(GLuint& cached, GLuint value) {
+    if (cached == value) {
+        ++_counters.elided;
+        return false;
+    }
+    cached = value;
+    ++_counters.issued;
+    OGU_COUNT_CALL(BIND);
+    return true;
+}
+
+state_cache::texture_unit& state_cache::textureUnit(uint32_t index) {
+    if (index >= _textureUnits.size()) {
+        texture_unit unknown;
+        unknown.fill(UNKNOWN);
+        _textureUnits.resize(index + 1, unknown);
+    }
+    return _textureUnits[index];
+}
+
+void state_cache::useProgram(GLuint program) {
+    if (update(_program, program)) {
+        glUseProgram(program);
+    }
+}
+
+void state_cache::bindVertexArray(GLuint vertexArray) {
+    if (update(_vertexArray, vertexArray)) {
+        glBindVertexArray(vertexArray);
+        // the element array binding is part of the VAO state
+        _buffers[bufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+}
+
+void state_cache::bindBuffer(GLenum target, GLuint buffer) {
+    size_t i = bufferTargetIndex(target);
+    if (i >= NUM_BUFFER_TARGETS) {
+        ++_counters.issued;
+        OGU_COUNT_CALL(BIND);
+        glBindBuffer(target, buffer);
+    } else if (update(_buffers[i], buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void state_cache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    ++_counters.issued;
+    OGU_COUNT_CALL(BIND);
+    glBindBufferBase(target, index, buffer);
+    size_t i = bufferTargetIndex(target);
+    if (i < NUM_BUFFER_TARGETS) _buffers[i] = buffer;
+}
+
+void state_cache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    ++_counters.issued;
+    OGU_COUNT_CALL(BIND);
+    glBindBufferRange(target, index, buffer, offset, size);
+    size_t i = bufferTargetIndex(target);
+    if (i < NUM_BUFFER_TARGETS) _buffers[i] = buffer;
+}
+
+void state_cache::activeTexture(uint32_t unit) {
+    if (update(_activeUnit, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+}
+
+void state_cache::bindTexture(uint32_t unit, GLenum target, GLuint texture) {
+    size_t i = textureTargetIndex(target);
+    if (i >= NUM_TEXTURE_TARGETS) {
+        activeTexture(unit);
+        ++_counters.issued;
+        OGU_COUNT_CALL(BIND);
+        glBindTexture(target, texture);
+        return;
+    }
+    GLuint& cached = textureUnit(unit)[i];
+    if (cached == texture) {
+        ++_counters.elided;
+        return;
+    }
+    activeTexture(unit);
+    update(cached, texture);
+    glBindTexture(target, texture);
+}
+
+void state_cache::bindTexture(GLenum target, GLuint texture) {
+    if (_activeUnit == UNKNOWN) {
+        // Don't know which unit a bind would land on, so it can't be tracked
+        ++_counters.issued;
+        OGU_COUNT_CALL(BIND);
+        glBindTexture(target, texture);
+        for (auto& u : _textureUnits) {
+            u.fill(UNKNOWN);
+        }
+        return;
+    }
+    bindTexture(_activeUnit, target, texture);
+}
+
+void state_cache::forgetProgram(GLuint program) {
+    // a deleted program stays in use until another one is, but its name may be reused after that
+    if (_program == program) _program = UNKNOWN;
+}
+
+void state_cache::forgetVertexArray(GLuint vertexArray) {
+    if (_vertexArray == vertexArray) {
+        _vertexArray = 0;
+        _buffers[bufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+}
+
+void state_cache::forgetBuffer(GLuint buffer) {
+    for (auto& b : _buffers) {
+        if (b == buffer) b = 0;
+    }
+}
+
+void state_cache::forgetTexture(GLuint texture) {
+    for (auto& u : _textureUnits) {
+        for (auto& t : u) {
+            if (t == texture) t = 0;
+        }
+    }
+}
+
+}  // namespace ogu
@@ -0,0 +1,105 @@
+#include "stream_buffer.h"
+
+#include <stdexcept>
+#include <utility>
+
+
+namespace ogu {
+
+static GLbitfield mapFlags(bool coherent) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT;
+    if (coherent) {
+        flags |= GL_MAP_COHERENT_BIT;
+    } else {
+        flags |= GL_MAP_FLUSH_EXPLICIT_BIT;
+    }
+    return flags;
+}
+
+// Checked before the buffer member is constructed from it
+static size_t storageSize(size_t frameSize, uint32_t numFrames) {
+    if (numFrames == 0) throw std::invalid_argument("Stream buffer needs at least one frame region.");
+    if (frameSize == 0) throw std::invalid_argument("Stream buffer frame size is 0.");
+    return frameSize * numFrames;
+}
+
+stream_buffer::stream_buffer(size_t frameSize, uint32_t numFrames, bool coherent) :
+        _buffer(storageSize(frameSize, numFrames), GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | (coherent ? GL_MAP_COHERENT_BIT : 0)),
+        _frameSize(frameSize),
+        _numFrames(numFrames),
+        _coherent(coherent),
+        _fences(numFrames, nullptr) {
+    _pMapped = static_cast<uint8_t*>(_buffer.map(0, _buffer.size(), mapFlags(coherent)));
+    assert(_pMapped);
+}
+
+stream_buffer::stream_buffer(stream_buffer&& b) :
+        _buffer(std::move(b._buffer)),
+        _frameSize(b._frameSize),
+        _numFrames(b._numFrames),
+        _coherent(b._coherent),
+        _pMapped(b._pMapped),
+        _fences(std::move(b._fences)),
+        _frame(b._frame),
+        _head(b._head),
+        _fenceWaits(b._fenceWaits) {
+    b._pMapped = nullptr;
+}
+
+stream_buffer::~stream_buffer() {
+    for (GLsync fence : _fences) {
+        if (fence) glDeleteSync(fence);
+    }
+    if (_pMapped) {
+        _buffer.unmap();
+    }
+}
+
+stream_buffer::region stream_buffer::allocate(size_t size, size_t alignment) {
+    size_t offset = _head;
+    if (alignment > 1) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+    }
+    if (offset + size > _frameSize) {
+        throw std::length_error("Stream buffer frame region exhausted.");
+    }
+    _head = offset + size;
+
+    intptr_t bufferOffset = (intptr_t) (_frame * _frameSize + offset);
+    return { _pMapped + bufferOffset, bufferOffset, size };
+}
+
+void stream_buffer::waitForFrame(uint32_t frame) {
+    GLsync& fence = _fences[frame];
+    if (!fence) return;
+
+    // Poll first so a fence that's already signaled isn't counted as a wait
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+        ++_fenceWaits;
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void stream_buffer::flush(const region& r) const {
+    if (!_coherent && r.size > 0) {
+        // the mapping covers the whole buffer, so buffer offsets are mapping offsets
+        _buffer.flushMappedRange(r.offset, r.size);
+    }
+}
+
+void stream_buffer::end_frame() {
+    _fences[_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    _frame = (_frame + 1) % _numFrames;
+    _head = 0;
+
+    waitForFrame(_frame);
+}
+
+}  // namespace ogu
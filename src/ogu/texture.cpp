@@ -1,5 +1,10 @@
 #include "texture.h"
 
+#include "init.h"
+#include "instrumentation.h"
+#include "state_cache.h"
+
+#include <algorithm>
 #include <cassert>
 
 #include <iostream>
@@ -194,6 +199,53 @@ static auto getFormat(const Texture::DepthFormat& format) {
     return std::make_tuple(internalFormat, pixelFormat, componentType);
 }
 
+static GLint getCompressedFormat(Texture::CompressedFormat format, bool srgb) {
+    switch (format) {
+    case Texture::BC1_RGB: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case Texture::BC1_RGBA: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case Texture::BC2: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT : GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+    case Texture::BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case Texture::BC7: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    case Texture::ETC2_RGB8: return srgb ? GL_COMPRESSED_SRGB8_ETC2 : GL_COMPRESSED_RGB8_ETC2;
+    case Texture::ETC2_RGB8_A1: return srgb ? GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2 : GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+    case Texture::ETC2_RGBA8: return srgb ? GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC : GL_COMPRESSED_RGBA8_ETC2_EAC;
+    default:
+        break;
+    }
+    if (srgb) throw std::invalid_argument("Compressed format has no sRGB variant.");
+    switch (format) {
+    case Texture::BC4: return GL_COMPRESSED_RED_RGTC1;
+    case Texture::BC4_SIGNED: return GL_COMPRESSED_SIGNED_RED_RGTC1;
+    case Texture::BC5: return GL_COMPRESSED_RG_RGTC2;
+    case Texture::BC5_SIGNED: return GL_COMPRESSED_SIGNED_RG_RGTC2;
+    case Texture::BC6H_UFLOAT: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+    case Texture::BC6H_SFLOAT: return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+    case Texture::EAC_R11: return GL_COMPRESSED_R11_EAC;
+    case Texture::EAC_R11_SIGNED: return GL_COMPRESSED_SIGNED_R11_EAC;
+    case Texture::EAC_RG11: return GL_COMPRESSED_RG11_EAC;
+    case Texture::EAC_RG11_SIGNED: return GL_COMPRESSED_SIGNED_RG11_EAC;
+    default:
+        break;
+    }
+    throw std::invalid_argument("Unknown compressed format.");
+}
+
+uint32_t Texture::getBlockSize(CompressedFormat format) {
+    switch (format) {
+    case BC1_RGB:
+    case BC1_RGBA:
+    case BC4:
+    case BC4_SIGNED:
+    case ETC2_RGB8:
+    case ETC2_RGB8_A1:
+    case EAC_R11:
+    case EAC_R11_SIGNED:
+        return 8;
+    default:
+        return 16;
+    }
+}
+
 static Texture::Format makeFormat(uint32_t components, Texture::ChannelFormat channelFormat, uint32_t extraFlags) {
     switch(channelFormat) {
     case Texture::U8:
@@ -209,6 +261,35 @@ static Texture::Format makeFormat(uint32_t components, Texture::ChannelFormat ch
     return {};
 }
 
+static GLenum getTarget(Texture::Dimension dimension) {
+    switch (dimension) {
+    case Texture::DIMENSION_1D:
+        return GL_TEXTURE_1D;
+    case Texture::DIMENSION_2D:
+        return GL_TEXTURE_2D;
+    case Texture::DIMENSION_3D:
+        return GL_TEXTURE_3D;
+    case Texture::DIMENSION_2D_ARRAY:
+        return GL_TEXTURE_2D_ARRAY;
+    }
+    return GL_INVALID_ENUM;
+}
+
+// Whether the depth argument means anything, as a third dimension or as the layer count
+static bool hasDepth(Texture::Dimension dimension) {
+    return dimension == Texture::DIMENSION_3D || dimension == Texture::DIMENSION_2D_ARRAY;
+}
+
+static GLuint createTexture(GLenum target) {
+    GLuint handle;
+    if (getFeatures().directStateAccess) {
+        glCreateTextures(target, 1, &handle);
+    } else {
+        glGenTextures(1, &handle);
+    }
+    return handle;
+}
+
 Texture::Texture(uint32_t width, uint32_t height, uint32_t components, Texture::ChannelFormat format, void* pPixelData, uint32_t extraFlags) :
         Texture(width, height, 1, DIMENSION_2D, makeFormat(components, format, extraFlags), pPixelData) {
 }
@@ -219,54 +300,62 @@ Texture::Texture(uint32_t width, uint32_t height, uint32_t depth, Dimension dime
 }
 
 Texture::Texture(Dimension dimension, Format format) :
-        width(0), height(0), depth(0), dimension(dimension) /*, format(format)*/ {
-    glGenTextures(1, &handle);
-
+        width(0), height(0), depth(0), levels(0), immutable(false), dimension(dimension) /*, format(format)*/ {
     std::tie(internalFormat, pixelFormat, componentType) = getFormat(format);
+    bytesPerPixel = format.components * format.bitsPerComponent / 8;
+    bytesPerBlock = 0;
+    OGU_OBJECT_CREATED(TEXTURE, 0);
 
-    switch (dimension) {
-    case DIMENSION_1D:
-        target = GL_TEXTURE_1D;
-        break;
-    case DIMENSION_2D:
-        target = GL_TEXTURE_2D;
-        break;
-    case DIMENSION_3D:
-        target = GL_TEXTURE_3D;
-        break;
-    }
+    target = getTarget(dimension);
+    handle = createTexture(target);
 }
 
 Texture::Texture(Dimension dimension, DepthFormat format) :
-        width(0), height(0), depth(0), dimension(dimension) /*, format(format)*/ {
-    glGenTextures(1, &handle);
-
+        width(0), height(0), depth(0), levels(0), immutable(false), dimension(dimension) /*, format(format)*/ {
     std::tie(internalFormat, pixelFormat, componentType) = getFormat(format);
+    bytesPerPixel = (format.depthBits == 16) ? 2 : (format.depthBits == 32 && format.hasStencilComponent ? 8 : 4);
+    bytesPerBlock = 0;
+    OGU_OBJECT_CREATED(TEXTURE, 0);
 
-    switch (dimension) {
-    case DIMENSION_1D:
-        target = GL_TEXTURE_1D;
-        break;
-    case DIMENSION_2D:
-        target = GL_TEXTURE_2D;
-        break;
-    case DIMENSION_3D:
-        target = GL_TEXTURE_3D;
-        break;
-    }
+    target = getTarget(dimension);
+    handle = createTexture(target);
+}
+
+Texture::Texture(Dimension dimension, CompressedFormat format, bool srgb) :
+        width(0), height(0), depth(0), levels(0), immutable(false), dimension(dimension) {
+    if (dimension == DIMENSION_1D) throw std::invalid_argument("Compressed formats don't support 1D textures.");
+    internalFormat = getCompressedFormat(format, srgb);
+    pixelFormat = 0;
+    componentType = 0;
+    bytesPerPixel = 0;
+    bytesPerBlock = getBlockSize(format);
+    OGU_OBJECT_CREATED(TEXTURE, 0);
+
+    target = getTarget(dimension);
+    handle = createTexture(target);
+}
+
+Texture::Texture(Texture&& t) :
+        handle(t.handle), width(t.width), height(t.height), depth(t.depth), levels(t.levels),
+        immutable(t.immutable), target(t.target), internalFormat(t.internalFormat), pixelFormat(t.pixelFormat),
+        componentType(t.componentType), bytesPerPixel(t.bytesPerPixel), bytesPerBlock(t.bytesPerBlock),
+        dimension(t.dimension) {
+    t.handle = 0;
 }
 
 Texture::~Texture() {
+    if (handle) {
+        OGU_OBJECT_DESTROYED(TEXTURE, getMemorySize());
+        state_cache::current().forgetTexture(handle);
+    }
     glDeleteTextures(1, &handle);
 }
 
 void Texture::bind(uint32_t index) const {
-    glActiveTexture(GL_TEXTURE0+index);
-    glBindTexture(target, handle);
+    state_cache::current().bindTexture(index, target, handle);
 }
 
 void Texture::setFilterMode(FilterMode magFilter, FilterMode minFilter, FilterMode mipmap) const {
-    glBindTexture(target, handle);
     GLint mag = GL_LINEAR, min = GL_LINEAR;
     switch (magFilter) {
     case FilterMode::LINEAR:
@@ -310,12 +399,17 @@ void Texture::setFilterMode(FilterMode magFilter, FilterMode minFilter, FilterMo
     case FilterMode::DISABLED:
         throw std::invalid_argument("Min filter cannot be disabled.");
     }
+    if (getFeatures().directStateAccess) {
+        glTextureParameteri(handle, GL_TEXTURE_MAG_FILTER, mag);
+        glTextureParameteri(handle, GL_TEXTURE_MIN_FILTER, min);
+        return;
+    }
+    state_cache::current().bindTexture(target, handle);
     glTexParameteri(target, GL_TEXTURE_MAG_FILTER, mag);
     glTexParameteri(target, GL_TEXTURE_MIN_FILTER, min);
 }
 
 void Texture::setEdgeMode(EdgeMode mode, float* borderColor) const {
-    glBindTexture(target, handle);
     GLint edge = GL_REPEAT;
     switch (mode) {
     case EdgeMode::BORDER:
@@ -328,6 +422,16 @@ void Texture::setEdgeMode(EdgeMode mode, float* borderColor) const {
         edge = GL_REPEAT;
         break;
     }
+    if (getFeatures().directStateAccess) {
+        glTextureParameteri(handle, GL_TEXTURE_WRAP_S, edge);
+        glTextureParameteri(handle, GL_TEXTURE_WRAP_T, edge);
+        glTextureParameteri(handle, GL_TEXTURE_WRAP_R, edge);
+        if (borderColor) {
+            glTextureParameterfv(handle, GL_TEXTURE_BORDER_COLOR, borderColor);
+        }
+        return;
+    }
+    state_cache::current().bindTexture(target, handle);
     glTexParameteri(target, GL_TEXTURE_WRAP_S, edge);
     glTexParameteri(target, GL_TEXTURE_WRAP_T, edge);
     glTexParameteri(target, GL_TEXTURE_WRAP_R, edge);
@@ -336,17 +440,159 @@ void Texture::setEdgeMode(EdgeMode mode, float* borderColor) const {
     }
 }
 
-void Texture::generateMipmaps() const {
-    glBindTexture(target, handle);
+void Texture::generateMipmaps() {
+    // glGenerateMipmap defines every level of mutable storage down to 1x1
+    if (!immutable && width != 0) {
+        [[maybe_unused]] size_t oldSize = getMemorySize();
+        levels = fullMipChainLevels(width, height, dimension == DIMENSION_3D ? depth : 1);
+        OGU_OBJECT_RESIZED(TEXTURE, oldSize, getMemorySize());
+    }
+    if (getFeatures().directStateAccess) {
+        glGenerateTextureMipmap(handle);
+        return;
+    }
+    state_cache::current().bindTexture(target, handle);
     glGenerateMipmap(target);
 }
 
+size_t Texture::getMemorySize() const {
+    size_t size = 0;
+    for (uint32_t level = 0; level < levels; ++level) {
+        size += getLevelMemorySize(level);
+    }
+    return size;
+}
+
+size_t Texture::getLevelMemorySize(uint32_t level) const {
+    if (level >= levels) return 0;
+    if (width == 0 || (dimension != DIMENSION_1D && height == 0) || (hasDepth(dimension) && depth == 0)) return 0;
+    size_t w = std::max<size_t>(width >> level, 1);
+    size_t h = (dimension == DIMENSION_1D) ? 1 : std::max<size_t>(height >> level, 1);
+    size_t d = (dimension == DIMENSION_3D) ? std::max<size_t>(depth >> level, 1)
+        : (dimension == DIMENSION_2D_ARRAY) ? depth : 1;
+    if (bytesPerBlock) return ((w + 3) / 4) * ((h + 3) / 4) * d * bytesPerBlock;
+    return w * h * d * bytesPerPixel;
+}
+
+uint32_t Texture::fullMipChainLevels(uint32_t width, uint32_t height, uint32_t depth) {
+    uint32_t size = std::max(width, std::max(height, depth));
+    uint32_t levels = 1;
+    while (size >>= 1) {
+        ++levels;
+    }
+    return levels;
+}
+
+void Texture::allocateStorage(uint32_t levels, uint32_t width, uint32_t height, uint32_t depth) {
+    if (immutable) throw std::logic_error("Texture storage is immutable and has already been allocated.");
+
+    // Unused dimensions are 1 so they don't affect the mip count
+    if (dimension == DIMENSION_1D) height = 1;
+    if (!hasDepth(dimension)) depth = 1;
+    if (levels == 0) levels = fullMipChainLevels(width, height, dimension == DIMENSION_3D ? depth : 1);
+
+    this->width = width;
+    this->height = height;
+    this->depth = depth;
+    this->levels = levels;
+    immutable = true;
+    OGU_OBJECT_RESIZED(TEXTURE, 0, getMemorySize());
+
+    if (getFeatures().directStateAccess) {
+        switch (dimension) {
+        case DIMENSION_1D:
+            glTextureStorage1D(handle, levels, internalFormat, width);
+            break;
+        case DIMENSION_2D:
+            glTextureStorage2D(handle, levels, internalFormat, width, height);
+            break;
+        case DIMENSION_3D:
+        case DIMENSION_2D_ARRAY:
+            glTextureStorage3D(handle, levels, internalFormat, width, height, depth);
+            break;
+        }
+        return;
+    }
+
+    state_cache::current().bindTexture(target, handle);
+
+    switch (dimension) {
+    case DIMENSION_1D:
+        glTexStorage1D(target, levels, internalFormat, width);
+        break;
+    case DIMENSION_2D:
+        glTexStorage2D(target, levels, internalFormat, width, height);
+        break;
+    case DIMENSION_3D:
+    case DIMENSION_2D_ARRAY:
+        glTexStorage3D(target, levels, internalFormat, width, height, depth);
+        break;
+    }
+}
+
+void Texture::writeSubPixels(uint32_t level, uint32_t x, uint32_t y, uint32_t z,
+        uint32_t width, uint32_t height, uint32_t depth, const void* pPixelData) {
+    if (bytesPerBlock) throw std::logic_error("Compressed textures are written with writeCompressedSubPixels.");
+    OGU_COUNT_CALL(UPLOAD);
+    OGU_COUNT_UPLOAD((uint64_t) width * std::max(height, 1u) * std::max(depth, 1u) * bytesPerPixel);
+    if (getFeatures().directStateAccess) {
+        switch (dimension) {
+        case DIMENSION_1D:
+            glTextureSubImage1D(handle, level, x, width, pixelFormat, componentType, pPixelData);
+            break;
+        case DIMENSION_2D:
+            glTextureSubImage2D(handle, level, x, y, width, height, pixelFormat, componentType, pPixelData);
+            break;
+        case DIMENSION_3D:
+        case DIMENSION_2D_ARRAY:
+            glTextureSubImage3D(handle, level, x, y, z, width, height, depth, pixelFormat, componentType, pPixelData);
+            break;
+        }
+        return;
+    }
+
+    state_cache::current().bindTexture(target, handle);
+
+    switch (dimension) {
+    case DIMENSION_1D:
+        glTexSubImage1D(target, level, x, width, pixelFormat, componentType, pPixelData);
+        break;
+    case DIMENSION_2D:
+        glTexSubImage2D(target, level, x, y, width, height, pixelFormat, componentType, pPixelData);
+        break;
+    case DIMENSION_3D:
+    case DIMENSION_2D_ARRAY:
+        glTexSubImage3D(target, level, x, y, z, width, height, depth, pixelFormat, componentType, pPixelData);
+        break;
+    }
+}
+
 void Texture::writePixels(uint32_t width, uint32_t height, uint32_t depth, void *pPixelData) {
+    if (bytesPerBlock) throw std::logic_error("Compressed textures are written with writeCompressedPixels.");
+    // Same-size updates of existing storage don't need to respecify it
+    bool sameSize = this->width != 0 && width == this->width
+        && (dimension == DIMENSION_1D || height == this->height)
+        && (!hasDepth(dimension) || depth == this->depth);
+    if (immutable) {
+        if (!sameSize) throw std::logic_error("Immutable texture storage cannot be resized.");
+        if (pPixelData) writeSubPixels(0, 0, 0, 0, width, height, depth, pPixelData);
+        return;
+    }
+    if (sameSize && pPixelData) {
+        writeSubPixels(0, 0, 0, 0, width, height, depth, pPixelData);
+        return;
+    }
+
+    [[maybe_unused]] size_t oldSize = getMemorySize();
     this->width = width;
     this->height = height;
     this->depth = depth;
+    levels = 1;
+    OGU_OBJECT_RESIZED(TEXTURE, oldSize, getMemorySize());
+    OGU_COUNT_CALL(UPLOAD);
+    if (pPixelData) OGU_COUNT_UPLOAD(getMemorySize());
 
-    glBindTexture(target, handle);
+    state_cache::current().bindTexture(target, handle);
     
     switch (dimension) {
     case DIMENSION_1D:
@@ -356,9 +602,79 @@ void Texture::writePixels(uint32_t width, uint32_t height, uint32_t depth, void
         glTexImage2D(target, 0, internalFormat, width, height, 0, pixelFormat, componentType, pPixelData);
         break;
     case DIMENSION_3D:
+    case DIMENSION_2D_ARRAY:
         glTexImage3D(target, 0, internalFormat, width, height, depth, 0, pixelFormat, componentType, pPixelData);
         break;
     }
 }
 
+void Texture::writeCompressedPixels(uint32_t level, uint32_t width, uint32_t height, uint32_t depth,
+        size_t dataSize, const void* pData) {
+    if (!bytesPerBlock) throw std::logic_error("Texture isn't compressed.");
+    if (immutable) throw std::logic_error("Immutable texture storage can only be updated with writeCompressedSubPixels.");
+    if (level > levels || (level > 0 && this->width == 0)) throw std::logic_error("Compressed levels must be written in order from level 0.");
+
+    [[maybe_unused]] size_t oldSize = getMemorySize();
+    if (level == 0) {
+        this->width = width;
+        this->height = height;
+        this->depth = depth;
+        levels = 1;
+    } else if (level == levels) {
+        ++levels;
+    }
+    OGU_OBJECT_RESIZED(TEXTURE, oldSize, getMemorySize());
+    OGU_COUNT_CALL(UPLOAD);
+    if (pData) OGU_COUNT_UPLOAD(dataSize);
+
+    state_cache::current().bindTexture(target, handle);
+
+    switch (dimension) {
+    case DIMENSION_1D:
+        break;
+    case DIMENSION_2D:
+        glCompressedTexImage2D(target, level, internalFormat, width, height, 0, (GLsizei) dataSize, pData);
+        break;
+    case DIMENSION_3D:
+    case DIMENSION_2D_ARRAY:
+        glCompressedTexImage3D(target, level, internalFormat, width, height, depth, 0, (GLsizei) dataSize, pData);
+        break;
+    }
+}
+
+void Texture::writeCompressedSubPixels(uint32_t level, uint32_t x, uint32_t y, uint32_t z,
+        uint32_t width, uint32_t height, uint32_t depth, size_t dataSize, const void* pData) {
+    if (!bytesPerBlock) throw std::logic_error("Texture isn't compressed.");
+    OGU_COUNT_CALL(UPLOAD);
+    OGU_COUNT_UPLOAD(dataSize);
+    if (getFeatures().directStateAccess) {
+        switch (dimension) {
+        case DIMENSION_1D:
+            break;
+        case DIMENSION_2D:
+            glCompressedTextureSubImage2D(handle, level, x, y, width, height, internalFormat, (GLsizei) dataSize, pData);
+            break;
+        case DIMENSION_3D:
+        case DIMENSION_2D_ARRAY:
+            glCompressedTextureSubImage3D(handle, level, x, y, z, width, height, depth, internalFormat, (GLsizei) dataSize, pData);
+            break;
+        }
+        return;
+    }
+
+    state_cache::current().bindTexture(target, handle);
+
+    switch (dimension) {
+    case DIMENSION_1D:
+        break;
+    case DIMENSION_2D:
+        glCompressedTexSubImage2D(target, level, x, y, width, height, internalFormat, (GLsizei) dataSize, pData);
+        break;
+    case DIMENSION_3D:
+    case DIMENSION_2D_ARRAY:
+        glCompressedTexSubImage3D(target, level, x, y, z, width, height, depth, internalFormat, (GLsizei) dataSize, pData);
+        break;
+    }
+}
+
 };
\ No newline at end of file
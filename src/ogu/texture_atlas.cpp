@@ -0,0 +1,182 @@
+#include "texture_atlas.h"
+
+#include "init.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace ogu {
+
+texture_atlas::texture_atlas(uint32_t width, uint32_t height, Texture::Format format,
+        uint32_t initialLayers, uint32_t maxLayers, uint32_t padding) :
+        _width(width), _height(height), _format(format),
+        _initialLayers(std::max(initialLayers, 1u)), _maxLayers(std::max(maxLayers, std::max(initialLayers, 1u))),
+        _padding(padding) {
+    // without image copies the array can't grow later
+    uint32_t layers = getFeatures().copyImage ? _initialLayers : _maxLayers;
+    _texture = createTexture(layers);
+    _packers.assign(layers, skyline_packer(width, height));
+}
+
+std::unique_ptr<Texture> texture_atlas::createTexture(uint32_t layers) const {
+    auto texture = std::make_unique<Texture>(Texture::DIMENSION_2D_ARRAY, _format);
+    texture->allocateStorage(1, _width, _height, layers);
+    return texture;
+}
+
+void texture_atlas::setRegion(region& r, uint32_t layer, const skyline_packer::rect& slot) const {
+    r.layer = layer;
+    r.x = slot.x + _padding;
+    r.y = slot.y + _padding;
+    r.width = slot.width - 2 * _padding;
+    r.height = slot.height - 2 * _padding;
+    r.u0 = (float) r.x / (float) _width;
+    r.v0 = (float) r.y / (float) _height;
+    r.u1 = (float) (r.x + r.width) / (float) _width;
+    r.v1 = (float) (r.y + r.height) / (float) _height;
+}
+
+void texture_atlas::grow(uint32_t layers) {
+    auto texture = createTexture(layers);
+    uint32_t oldLayers = (uint32_t) _packers.size();
+    glCopyImageSubData(_texture->getHandle(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+        texture->getHandle(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, _width, _height, oldLayers);
+    _texture = std::move(texture);
+    _packers.resize(layers, skyline_packer(_width, _height));
+}
+
+bool texture_atlas::add(uint32_t width, uint32_t height, const void* pPixels, image_id& out) {
+    uint32_t slotWidth = width + 2 * _padding, slotHeight = height + 2 * _padding;
+    if (width == 0 || height == 0 || slotWidth > _width || slotHeight > _height) return false;
+
+    skyline_packer::rect slot;
+    uint32_t layer = 0;
+    while (layer < _packers.size() && !_packers[layer].insert(slotWidth, slotHeight, slot)) {
+        ++layer;
+    }
+    if (layer == _packers.size()) {
+        if (layer >= _maxLayers || !getFeatures().copyImage) return false;
+        grow(std::min(_maxLayers, layer * 2));
+        _packers[layer].insert(slotWidth, slotHeight, slot);
+    }
+
+    if (!_freeIds.empty()) {
+        out = _freeIds.back();
+        _freeIds.pop_back();
+    } else {
+        out = (image_id) _images.size();
+        _images.emplace_back();
+    }
+    image& img = _images[out];
+    setRegion(img.r, layer, slot);
+    img.live = true;
+    _liveArea += (size_t) width * height;
+
+    if (pPixels) write(out, pPixels);
+    return true;
+}
+
+void texture_atlas::write(image_id id, const void* pPixels) {
+    const region& r = getRegion(id);
+    if (_padding == 0) {
+        _texture->writeSubPixels(0, r.x, r.y, r.layer, r.width, r.height, 1, pPixels);
+        return;
+    }
+
+    // clamp-to-edge into the padding, so linear filtering at the image's border only sees its own texels
+    const size_t texelSize = _format.components * _format.bitsPerComponent / 8;
+    const size_t rowSize = r.width * texelSize;
+    const uint32_t paddedWidth = r.width + 2 * _padding, paddedHeight = r.height + 2 * _padding;
+    const size_t paddedRowSize = paddedWidth * texelSize;
+    _padded.resize(paddedRowSize * paddedHeight);
+    for (uint32_t y = 0; y < paddedHeight; ++y) {
+        uint32_t sourceY = std::min(std::max(y, _padding) - _padding, r.height - 1);
+        const uint8_t* pSrc = (const uint8_t*) pPixels + sourceY * rowSize;
+        uint8_t* pDst = _padded.data() + y * paddedRowSize;
+        for (uint32_t x = 0; x < _padding; ++x) {
+            std::memcpy(pDst + x * texelSize, pSrc, texelSize);
+            std::memcpy(pDst + (_padding + r.width + x) * texelSize, pSrc + rowSize - texelSize, texelSize);
+        }
+        std::memcpy(pDst + _padding * texelSize, pSrc, rowSize);
+    }
+    _texture->writeSubPixels(0, r.x - _padding, r.y - _padding, r.layer, paddedWidth, paddedHeight, 1,
+        _padded.data());
+}
+
+void texture_atlas::remove(image_id id) {
+    image& img = _images.at(id);
+    if (!img.live) return;
+    img.live = false;
+    _liveArea -= (size_t) img.r.width * img.r.height;
+    _freeIds.push_back(id);
+}
+
+const texture_atlas::region& texture_atlas::getRegion(image_id id) const {
+    const image& img = _images.at(id);
+    if (!img.live) throw std::invalid_argument("Atlas image has been removed.");
+    return img.r;
+}
+
+bool texture_atlas::repack() {
+    if (!getFeatures().copyImage) throw std::logic_error("Repacking a texture_atlas needs ARB_copy_image.");
+
+    std::vector<image_id> order;
+    for (image_id id = 0; id < _images.size(); ++id) {
+        if (_images[id].live) order.push_back(id);
+    }
+    // tallest first packs a skyline tightest
+    std::sort(order.begin(), order.end(), [this] (image_id a, image_id b) {
+        const region& ra = _images[a].r;
+        const region& rb = _images[b].r;
+        return ra.height != rb.height ? ra.height > rb.height : ra.width > rb.width;
+    });
+
+    std::vector<skyline_packer> packers;
+    std::vector<std::pair<uint32_t, skyline_packer::rect>> placements(_images.size());
+    for (image_id id : order) {
+        const region& r = _images[id].r;
+        uint32_t slotWidth = r.width + 2 * _padding, slotHeight = r.height + 2 * _padding;
+        skyline_packer::rect slot;
+        uint32_t layer = 0;
+        while (layer < packers.size() && !packers[layer].insert(slotWidth, slotHeight, slot)) {
+            ++layer;
+        }
+        if (layer == packers.size()) {
+            if (layer >= _maxLayers) return false;
+            packers.emplace_back(_width, _height);
+            packers.back().insert(slotWidth, slotHeight, slot);
+        }
+        placements[id] = { layer, slot };
+    }
+    if (packers.size() < _initialLayers) packers.resize(_initialLayers, skyline_packer(_width, _height));
+
+    auto texture = createTexture((uint32_t) packers.size());
+    for (image_id id : order) {
+        region& r = _images[id].r;
+        region moved;
+        setRegion(moved, placements[id].first, placements[id].second);
+        // padding included
+        glCopyImageSubData(_texture->getHandle(), GL_TEXTURE_2D_ARRAY, 0, r.x - _padding, r.y - _padding, r.layer,
+            texture->getHandle(), GL_TEXTURE_2D_ARRAY, 0, moved.x - _padding, moved.y - _padding, moved.layer,
+            r.width + 2 * _padding, r.height + 2 * _padding, 1);
+        r = moved;
+    }
+    _texture = std::move(texture);
+    _packers = std::move(packers);
+    return true;
+}
+
+texture_atlas::stats texture_atlas::getStats() const {
+    stats s {};
+    s.layers = (uint32_t) _packers.size();
+    s.images = _images.size() - _freeIds.size();
+    s.liveArea = _liveArea;
+    for (const skyline_packer& p : _packers) {
+        s.packedArea += p.usedArea();
+    }
+    return s;
+}
+
+}  // namespace ogu
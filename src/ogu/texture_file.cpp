@@ -0,0 +1,389 @@
+#include "texture_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace ogu {
+
+static const uint8_t KTX2_IDENTIFIER[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+static constexpr uint32_t DDS_MAGIC = 0x20534444;  // "DDS "
+
+static constexpr uint32_t fourCC(char a, char b, char c, char d) {
+    return (uint32_t) (uint8_t) a | ((uint32_t) (uint8_t) b << 8) | ((uint32_t) (uint8_t) c << 16) | ((uint32_t) (uint8_t) d << 24);
+}
+
+static constexpr Texture::Format RGBA8 = { 4, 8, false, true, false, false };
+static constexpr Texture::Format BGRA8 = { 4, 8, false, true, false, true };
+static constexpr Texture::Format R8 = { 1, 8, false, true, false, false };
+static constexpr Texture::Format RG8 = { 2, 8, false, true, false, false };
+static constexpr Texture::Format RGBA16F = { 4, 16, true, false, true, false };
+static constexpr Texture::Format RGBA32F = { 4, 32, true, false, true, false };
+
+texture_file::texture_file(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Failed to open " + path);
+    _file = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        unmap();
+        throw std::runtime_error("Failed to read the size of " + path);
+    }
+    _size = (size_t) size.QuadPart;
+    _mapping = _size ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    _pData = _mapping ? static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Failed to open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to read the size of " + path);
+    }
+    _size = (size_t) st.st_size;
+    if (_size) {
+        void* p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            _pData = static_cast<const uint8_t*>(p);
+            // levels are read front to back by upload()
+            madvise(p, _size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+#endif
+    if (!_pData) {
+        unmap();
+        throw std::runtime_error("Failed to map " + path);
+    }
+
+    try {
+        if (_size >= sizeof(KTX2_IDENTIFIER) && std::memcmp(_pData, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0) {
+            parseKTX2();
+        } else if (_size >= 4 && std::memcmp(_pData, &DDS_MAGIC, 4) == 0) {
+            parseDDS();
+        } else {
+            throw std::runtime_error("Not a KTX2 or DDS file.");
+        }
+    } catch (const std::runtime_error& e) {
+        unmap();
+        throw std::runtime_error(path + ": " + e.what());
+    }
+}
+
+texture_file::~texture_file() {
+    unmap();
+}
+
+void texture_file::unmap() {
+#ifdef _WIN32
+    if (_pData) UnmapViewOfFile(_pData);
+    if (_mapping) CloseHandle(_mapping);
+    if (_file) CloseHandle(_file);
+    _mapping = nullptr;
+    _file = nullptr;
+#else
+    if (_pData) munmap(const_cast<uint8_t*>(_pData), _size);
+#endif
+    _pData = nullptr;
+}
+
+// Both containers are little-endian
+static uint32_t read32(const uint8_t* p, size_t size, size_t offset) {
+    if (offset + 4 > size) throw std::runtime_error("Truncated header.");
+    uint32_t v;
+    std::memcpy(&v, p + offset, 4);
+    return v;
+}
+
+static uint64_t read64(const uint8_t* p, size_t size, size_t offset) {
+    if (offset + 8 > size) throw std::runtime_error("Truncated header.");
+    uint64_t v;
+    std::memcpy(&v, p + offset, 8);
+    return v;
+}
+
+size_t texture_file::levelSize(uint32_t level) const {
+    const description& d = _description;
+    size_t w = std::max<size_t>(d.width >> level, 1);
+    size_t h = (d.dimension == Texture::DIMENSION_1D) ? 1 : std::max<size_t>(d.height >> level, 1);
+    size_t z = (d.dimension == Texture::DIMENSION_3D) ? std::max<size_t>(d.depth >> level, 1) : 1;
+    if (d.compressed) return ((w + 3) / 4) * ((h + 3) / 4) * z * Texture::getBlockSize(d.compressedFormat);
+    return w * h * z * (d.format.components * d.format.bitsPerComponent / 8);
+}
+
+static void checkLevels(const texture_file::description& d) {
+    uint32_t fullChain = Texture::fullMipChainLevels(d.width, d.height, d.dimension == Texture::DIMENSION_3D ? d.depth : 1);
+    if (d.levels > fullChain) {
+        throw std::runtime_error(std::to_string(d.levels) + " levels, more than the full mip chain of "
+            + std::to_string(fullChain) + ".");
+    }
+}
+
+// VkFormat values from the Vulkan spec
+static bool setVkFormat(texture_file::description& d, uint32_t vkFormat) {
+    auto compressed = [&] (Texture::CompressedFormat f, bool srgb) {
+        d.compressed = true;
+        d.compressedFormat = f;
+        d.srgb = srgb;
+        return true;
+    };
+    auto uncompressed = [&] (const Texture::Format& f) {
+        d.compressed = false;
+        d.format = f;
+        return true;
+    };
+    switch (vkFormat) {
+    case 9: return uncompressed(R8);  // VK_FORMAT_R8_UNORM
+    case 16: return uncompressed(RG8);  // VK_FORMAT_R8G8_UNORM
+    case 37: return uncompressed(RGBA8);  // VK_FORMAT_R8G8B8A8_UNORM
+    case 44: return uncompressed(BGRA8);  // VK_FORMAT_B8G8R8A8_UNORM
+    case 97: return uncompressed(RGBA16F);  // VK_FORMAT_R16G16B16A16_SFLOAT
+    case 109: return uncompressed(RGBA32F);  // VK_FORMAT_R32G32B32A32_SFLOAT
+    case 131: return compressed(Texture::BC1_RGB, false);
+    case 132: return compressed(Texture::BC1_RGB, true);
+    case 133: return compressed(Texture::BC1_RGBA, false);
+    case 134: return compressed(Texture::BC1_RGBA, true);
+    case 135: return compressed(Texture::BC2, false);
+    case 136: return compressed(Texture::BC2, true);
+    case 137: return compressed(Texture::BC3, false);
+    case 138: return compressed(Texture::BC3, true);
+    case 139: return compressed(Texture::BC4, false);
+    case 140: return compressed(Texture::BC4_SIGNED, false);
+    case 141: return compressed(Texture::BC5, false);
+    case 142: return compressed(Texture::BC5_SIGNED, false);
+    case 143: return compressed(Texture::BC6H_UFLOAT, false);
+    case 144: return compressed(Texture::BC6H_SFLOAT, false);
+    case 145: return compressed(Texture::BC7, false);
+    case 146: return compressed(Texture::BC7, true);
+    case 147: return compressed(Texture::ETC2_RGB8, false);
+    case 148: return compressed(Texture::ETC2_RGB8, true);
+    case 149: return compressed(Texture::ETC2_RGB8_A1, false);
+    case 150: return compressed(Texture::ETC2_RGB8_A1, true);
+    case 151: return compressed(Texture::ETC2_RGBA8, false);
+    case 152: return compressed(Texture::ETC2_RGBA8, true);
+    case 153: return compressed(Texture::EAC_R11, false);
+    case 154: return compressed(Texture::EAC_R11_SIGNED, false);
+    case 155: return compressed(Texture::EAC_RG11, false);
+    case 156: return compressed(Texture::EAC_RG11_SIGNED, false);
+    }
+    return false;
+}
+
+// DXGI_FORMAT values from dxgiformat.h
+static bool setDxgiFormat(texture_file::description& d, uint32_t dxgiFormat) {
+    auto compressed = [&] (Texture::CompressedFormat f, bool srgb) {
+        d.compressed = true;
+        d.compressedFormat = f;
+        d.srgb = srgb;
+        return true;
+    };
+    auto uncompressed = [&] (const Texture::Format& f) {
+        d.compressed = false;
+        d.format = f;
+        return true;
+    };
+    switch (dxgiFormat) {
+    case 2: return uncompressed(RGBA32F);  // DXGI_FORMAT_R32G32B32A32_FLOAT
+    case 10: return uncompressed(RGBA16F);  // DXGI_FORMAT_R16G16B16A16_FLOAT
+    case 28: return uncompressed(RGBA8);  // DXGI_FORMAT_R8G8B8A8_UNORM
+    case 49: return uncompressed(RG8);  // DXGI_FORMAT_R8G8_UNORM
+    case 61: return uncompressed(R8);  // DXGI_FORMAT_R8_UNORM
+    case 87: return uncompressed(BGRA8);  // DXGI_FORMAT_B8G8R8A8_UNORM
+    case 71: return compressed(Texture::BC1_RGBA, false);
+    case 72: return compressed(Texture::BC1_RGBA, true);
+    case 74: return compressed(Texture::BC2, false);
+    case 75: return compressed(Texture::BC2, true);
+    case 77: return compressed(Texture::BC3, false);
+    case 78: return compressed(Texture::BC3, true);
+    case 80: return compressed(Texture::BC4, false);
+    case 81: return compressed(Texture::BC4_SIGNED, false);
+    case 83: return compressed(Texture::BC5, false);
+    case 84: return compressed(Texture::BC5_SIGNED, false);
+    case 95: return compressed(Texture::BC6H_UFLOAT, false);
+    case 96: return compressed(Texture::BC6H_SFLOAT, false);
+    case 98: return compressed(Texture::BC7, false);
+    case 99: return compressed(Texture::BC7, true);
+    }
+    return false;
+}
+
+void texture_file::parseKTX2() {
+    const uint8_t* p = _pData;
+    description& d = _description;
+
+    uint32_t vkFormat = read32(p, _size, 12);
+    uint32_t width = read32(p, _size, 20);
+    uint32_t height = read32(p, _size, 24);
+    uint32_t depth = read32(p, _size, 28);
+    uint32_t layerCount = read32(p, _size, 32);
+    uint32_t faceCount = read32(p, _size, 36);
+    uint32_t levelCount = read32(p, _size, 40);
+    uint32_t supercompression = read32(p, _size, 44);
+
+    if (faceCount != 1) throw std::runtime_error("Cube maps aren't supported.");
+    if (supercompression != 0) throw std::runtime_error("Supercompressed KTX2 isn't supported.");
+    if (!setVkFormat(d, vkFormat)) throw std::runtime_error("Unsupported VkFormat " + std::to_string(vkFormat) + ".");
+    if (width == 0) throw std::runtime_error("Zero width.");
+
+    d.width = width;
+    d.height = std::max(height, 1u);
+    if (depth > 0) {
+        if (layerCount > 1) throw std::runtime_error("Arrays of 3D textures aren't supported.");
+        d.dimension = Texture::DIMENSION_3D;
+        d.depth = depth;
+    } else if (layerCount > 0) {
+        d.dimension = Texture::DIMENSION_2D_ARRAY;
+        d.depth = layerCount;
+    } else {
+        d.dimension = (height == 0) ? Texture::DIMENSION_1D : Texture::DIMENSION_2D;
+        d.depth = 1;
+    }
+    if (d.compressed && d.dimension == Texture::DIMENSION_1D) throw std::runtime_error("Compressed 1D textures aren't supported.");
+    // 0 asks for mipmaps to be generated at load, only level 0 is stored then
+    d.levels = std::max(levelCount, 1u);
+    checkLevels(d);
+
+    const uint32_t layers = std::max(layerCount, 1u);
+    for (uint32_t level = 0; level < d.levels; ++level) {
+        size_t entry = 80 + (size_t) level * 24;
+        uint64_t offset = read64(p, _size, entry);
+        uint64_t length = read64(p, _size, entry + 8);
+        if (offset > _size || length > _size - offset) throw std::runtime_error("Level data out of bounds.");
+        if (length < levelSize(level) * layers) throw std::runtime_error("Level data too small for its size.");
+        _images.push_back({ p + offset, (size_t) length, level, 0, layers });
+    }
+}
+
+void texture_file::parseDDS() {
+    const uint8_t* p = _pData;
+    description& d = _description;
+
+    constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    constexpr uint32_t DDPF_FOURCC = 0x4;
+    constexpr uint32_t DDPF_RGB = 0x40;
+    constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+    constexpr uint32_t DDSCAPS2_VOLUME = 0x200000;
+
+    if (read32(p, _size, 4) != 124) throw std::runtime_error("Bad DDS header size.");
+    uint32_t flags = read32(p, _size, 8);
+    uint32_t height = read32(p, _size, 12);
+    uint32_t width = read32(p, _size, 16);
+    uint32_t depth = read32(p, _size, 24);
+    uint32_t mipCount = read32(p, _size, 28);
+    uint32_t pfFlags = read32(p, _size, 80);
+    uint32_t pfFourCC = read32(p, _size, 84);
+    uint32_t pfBits = read32(p, _size, 88);
+    uint32_t pfRMask = read32(p, _size, 92);
+    uint32_t caps2 = read32(p, _size, 112);
+
+    size_t offset = 128;
+    uint32_t layers = 1;
+    bool volume = (caps2 & DDSCAPS2_VOLUME) != 0;
+    if (caps2 & DDSCAPS2_CUBEMAP) throw std::runtime_error("Cube maps aren't supported.");
+
+    bool known = false;
+    if ((pfFlags & DDPF_FOURCC) && pfFourCC == fourCC('D', 'X', '1', '0')) {
+        uint32_t dxgiFormat = read32(p, _size, 128);
+        uint32_t resourceDimension = read32(p, _size, 132);
+        uint32_t miscFlag = read32(p, _size, 136);
+        layers = std::max(read32(p, _size, 140), 1u);
+        offset += 20;
+        if (miscFlag & 0x4) throw std::runtime_error("Cube maps aren't supported.");
+        volume = (resourceDimension == 4);  // D3D10_RESOURCE_DIMENSION_TEXTURE3D
+        known = setDxgiFormat(d, dxgiFormat);
+        if (!known) throw std::runtime_error("Unsupported DXGI format " + std::to_string(dxgiFormat) + ".");
+    } else if (pfFlags & DDPF_FOURCC) {
+        switch (pfFourCC) {
+        case fourCC('D', 'X', 'T', '1'): d.compressedFormat = Texture::BC1_RGBA; known = true; break;
+        case fourCC('D', 'X', 'T', '2'):
+        case fourCC('D', 'X', 'T', '3'): d.compressedFormat = Texture::BC2; known = true; break;
+        case fourCC('D', 'X', 'T', '4'):
+        case fourCC('D', 'X', 'T', '5'): d.compressedFormat = Texture::BC3; known = true; break;
+        case fourCC('A', 'T', 'I', '1'):
+        case fourCC('B', 'C', '4', 'U'): d.compressedFormat = Texture::BC4; known = true; break;
+        case fourCC('B', 'C', '4', 'S'): d.compressedFormat = Texture::BC4_SIGNED; known = true; break;
+        case fourCC('A', 'T', 'I', '2'):
+        case fourCC('B', 'C', '5', 'U'): d.compressedFormat = Texture::BC5; known = true; break;
+        case fourCC('B', 'C', '5', 'S'): d.compressedFormat = Texture::BC5_SIGNED; known = true; break;
+        }
+        d.compressed = true;
+        d.srgb = false;
+    } else if ((pfFlags & DDPF_RGB) && pfBits == 32) {
+        // the red mask tells RGBA from BGRA
+        if (pfRMask == 0x000000ff) {
+            d.format = RGBA8;
+            known = true;
+        } else if (pfRMask == 0x00ff0000) {
+            d.format = BGRA8;
+            known = true;
+        }
+        d.compressed = false;
+    }
+    if (!known) throw std::runtime_error("Unsupported DDS pixel format.");
+    if (width == 0 || height == 0) throw std::runtime_error("Zero size.");
+
+    d.width = width;
+    d.height = height;
+    if (volume) {
+        d.dimension = Texture::DIMENSION_3D;
+        d.depth = std::max(depth, 1u);
+    } else if (layers > 1) {
+        d.dimension = Texture::DIMENSION_2D_ARRAY;
+        d.depth = layers;
+    } else {
+        d.dimension = Texture::DIMENSION_2D;
+        d.depth = 1;
+    }
+    d.levels = (flags & DDSD_MIPMAPCOUNT) ? std::max(mipCount, 1u) : 1;
+    checkLevels(d);
+
+    // every level of layer 0, then every level of layer 1, ...
+    for (uint32_t layer = 0; layer < layers; ++layer) {
+        for (uint32_t level = 0; level < d.levels; ++level) {
+            size_t size = levelSize(level);
+            if (offset > _size || size > _size - offset) throw std::runtime_error("Level data out of bounds.");
+            _images.push_back({ p + offset, size, level, layer, 1 });
+            offset += size;
+        }
+    }
+}
+
+std::unique_ptr<Texture> texture_file::createTexture() const {
+    const description& d = _description;
+    auto texture = d.compressed
+        ? std::make_unique<Texture>(d.dimension, d.compressedFormat, d.srgb)
+        : std::make_unique<Texture>(d.dimension, d.format);
+    texture->allocateStorage(d.levels, d.width, d.height, d.depth);
+    upload(*texture);
+    return texture;
+}
+
+void texture_file::upload(Texture& texture) const {
+    const description& d = _description;
+    for (const image& img : _images) {
+        uint32_t w = std::max(d.width >> img.level, 1u);
+        uint32_t h = std::max(d.height >> img.level, 1u);
+        uint32_t z = (d.dimension == Texture::DIMENSION_3D) ? std::max(d.depth >> img.level, 1u) : img.layers;
+        if (d.compressed) {
+            texture.writeCompressedSubPixels(img.level, 0, 0, img.layer, w, h, z, levelSize(img.level) * img.layers, img.pData);
+        } else {
+            texture.writeSubPixels(img.level, 0, 0, img.layer, w, h, z, img.pData);
+        }
+    }
+}
+
+}  // namespace ogu
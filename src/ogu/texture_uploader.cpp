@@ -0,0 +1,156 @@
+#include "texture_uploader.h"
+
+#include <stdexcept>
+
+
+namespace ogu {
+
+static constexpr size_t STAGING_ALIGNMENT = 16;
+
+texture_uploader::texture_uploader(size_t stagingSize) :
+        _buffer(stagingSize, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT) {
+    _pMapped = static_cast<uint8_t*>(_buffer.map(0, stagingSize,
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+    assert(_pMapped);
+}
+
+texture_uploader::~texture_uploader() {
+    for (auto& f : _fences) {
+        glDeleteSync(f.first);
+    }
+    _buffer.unmap();
+}
+
+bool texture_uploader::stage(size_t size, staging& out) {
+    size_t alignedSize = (size + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+    const size_t capacity = _buffer.size();
+    if (alignedSize > capacity) throw std::length_error("Upload is larger than the staging buffer.");
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_used == 0) {
+        _head = _tail = 0;
+    }
+
+    size_t offset, consumed;
+    if (_head >= _tail && _used < capacity) {
+        if (capacity - _head >= alignedSize) {
+            offset = _head;
+            consumed = alignedSize;
+        } else if (_tail >= alignedSize) {
+            // skip the end of the ring and wrap around
+            offset = 0;
+            consumed = capacity - _head + alignedSize;
+        } else {
+            ++_stagingFailures;
+            return false;
+        }
+    } else if (_head < _tail && _tail - _head >= alignedSize) {
+        offset = _head;
+        consumed = alignedSize;
+    } else {
+        ++_stagingFailures;
+        return false;
+    }
+
+    _head = (offset + alignedSize) % capacity;
+    _used += consumed;
+
+    upload u {};
+    u.offset = offset;
+    u.size = size;
+    u.consumed = consumed;
+    _uploads.push_back(u);
+
+    out.pData = _pMapped + offset;
+    out.size = size;
+    out.id = _frontId + _uploads.size() - 1;
+    return true;
+}
+
+void texture_uploader::submit(const staging& s, Texture& texture, uint32_t level, uint32_t x, uint32_t y, uint32_t z,
+        uint32_t width, uint32_t height, uint32_t depth) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    upload& u = _uploads.at(s.id - _frontId);
+    u.pTexture = &texture;
+    u.level = level;
+    u.x = x;
+    u.y = y;
+    u.z = z;
+    u.width = width;
+    u.height = height;
+    u.depth = depth;
+    u.submitted = true;
+}
+
+void texture_uploader::retire() {
+    while (!_fences.empty()) {
+        GLenum result = glClientWaitSync(_fences.front().first, 0, 0);
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) break;
+        _completedSerial = _fences.front().second;
+        glDeleteSync(_fences.front().first);
+        _fences.pop_front();
+    }
+
+    // Ring memory is released in staging order
+    while (!_uploads.empty() && _uploads.front().flushSerial != 0 && _uploads.front().flushSerial <= _completedSerial) {
+        const upload& u = _uploads.front();
+        size_t alignedSize = (u.size + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+        _tail = (u.offset + alignedSize) % _buffer.size();
+        _used -= u.consumed;
+        _uploads.pop_front();
+        ++_frontId;
+    }
+}
+
+size_t texture_uploader::flush(size_t byteBudget) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    retire();
+
+    size_t bytes = 0;
+    uint64_t serial = _flushSerial + 1;
+    bool issued = false;
+    for (auto& u : _uploads) {
+        if (!u.submitted || u.flushSerial != 0) continue;
+        if (issued && bytes + u.size > byteBudget) break;
+
+        if (!issued) {
+            _buffer.bind(GL_PIXEL_UNPACK_BUFFER);
+            issued = true;
+        }
+        // with a pixel unpack buffer bound, the data pointer is an offset into it
+        u.pTexture->writeSubPixels(u.level, u.x, u.y, u.z, u.width, u.height, u.depth,
+            reinterpret_cast<const void*>(u.offset));
+        u.flushSerial = serial;
+        bytes += u.size;
+        ++_uploadsIssued;
+    }
+
+    if (issued) {
+        // leaving it bound would make client-memory uploads elsewhere read from the ring instead
+        state_cache::current().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        _fences.emplace_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), serial);
+        _flushSerial = serial;
+        _bytesIssued += bytes;
+    }
+
+    return bytes;
+}
+
+texture_uploader::stats texture_uploader::getStats() {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    stats s {};
+    s.uploadsIssued = _uploadsIssued;
+    s.bytesIssued = _bytesIssued;
+    s.stagingFailures = _stagingFailures;
+    s.bytesInUse = _used;
+    for (const auto& u : _uploads) {
+        if (u.flushSerial == 0) ++s.uploadsPending;
+    }
+    return s;
+}
+
+}  // namespace ogu
@@ -1,10 +1,92 @@
 #include "vertex_array.h"
 
+#include "init.h"
+
+#include <algorithm>
+
 
 namespace ogu
 {
 
+GLsizei vertexAttribSize(const vertex_attrib_description& a) {
+    switch (a.type) {
+    case GL_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+        return 4;
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        break;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+        return 2 * a.size;
+    case GL_DOUBLE:
+        return 8 * a.size;
+    default:
+        return 4 * a.size;
+    }
+    // GL_BGRA as the size means four components
+    return a.size == GL_BGRA ? 4 : a.size;
+}
+
+static GLsizeiptr maxRelativeOffset() {
+    static GLint maxOffset = -1;
+    if (maxOffset < 0) {
+        glGetIntegerv(GL_MAX_VERTEX_ATTRIB_RELATIVE_OFFSET, &maxOffset);
+        maxOffset = std::max(maxOffset, 0);
+    }
+    return maxOffset;
+}
+
+void appendBindingPoints(uint32_t source, const std::vector<vertex_attrib_description>& attribs, uint32_t stride,
+        bool instanced, std::vector<vertex_binding_point>& points) {
+    bool split = (stride == 0);
+    for (const auto& a : attribs) {
+        split = split || a.offset > maxRelativeOffset();
+    }
+    if (!split) {
+        points.push_back({ source, 0, (GLsizei) stride, instanced, attribs });
+        return;
+    }
+    for (const auto& a : attribs) {
+        vertex_attrib_description relative = a;
+        relative.offset = 0;
+        points.push_back({ source, (GLintptr) a.offset, stride ? (GLsizei) stride : vertexAttribSize(a), instanced,
+            { relative } });
+    }
+}
+
+static void createDirect(GLuint vao, const std::vector<vertex_buffer_binding>& bindings) {
+    const auto points = vertexBindingPoints(bindings);
+    for (GLuint i = 0; i < points.size(); ++i) {
+        const auto& p = points[i];
+        const auto& b = bindings[p.source];
+        glVertexArrayVertexBuffer(vao, i, b.buf.handle(), b.baseOffset + p.offset, p.stride);
+        if (p.instanced)
+            glVertexArrayBindingDivisor(vao, i, 1);
+
+        for (const auto& a : p.attribs) {
+            if (a.integer) {
+                glVertexArrayAttribIFormat(vao, a.location, a.size, a.type, a.offset);
+            } else {
+                glVertexArrayAttribFormat(vao, a.location, a.size, a.type,
+                    a.normalized? GL_TRUE : GL_FALSE, a.offset);
+            }
+            glVertexArrayAttribBinding(vao, a.location, i);
+            glEnableVertexArrayAttrib(vao, a.location);
+        }
+    }
+}
+
 vertex_array::vertex_array(const std::vector<vertex_buffer_binding>& bindings) {
+    OGU_OBJECT_CREATED(VERTEX_ARRAY, 0);
+    if (getFeatures().directStateAccess) {
+        glCreateVertexArrays(1, &_handle);
+        createDirect(_handle, bindings);
+        return;
+    }
+
     glGenVertexArrays(1, &_handle);
 
     bind();
@@ -14,10 +96,10 @@ vertex_array::vertex_array(const std::vector<vertex_buffer_binding>& bindings) {
 
         for (const auto& a : b.attribs) {
             if (a.integer) {
-                glVertexAttribIPointer(a.location, a.size, a.type, b.stride, (void*) a.offset);
+                glVertexAttribIPointer(a.location, a.size, a.type, b.stride, (void*) (b.baseOffset + a.offset));
             } else {
                 glVertexAttribPointer(a.location, a.size, a.type,
-                    a.normalized? GL_TRUE : GL_FALSE, b.stride, (void*) a.offset);
+                    a.normalized? GL_TRUE : GL_FALSE, b.stride, (void*) (b.baseOffset + a.offset));
             }
             if (b.instanced)
                 glVertexAttribDivisor(a.location, 1);
@@ -31,6 +113,10 @@ vertex_array::vertex_array(vertex_array&& va) : _handle(va._handle) {
 }
 
 vertex_array::~vertex_array() {
+    if (_handle) {
+        state_cache::current().forgetVertexArray(_handle);
+        OGU_OBJECT_DESTROYED(VERTEX_ARRAY, 0);
+    }
     glDeleteVertexArrays(1, &_handle);
 }
 
@@ -0,0 +1,197 @@
+#include "vertex_layout.h"
+
+#include <utility>
+
+#include "hash.h"
+#include "init.h"
+#include "instrumentation.h"
+
+
+namespace ogu {
+
+static bool operator==(const vertex_attrib_description& a, const vertex_attrib_description& b) {
+    return a.location == b.location && a.size == b.size && a.type == b.type && a.offset == b.offset
+        && a.integer == b.integer && a.normalized == b.normalized;
+}
+
+static uint64_t hashBindings(const std::vector<vertex_layout::binding>& bindings) {
+    // field by field, so struct padding doesn't end up in the hash
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (const auto& b : bindings) {
+        hash = fnv1a_value(b.stride, hash);
+        hash = fnv1a_value(b.instanced, hash);
+        for (const auto& a : b.attribs) {
+            hash = fnv1a_value(a.location, hash);
+            hash = fnv1a_value(a.size, hash);
+            hash = fnv1a_value(a.type, hash);
+            hash = fnv1a_value(a.offset, hash);
+            hash = fnv1a_value(a.integer, hash);
+            hash = fnv1a_value(a.normalized, hash);
+        }
+    }
+    return hash;
+}
+
+vertex_layout::vertex_layout(std::vector<binding> bindings) :
+        _bindings(std::move(bindings)),
+        _hash(hashBindings(_bindings)) {
+}
+
+vertex_layout::vertex_layout(const std::vector<vertex_buffer_binding>& bindings) {
+    for (const auto& b : bindings) {
+        _bindings.push_back({ b.attribs, b.stride, b.instanced });
+    }
+    _hash = hashBindings(_bindings);
+}
+
+bool vertex_layout::operator==(const vertex_layout& other) const {
+    if (_hash != other._hash || _bindings.size() != other._bindings.size()) return false;
+    for (size_t i = 0; i < _bindings.size(); ++i) {
+        const auto& a = _bindings[i];
+        const auto& b = other._bindings[i];
+        if (a.stride != b.stride || a.instanced != b.instanced || a.attribs.size() != b.attribs.size()) return false;
+        for (size_t j = 0; j < a.attribs.size(); ++j) {
+            if (!(a.attribs[j] == b.attribs[j])) return false;
+        }
+    }
+    return true;
+}
+
+vertex_array_cache::~vertex_array_cache() {
+    for (auto& v : _vaos) {
+        state_cache::current().forgetVertexArray(v.second.handle);
+        OGU_OBJECT_DESTROYED(VERTEX_ARRAY, 0);
+        glDeleteVertexArrays(1, &v.second.handle);
+    }
+}
+
+void vertex_array_cache::createVertexArray(const vertex_layout& layout, vao_entry& entry) {
+    const auto& bindings = layout.bindings();
+    entry.vertexBuffers.assign(bindings.size(), { 0, 0 });
+    entry.indexBuffer = 0;
+    OGU_OBJECT_CREATED(VERTEX_ARRAY, 0);
+
+    if (getFeatures().vertexAttribBinding) {
+        entry.points = vertexBindingPoints(bindings);
+    }
+
+    if (getFeatures().directStateAccess && getFeatures().vertexAttribBinding) {
+        glCreateVertexArrays(1, &entry.handle);
+        for (GLuint i = 0; i < entry.points.size(); ++i) {
+            const auto& p = entry.points[i];
+            if (p.instanced)
+                glVertexArrayBindingDivisor(entry.handle, i, 1);
+            for (const auto& a : p.attribs) {
+                if (a.integer) {
+                    glVertexArrayAttribIFormat(entry.handle, a.location, a.size, a.type, a.offset);
+                } else {
+                    glVertexArrayAttribFormat(entry.handle, a.location, a.size, a.type,
+                        a.normalized? GL_TRUE : GL_FALSE, a.offset);
+                }
+                glVertexArrayAttribBinding(entry.handle, a.location, i);
+                glEnableVertexArrayAttrib(entry.handle, a.location);
+            }
+        }
+        return;
+    }
+
+    glGenVertexArrays(1, &entry.handle);
+    state_cache::current().bindVertexArray(entry.handle);
+
+    if (getFeatures().vertexAttribBinding) {
+        for (GLuint i = 0; i < entry.points.size(); ++i) {
+            const auto& p = entry.points[i];
+            if (p.instanced)
+                glVertexBindingDivisor(i, 1);
+            for (const auto& a : p.attribs) {
+                if (a.integer) {
+                    glVertexAttribIFormat(a.location, a.size, a.type, a.offset);
+                } else {
+                    glVertexAttribFormat(a.location, a.size, a.type, a.normalized? GL_TRUE : GL_FALSE, a.offset);
+                }
+                glVertexAttribBinding(a.location, i);
+                glEnableVertexAttribArray(a.location);
+            }
+        }
+        return;
+    }
+
+    for (const auto& b : bindings) {
+        for (const auto& a : b.attribs) {
+            if (b.instanced) {
+                // pointers are specified when buffers are bound
+                glVertexAttribDivisor(a.location, 1);
+            }
+            glEnableVertexAttribArray(a.location);
+        }
+    }
+}
+
+const vertex_layout& vertex_array_cache::intern(const vertex_layout& layout) {
+    auto it = _vaos.find(layout);
+    if (it == _vaos.end()) {
+        it = _vaos.emplace(layout, vao_entry {}).first;
+        createVertexArray(it->first, it->second);
+    }
+    return it->first;
+}
+
+void vertex_array_cache::bind(const vertex_layout& layout, const buffer_range* pVertexBuffers, const buffer* pIndexBuffer) {
+    auto it = _vaos.find(layout);
+    if (it == _vaos.end() || &it->first != &layout) {
+        intern(layout);
+        it = _vaos.find(layout);
+    }
+    vao_entry& entry = it->second;
+
+    state_cache& cache = state_cache::current();
+    uint64_t issuedBefore = cache.getCounters().issued;
+    cache.bindVertexArray(entry.handle);
+    if (cache.getCounters().issued != issuedBefore) ++_frame.vaoSwitches;
+
+    const auto& bindings = layout.bindings();
+    for (GLuint i = 0, point = 0; i < bindings.size(); ++i) {
+        const buffer_range& r = pVertexBuffers[i];
+        bound_buffer& bound = entry.vertexBuffers[i];
+        const bool elided = bound.serial == r.buf->serial() && bound.offset == r.offset;
+        if (elided) {
+            ++_frame.elidedBufferBinds;
+        } else {
+            bound = { r.buf->serial(), r.offset };
+            ++_frame.bufferBinds;
+        }
+
+        if (getFeatures().vertexAttribBinding) {
+            // the binding points of a layout binding are consecutive
+            for (; point < entry.points.size() && entry.points[point].source == i; ++point) {
+                const auto& p = entry.points[point];
+                if (!elided) glBindVertexBuffer(point, r.buf->handle(), r.offset + p.offset, p.stride);
+            }
+            continue;
+        }
+        if (elided) continue;
+        const auto& b = bindings[i];
+        r.buf->bind(GL_ARRAY_BUFFER);
+        for (const auto& a : b.attribs) {
+            if (a.integer) {
+                glVertexAttribIPointer(a.location, a.size, a.type, b.stride, (void*) (r.offset + a.offset));
+            } else {
+                glVertexAttribPointer(a.location, a.size, a.type,
+                    a.normalized? GL_TRUE : GL_FALSE, b.stride, (void*) (r.offset + a.offset));
+            }
+        }
+    }
+
+    if (pIndexBuffer && entry.indexBuffer != pIndexBuffer->serial()) {
+        pIndexBuffer->bind(GL_ELEMENT_ARRAY_BUFFER);
+        entry.indexBuffer = pIndexBuffer->serial();
+    }
+}
+
+void vertex_array_cache::endFrame() {
+    _frame.layouts = _vaos.size();
+    _lastFrame = _frame;
+    _frame = {};
+}
+
+}  // namespace ogu
@@ -0,0 +1,114 @@
+#include "test_support.h"
+
+#include <ogu/draw_batch.h>
+
+#ifdef OGU_GL_DISPATCH
+#include <ogu/mock_gl.h>
+#endif
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace ogu;
+
+
+// CPU cost of draw_batch per frame: queueing draws, build() (sort and group) and the whole submit(),
+// for draws over a handful of programs, layouts and meshes queued in random order.
+
+static constexpr int FRAMES = 50;
+static constexpr uint32_t DRAWS = 10000;
+static constexpr uint32_t PROGRAMS = 8;
+static constexpr uint32_t MESHES = 64;
+static constexpr uint32_t INSTANCE_DATA_SIZE = 64;
+
+static const char* VERTEX_SOURCE =
+    "#version 450 core\n"
+    "layout(location = 0) in vec3 position;\n"
+    "void main() { gl_Position = vec4(position, 1.0); }\n";
+
+static const char* FRAGMENT_SOURCE =
+    "#version 450 core\n"
+    "out vec4 fragColor;\n"
+    "void main() { fragColor = vec4(1.0); }\n";
+
+static void run(const char* backend) {
+    std::vector<std::unique_ptr<shader_program>> programs;
+    for (uint32_t i = 0; i < PROGRAMS; ++i) {
+        programs.push_back(std::make_unique<shader_program>(std::initializer_list<shader> {
+            shader({ VERTEX_SOURCE }, shader::type::VERTEX), shader({ FRAGMENT_SOURCE }, shader::type::FRAGMENT) }));
+    }
+    vertex_array_cache cache;
+    const vertex_layout* layouts[] = {
+        &cache.intern(vertex_layout({ { { { 0, 3, GL_FLOAT, 0 } }, 12, false } })),
+        &cache.intern(vertex_layout({ { { { 0, 3, GL_FLOAT, 0 }, { 1, 2, GL_FLOAT, 12 } }, 20, false } }))
+    };
+    buffer vertices(MESHES * 4096), indices(MESHES * 1024);
+    std::vector<buffer_range> vertexRanges;
+    for (uint32_t i = 0; i < MESHES; ++i) {
+        vertexRanges.push_back({ &vertices, (intptr_t) i * 4096, 4096 });
+    }
+
+    std::mt19937 random(1);
+    std::vector<draw_batch::draw> draws;
+    for (uint32_t i = 0; i < DRAWS; ++i) {
+        uint32_t mesh = random() % MESHES;
+        draws.push_back({ programs[random() % PROGRAMS].get(), layouts[mesh % 2], &vertexRanges[mesh], &indices,
+            GL_TRIANGLES, GL_UNSIGNED_SHORT, 36, mesh * 512, 0, 1, 0 });
+    }
+    std::vector<uint8_t> instanceData(INSTANCE_DATA_SIZE, 1);
+
+    const features& f = getFeatures();
+    uint32_t instanceDataSize = f.shaderStorageBuffer && f.shaderDrawParameters ? INSTANCE_DATA_SIZE : 0;
+    draw_batch batch(instanceDataSize);
+    stream_buffer stream((DRAWS * (instanceDataSize + sizeof(draw_elements_indirect_command)) + 4096), 3);
+    auto queue = [&] () {
+        for (const auto& d : draws) {
+            batch.add(d, instanceData.data());
+        }
+    };
+
+    double addMs = test::bestMs(FRAMES, [&] () {
+        queue();
+        batch.clear();
+    });
+    size_t batches = 0;
+    double buildMs = test::bestMs(FRAMES, [&] () {
+        queue();
+        batches = batch.build();
+        batch.clear();
+    }) - addMs;
+    double submitMs = test::bestMs(FRAMES, [&] () {
+        queue();
+        batch.submit(stream, cache);
+        stream.end_frame();
+    }) - addMs;
+
+    const auto& s = batch.lastStats();
+    std::printf("%s, %u draws, %u bytes of instance data, multi-draw indirect %s\n", backend, DRAWS,
+        instanceDataSize, f.multiDrawIndirect ? "on" : "off");
+    std::printf("  add:    %7.3f ms/frame (%5.1f ns/draw)\n", addMs, addMs * 1e6 / DRAWS);
+    std::printf("  build:  %7.3f ms/frame (%5.1f ns/draw), %zu batches\n", buildMs, buildMs * 1e6 / DRAWS, batches);
+    std::printf("  submit: %7.3f ms/frame (%5.1f ns/draw), %llu GL draw calls\n", submitMs, submitMs * 1e6 / DRAWS,
+        (unsigned long long) s.drawCalls);
+}
+
+int main() {
+    auto context = test::gl_context::create();
+    if (context) {
+        run((const char*) glGetString(GL_RENDERER));
+        glFinish();
+    }
+#ifdef OGU_GL_DISPATCH
+    for (bool multiDrawIndirect : { true, false }) {
+        // GL calls cost next to nothing here, what's left is draw_batch's own work
+        features f = getFeatures();
+        f.baseInstance = f.shaderStorageBuffer = f.shaderDrawParameters = true;
+        f.multiDrawIndirect = multiDrawIndirect;
+        mock_gl gl(f);
+        gl.setRecording(false);
+        run("mock_gl");
+    }
+#endif
+    return context ? 0 : test::SKIPPED;
+}
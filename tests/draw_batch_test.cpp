@@ -0,0 +1,124 @@
+#include "test_support.h"
+
+#include <ogu/draw_batch.h>
+#include <ogu/mock_gl.h>
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace ogu;
+
+
+static features drawFeatures(bool multiDrawIndirect) {
+    features f {};
+    f.directStateAccess = true;
+    f.vertexAttribBinding = true;
+    f.multiDrawIndirect = multiDrawIndirect;
+    f.baseInstance = true;
+    f.shaderStorageBuffer = true;
+    f.shaderDrawParameters = true;
+    return f;
+}
+
+template<typename Exception, typename Fn>
+static bool throws(const Fn& fn) {
+    try {
+        fn();
+    } catch (const Exception&) {
+        return true;
+    }
+    return false;
+}
+
+// Three draws with a float of instance data each, the first and last sharing an index buffer: every
+// draw must find its own record at its baseInstance, whichever order they are submitted in
+static void testInstanceData(bool multiDrawIndirect) {
+    mock_gl gl(drawFeatures(multiDrawIndirect));
+    shader_program program({ shader({ "" }, shader::type::VERTEX), shader({ "" }, shader::type::FRAGMENT) });
+    vertex_array_cache cache;
+    const vertex_layout& layout = cache.intern(vertex_layout({ { { { 0, 3, GL_FLOAT, 0 } }, 12, false } }));
+    buffer vertices(4096), indicesA(1024), indicesB(1024);
+    buffer_range vertexRange { &vertices, 0, 4096 };
+    stream_buffer stream(4096, 2);
+
+    draw_batch batch(sizeof(float), 3);
+    const buffer* indexBuffers[] = { &indicesA, &indicesB, &indicesA };
+    for (uint32_t i = 0; i < 3; ++i) {
+        float record = (float) i;
+        batch.add({ &program, &layout, &vertexRange, indexBuffers[i], GL_TRIANGLES, GL_UNSIGNED_INT,
+            100 + i, 0, 0, 1, 0 }, &record);
+    }
+    gl.reset();
+    batch.submit(stream, cache);
+    OGU_CHECK(batch.lastStats().draws == 3 && batch.lastStats().batches == 2);
+
+    GLintptr instanceOffset = -1;
+    for (const auto& c : gl.calls()) {
+        if (c.entryPoint == gl_entry_point::BindBufferRange && c.args[0] == GL_SHADER_STORAGE_BUFFER) {
+            OGU_CHECK(c.args[1] == 3);
+            instanceOffset = (GLintptr) c.args[3];
+        }
+    }
+    OGU_CHECK(instanceOffset >= 0);
+    const std::vector<uint8_t>& storage = *gl.bufferStorage(stream.getBuffer().handle());
+    auto recordAt = [&] (uint64_t baseInstance) {
+        float record;
+        std::memcpy(&record, storage.data() + instanceOffset + baseInstance * sizeof(float), sizeof(float));
+        return record;
+    };
+
+    if (multiDrawIndirect) {
+        OGU_CHECK(gl.count(gl_entry_point::MultiDrawElementsIndirect) == 2);
+        OGU_CHECK(gl.count(gl_entry_point::DrawElementsInstancedBaseVertexBaseInstance) == 0);
+        for (const auto& c : gl.calls()) {
+            if (c.entryPoint != gl_entry_point::MultiDrawElementsIndirect) continue;
+            auto* pCommands = (const draw_elements_indirect_command*) (storage.data() + c.args[2]);
+            for (uint64_t i = 0; i < c.args[3]; ++i) {
+                OGU_CHECK(recordAt(pCommands[i].baseInstance) == (float) (pCommands[i].count - 100));
+            }
+        }
+    } else {
+        OGU_CHECK(gl.count(gl_entry_point::DrawElementsInstancedBaseVertexBaseInstance) == 3);
+        for (const auto& c : gl.calls()) {
+            if (c.entryPoint != gl_entry_point::DrawElementsInstancedBaseVertexBaseInstance) continue;
+            OGU_CHECK(recordAt(c.args[6]) == (float) (c.args[1] - 100));
+        }
+    }
+}
+
+int main() {
+    testInstanceData(true);
+    testInstanceData(false);
+
+    {
+        features f = drawFeatures(false);
+        f.baseInstance = false;
+        mock_gl gl(f);
+        OGU_CHECK(throws<std::runtime_error>([] () { draw_batch batch; }));
+    }
+    {
+        features f = drawFeatures(true);
+        f.shaderDrawParameters = false;
+        mock_gl gl(f);
+        OGU_CHECK(throws<std::runtime_error>([] () { draw_batch batch(64); }));
+        draw_batch withoutInstanceData;
+    }
+    {
+        // baseInstance would offset the instanced attribute along with the instance data
+        mock_gl gl(drawFeatures(true));
+        shader_program program({ shader({ "" }, shader::type::VERTEX), shader({ "" }, shader::type::FRAGMENT) });
+        vertex_array_cache cache;
+        const vertex_layout& layout = cache.intern(vertex_layout({ { { { 0, 3, GL_FLOAT, 0 } }, 12, false },
+            { { { 1, 4, GL_FLOAT, 0 } }, 16, true } }));
+        buffer vertices(4096), indices(1024);
+        buffer_range vertexRanges[] = { { &vertices, 0, 2048 }, { &vertices, 2048, 2048 } };
+        draw_batch::draw d { &program, &layout, vertexRanges, &indices, GL_TRIANGLES, GL_UNSIGNED_INT, 3, 0, 0, 1, 0 };
+
+        draw_batch batch(sizeof(float));
+        OGU_CHECK(throws<std::invalid_argument>([&] () { batch.add(d); }));
+        draw_batch withoutInstanceData;
+        withoutInstanceData.add(d);
+        OGU_CHECK(withoutInstanceData.size() == 1);
+    }
+    return test::result();
+}
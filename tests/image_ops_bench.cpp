@@ -0,0 +1,83 @@
+#include "test_support.h"
+
+#include <ogu/image_ops.h>
+
+#include <random>
+#include <vector>
+
+using namespace ogu;
+
+
+// image_ops on one thread at each SIMD level: the whole mip chain of a 2048x2048 image, and the pixel
+// conversions over the same number of pixels. CPU only, no GL context needed.
+
+static constexpr uint32_t SIZE = 2048;
+static constexpr size_t PIXELS = (size_t) SIZE * SIZE;
+
+static const char* levelName(image_ops::simd_level level) {
+    switch (level) {
+    case image_ops::simd_level::SCALAR: return "scalar";
+    case image_ops::simd_level::SSE2: return "SSE2";
+    default: return "AVX2";
+    }
+}
+
+int main() {
+    std::mt19937 random(3);
+    std::vector<uint8_t> rgba(PIXELS * 4), rgb(PIXELS * 3), converted(PIXELS * 4);
+    for (auto& b : rgba) b = (uint8_t) random();
+    for (auto& b : rgb) b = (uint8_t) random();
+    std::vector<float> floats(PIXELS * 4);
+    for (auto& f : floats) f = (float) (random() % 1000) / 999.0f;
+    std::vector<uint16_t> halves(floats.size());
+
+    const Texture::Format rgba8 { 4, 8, false, true, false, false };
+    const Texture::Format r8 { 1, 8, false, true, false, false };
+    const Texture::Format rgba32f { 4, 32, true, false, true, false };
+    auto mips = [] (const void* pData, const Texture::Format& format, image_ops::mip_filter filter, bool srgb) {
+        image_ops::mip_options options;
+        options.filter = filter;
+        options.srgb = srgb;
+        options.threads = 1;
+        return test::bestMs(3, [&] () {
+            image_ops::generateMipmaps(pData, SIZE, SIZE, format, options);
+        });
+    };
+    const uint8_t bgra[] = { 2, 1, 0, 3 };
+
+    std::printf("%ux%u, ms                   ", SIZE, SIZE);
+    std::vector<image_ops::simd_level> levels;
+    for (auto level : { image_ops::simd_level::SCALAR, image_ops::simd_level::SSE2, image_ops::simd_level::AVX2 }) {
+        if (level > image_ops::supportedSimd()) continue;
+        levels.push_back(level);
+        std::printf("%9s", levelName(level));
+    }
+    std::printf("\n");
+
+    auto row = [&] (const char* what, auto fn) {
+        std::printf("%-32s", what);
+        for (auto level : levels) {
+            image_ops::setSimdLimit(level);
+            std::printf("%9.2f", fn());
+        }
+        std::printf("\n");
+    };
+    row("mips RGBA8 box", [&] () { return mips(rgba.data(), rgba8, image_ops::mip_filter::BOX, false); });
+    row("mips RGBA8 box sRGB", [&] () { return mips(rgba.data(), rgba8, image_ops::mip_filter::BOX, true); });
+    row("mips RGBA8 Kaiser", [&] () { return mips(rgba.data(), rgba8, image_ops::mip_filter::KAISER, false); });
+    row("mips R8 box", [&] () { return mips(rgba.data(), r8, image_ops::mip_filter::BOX, false); });
+    row("mips RGBA32F box", [&] () { return mips(floats.data(), rgba32f, image_ops::mip_filter::BOX, false); });
+    row("floatToHalf", [&] () {
+        return test::bestMs(3, [&] () { image_ops::floatToHalf(floats.data(), halves.data(), floats.size()); });
+    });
+    row("halfToFloat", [&] () {
+        return test::bestMs(3, [&] () { image_ops::halfToFloat(halves.data(), floats.data(), halves.size()); });
+    });
+    row("expandRGB8ToRGBA8", [&] () {
+        return test::bestMs(3, [&] () { image_ops::expandRGB8ToRGBA8(rgb.data(), converted.data(), PIXELS); });
+    });
+    row("swizzle8 BGRA -> RGBA", [&] () {
+        return test::bestMs(3, [&] () { image_ops::swizzle8(rgba.data(), 4, converted.data(), 4, bgra, PIXELS); });
+    });
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "test_support.h"
+
+#include <ogu/image_ops.h>
+
+#include <random>
+#include <vector>
+
+using namespace ogu;
+
+
+// Every SIMD path must give the scalar path's results bit for bit
+static const image_ops::simd_level LEVELS[] = { image_ops::simd_level::SCALAR, image_ops::simd_level::SSE2,
+    image_ops::simd_level::AVX2 };
+
+static std::vector<uint8_t> randomBytes(size_t size, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<uint8_t> bytes(size);
+    for (auto& b : bytes) {
+        b = (uint8_t) random();
+    }
+    return bytes;
+}
+
+static void testMipmaps() {
+    for (uint32_t components = 1; components <= 4; ++components) {
+        for (bool srgb : { false, true }) {
+            for (image_ops::mip_filter filter : { image_ops::mip_filter::BOX, image_ops::mip_filter::KAISER }) {
+                const uint32_t width = 67, height = 29;
+                const Texture::Format format { components, 8, false, true, false, false };
+                std::vector<uint8_t> level0 = randomBytes((size_t) width * height * components, components);
+                image_ops::mip_options options;
+                options.filter = filter;
+                options.srgb = srgb;
+                options.threads = 1;
+
+                std::vector<image_ops::mip_level> reference;
+                for (auto level : LEVELS) {
+                    image_ops::setSimdLimit(level);
+                    auto levels = image_ops::generateMipmaps(level0.data(), width, height, format, options);
+                    if (level == image_ops::simd_level::SCALAR) {
+                        reference = levels;
+                        continue;
+                    }
+                    bool same = levels.size() == reference.size();
+                    for (size_t i = 0; same && i < levels.size(); ++i) {
+                        same = levels[i].data == reference[i].data;
+                    }
+                    if (!OGU_CHECK(same)) {
+                        std::fprintf(stderr, "  %u components, srgb %d, filter %d, simd level %d\n", components,
+                            (int) srgb, (int) filter, (int) level);
+                    }
+                }
+
+                // and a float format, where the filter passes are all there is
+                const Texture::Format rgbaFloat { components, 32, true, false, true, false };
+                std::vector<float> floats(level0.begin(), level0.end());
+                std::vector<uint8_t> floatReference;
+                for (auto level : LEVELS) {
+                    image_ops::setSimdLimit(level);
+                    auto levels = image_ops::generateMipmaps(floats.data(), width, height, rgbaFloat, options);
+                    if (level == image_ops::simd_level::SCALAR) {
+                        floatReference = levels[0].data;
+                    } else {
+                        OGU_CHECK(levels[0].data == floatReference);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void testSwizzles() {
+    const uint8_t swizzles[][4] = {
+        { 2, 1, 0, 3 }, { 0, 1, 2, image_ops::SWIZZLE_ONE }, { 0, 0, 0, image_ops::SWIZZLE_ONE },
+        { 1, image_ops::SWIZZLE_ZERO, 0, image_ops::SWIZZLE_ONE }, { 3, 2, 1, 0 }
+    };
+    for (uint32_t srcComponents = 1; srcComponents <= 4; ++srcComponents) {
+        for (uint32_t dstComponents = 1; dstComponents <= 4; ++dstComponents) {
+            for (const uint8_t* pSwizzle : swizzles) {
+                bool valid = true;
+                for (uint32_t c = 0; c < dstComponents; ++c) {
+                    valid = valid && (pSwizzle[c] >= image_ops::SWIZZLE_ZERO || pSwizzle[c] < srcComponents);
+                }
+                if (!valid) continue;
+                for (size_t pixels : { 1, 5, 37, 1000 }) {
+                    std::vector<uint8_t> src = randomBytes(pixels * srcComponents, (uint32_t) pixels);
+                    std::vector<uint8_t> reference;
+                    for (auto level : LEVELS) {
+                        image_ops::setSimdLimit(level);
+                        // a guard byte past the end catches overlong stores
+                        std::vector<uint8_t> dst(pixels * dstComponents + 1, 0xcd);
+                        image_ops::swizzle8(src.data(), srcComponents, dst.data(), dstComponents, pSwizzle, pixels);
+                        OGU_CHECK(dst.back() == 0xcd);
+                        if (level == image_ops::simd_level::SCALAR) {
+                            reference = dst;
+                        } else {
+                            OGU_CHECK(dst == reference);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    std::printf("supported SIMD level %d\n", (int) image_ops::supportedSimd());
+    testMipmaps();
+    testSwizzles();
+    image_ops::setSimdLimit(image_ops::simd_level::AVX2);
+    return test::result();
+}
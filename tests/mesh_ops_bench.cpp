@@ -0,0 +1,136 @@
+#include "test_support.h"
+
+#include <ogu/mesh_ops.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <random>
+#include <thread>
+
+using namespace ogu;
+
+
+// mesh_ops throughput over large synthetic meshes: wavy grids stored as triangle soup (three vertices of
+// their own per triangle, so welding has work to do) with the triangles shuffled, so the cache passes
+// start from the worst order. Each pass runs on a fresh copy of its input, the copy isn't timed.
+// CPU only, no GL context needed.
+
+static constexpr uint32_t GRID = 384;  // quads per side, 295k triangles per mesh
+static constexpr size_t MESHES = 8;
+
+struct vertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+static mesh_ops::mesh makeMesh(uint32_t seed) {
+    std::mt19937 random(seed);
+    auto corner = [&] (uint32_t x, uint32_t y) {
+        float u = (float) x / GRID, v = (float) y / GRID;
+        return vertex { { u, 0.05f * std::sin(u * 20.0f + (float) seed) * std::cos(v * 17.0f), v },
+            { 0.0f, 1.0f, 0.0f }, { u, v } };
+    };
+    std::vector<std::array<vertex, 3>> triangles;
+    triangles.reserve((size_t) GRID * GRID * 2);
+    for (uint32_t y = 0; y < GRID; ++y) {
+        for (uint32_t x = 0; x < GRID; ++x) {
+            triangles.push_back({ corner(x, y), corner(x + 1, y), corner(x + 1, y + 1) });
+            triangles.push_back({ corner(x, y), corner(x + 1, y + 1), corner(x, y + 1) });
+        }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), random);
+
+    mesh_ops::mesh m;
+    m.stride = sizeof(vertex);
+    m.positionOffset = offsetof(vertex, position);
+    m.vertices.resize(triangles.size() * sizeof(triangles[0]));
+    std::memcpy(m.vertices.data(), triangles.data(), m.vertices.size());
+    m.indices.resize(triangles.size() * 3);
+    for (uint32_t i = 0; i < m.indices.size(); ++i) {
+        m.indices[i] = i;
+    }
+    return m;
+}
+
+// Best of repeats runs of pass on a copy of input, in milliseconds
+template<typename Fn>
+static double timePass(int repeats, const mesh_ops::mesh& input, const Fn& pass) {
+    double best = 0.0;
+    for (int i = 0; i < repeats; ++i) {
+        mesh_ops::mesh m = input;
+        double ms = test::bestMs(1, [&] () { pass(m); });
+        best = (i == 0 || ms < best) ? ms : best;
+    }
+    return best;
+}
+
+int main() {
+    const mesh_ops::mesh soup = makeMesh(1);
+    const size_t triangles = soup.indices.size() / 3;
+    auto report = [&] (const char* what, double ms) {
+        std::printf("  %-28s %8.2f ms %8.1f Mtriangles/s\n", what, ms, triangles / ms / 1e3);
+    };
+
+    // inputs of the later passes are the outputs of the earlier ones
+    mesh_ops::mesh welded = soup;
+    mesh_ops::weldVertices(welded);
+    mesh_ops::mesh cached = welded;
+    mesh_ops::optimizeVertexCache(cached.indices.data(), cached.indices.size(), cached.vertexCount());
+    mesh_ops::mesh overdrawn = cached;
+    mesh_ops::optimizeOverdraw(overdrawn);
+
+    std::printf("one mesh, %zu triangles, %zu vertices before welding and %zu after\n", triangles,
+        soup.vertexCount(), welded.vertexCount());
+    report("weldVertices", timePass(3, soup, [] (mesh_ops::mesh& m) {
+        mesh_ops::weldVertices(m);
+    }));
+    report("weldVertices, epsilon", timePass(3, soup, [] (mesh_ops::mesh& m) {
+        mesh_ops::weldVertices(m, 1e-5f);
+    }));
+    for (auto algorithm : { mesh_ops::cache_algorithm::FORSYTH, mesh_ops::cache_algorithm::TIPSIFY }) {
+        double ms = timePass(3, welded, [&] (mesh_ops::mesh& m) {
+            mesh_ops::optimizeVertexCache(m.indices.data(), m.indices.size(), m.vertexCount(), algorithm);
+        });
+        mesh_ops::mesh m = welded;
+        mesh_ops::optimizeVertexCache(m.indices.data(), m.indices.size(), m.vertexCount(), algorithm);
+        bool forsyth = algorithm == mesh_ops::cache_algorithm::FORSYTH;
+        report(forsyth ? "optimizeVertexCache, Forsyth" : "optimizeVertexCache, Tipsify", ms);
+        auto before = mesh_ops::analyzeVertexCache(welded.indices.data(), welded.indices.size(), welded.vertexCount());
+        auto after = mesh_ops::analyzeVertexCache(m.indices.data(), m.indices.size(), m.vertexCount());
+        std::printf("    ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", before.acmr, after.acmr, before.atvr, after.atvr);
+    }
+    report("optimizeOverdraw", timePass(3, cached, [] (mesh_ops::mesh& m) {
+        mesh_ops::optimizeOverdraw(m);
+    }));
+    report("optimizeVertexFetch", timePass(3, overdrawn, [] (mesh_ops::mesh& m) {
+        mesh_ops::optimizeVertexFetch(m);
+    }));
+    report("optimizeMesh, all passes", timePass(3, soup, [] (mesh_ops::mesh& m) {
+        mesh_ops::optimizeMesh(m);
+    }));
+
+    // the whole pipeline over several meshes, against the number of workers
+    std::vector<mesh_ops::mesh> meshes;
+    for (uint32_t i = 0; i < MESHES; ++i) {
+        meshes.push_back(makeMesh(i + 1));
+    }
+    const uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::printf("%zu meshes, %zu triangles, %u hardware threads\n", MESHES, MESHES * triangles, hardwareThreads);
+    for (uint32_t threads : { 1u, 2u, 4u, hardwareThreads }) {
+        if (threads > hardwareThreads) continue;
+        double best = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            std::vector<mesh_ops::mesh> copies = meshes;
+            double ms = test::bestMs(1, [&] () { mesh_ops::optimizeMeshes(copies, {}, threads); });
+            best = (i == 0 || ms < best) ? ms : best;
+        }
+        std::printf("  optimizeMeshes, %2u threads    %8.2f ms %8.1f Mtriangles/s\n", threads, best,
+            MESHES * triangles / best / 1e3);
+        if (threads == hardwareThreads) break;
+    }
+    return 0;
+}
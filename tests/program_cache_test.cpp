@@ -0,0 +1,93 @@
+#include "test_support.h"
+
+#include <ogu/program_cache.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace ogu;
+
+
+static const std::vector<shader_source> STAGES = {
+    { { "#version 450 core\n"
+        "layout(location = 0) in vec3 position;\n"
+        "uniform mat4 transform;\n"
+        "void main() { gl_Position = transform * vec4(position, 1.0); }\n" }, shader::type::VERTEX },
+    { { "#version 450 core\n"
+        "uniform vec4 color;\n"
+        "out vec4 fragColor;\n"
+        "void main() { fragColor = color; }\n" }, shader::type::FRAGMENT }
+};
+
+// The program the cache returned is linked and has the interface of its source
+static void checkProgram(shader_program program) {
+    OGU_CHECK(program.getReflection().findUniform("transform") != nullptr);
+    OGU_CHECK(program.getReflection().findUniform("color") != nullptr);
+    OGU_CHECK(program.getReflection().findInput("position") != nullptr);
+    program.addUniform("color");
+    OGU_CHECK(program.getUniformLocation("color") >= 0);
+}
+
+int main() {
+    auto context = test::gl_context::create();
+    if (!context) return test::SKIPPED;
+
+    GLint numFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    if (numFormats == 0) {
+        std::fprintf(stderr, "The driver has no program binary formats, skipping.\n");
+        return test::SKIPPED;
+    }
+
+    namespace fs = std::filesystem;
+    fs::path directory = fs::temp_directory_path() / ("ogu_program_cache_test_"
+        + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    {
+        program_cache cache(directory.string());
+        checkProgram(cache.load(STAGES));
+        OGU_CHECK(cache.getStats().misses == 1 && cache.getStats().hits == 0);
+    }
+    {
+        // a new cache, as in the next run of the application
+        program_cache cache(directory.string());
+        checkProgram(cache.load(STAGES));
+        OGU_CHECK(cache.getStats().hits == 1 && cache.getStats().misses == 0);
+
+        // a different source is a different entry
+        auto changed = STAGES;
+        changed[1].sources[0] += "// changed\n";
+        OGU_CHECK(cache.key(changed) != cache.key(STAGES));
+        checkProgram(cache.load(changed));
+        OGU_CHECK(cache.getStats().misses == 1);
+    }
+    {
+        // corrupt the binary behind the entry's 32-byte header: the driver rejects it, the program is
+        // compiled from source and the entry replaced
+        program_cache cache(directory.string());
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) cache.key(STAGES));
+        fs::path path = directory / name;
+        OGU_CHECK(fs::exists(path));
+        auto size = fs::file_size(path);
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(32);
+            for (auto i = 32u; i < size; ++i) {
+                file.put((char) 0xa5);
+            }
+        }
+        checkProgram(cache.load(STAGES));
+        OGU_CHECK(cache.getStats().rejected == 1 && cache.getStats().misses == 1);
+        checkProgram(cache.load(STAGES));
+        OGU_CHECK(cache.getStats().hits == 1);
+    }
+
+    fs::remove_all(directory);
+    return test::result();
+}
@@ -0,0 +1,52 @@
+#include "test_support.h"
+
+#include <ogu/rect_packer.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace ogu;
+
+
+// skyline_packer throughput and occupancy, packing random glyph- and sprite-sized rectangles into
+// 2048x2048 until one doesn't fit. CPU only, no GL context needed.
+
+static constexpr uint32_t SIZE = 2048;
+
+static void run(const char* what, uint32_t minSize, uint32_t maxSize, bool tallestFirst) {
+    std::mt19937 random(7);
+    std::uniform_int_distribution<uint32_t> side(minSize, maxSize);
+    std::vector<skyline_packer::rect> sizes(200000);
+    for (auto& r : sizes) {
+        r.width = side(random);
+        r.height = side(random);
+    }
+    if (tallestFirst) {
+        std::sort(sizes.begin(), sizes.end(), [] (const skyline_packer::rect& a, const skyline_packer::rect& b) {
+            return a.height > b.height;
+        });
+    }
+
+    skyline_packer packer(SIZE, SIZE);
+    size_t packed = 0;
+    double ms = test::bestMs(5, [&] () {
+        packer.reset();
+        packed = 0;
+        skyline_packer::rect out;
+        for (const auto& r : sizes) {
+            if (!packer.insert(r.width, r.height, out)) break;
+            ++packed;
+        }
+    });
+    std::printf("%-30s %7zu rects, %6.1f ns/insert, %5.1f%% occupied\n", what, packed, ms * 1e6 / packed,
+        packer.occupancy() * 100.0f);
+}
+
+int main() {
+    run("glyphs 6-24, in order", 6, 24, false);
+    run("glyphs 6-24, tallest first", 6, 24, true);
+    run("sprites 16-128, in order", 16, 128, false);
+    run("sprites 16-128, tallest first", 16, 128, true);
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "test_support.h"
+
+#include <ogu/mock_gl.h>
+#include <ogu/render_queue.h>
+
+using namespace ogu;
+
+
+// Program A is bound, then a uniform of program B is set: glUniform* needs B in use, glProgramUniform*
+// doesn't
+static void testSetUniform(bool directStateAccess) {
+    features f {};
+    f.directStateAccess = directStateAccess;
+    mock_gl gl(f);
+    state_cache::current().invalidate();
+    shader_program a({ shader({ "" }, shader::type::VERTEX), shader({ "" }, shader::type::FRAGMENT) });
+    const GLuint b = 1000;
+
+    render_queue queue;
+    command_buffer commands = queue.acquire();
+    commands.bindProgram(0, a);
+    commands.setUniform(0, uniform<float>(b, 7), 2.0f);
+    commands.drawArrays(0, GL_TRIANGLES, 0, 3);
+    queue.submit(std::move(commands));
+    gl.reset();
+    queue.execute();
+
+    GLuint inUse = 0;
+    bool set = false;
+    for (const auto& c : gl.calls()) {
+        if (c.entryPoint == gl_entry_point::UseProgram) inUse = (GLuint) c.args[0];
+        if (c.entryPoint == gl_entry_point::Uniform1f) {
+            OGU_CHECK(!directStateAccess && inUse == b && c.args[0] == 7);
+            set = true;
+        }
+        if (c.entryPoint == gl_entry_point::ProgramUniform1f) {
+            OGU_CHECK(directStateAccess && c.args[0] == b && c.args[1] == 7);
+            set = true;
+        }
+    }
+    OGU_CHECK(set);
+    OGU_CHECK(gl.count(gl_entry_point::UseProgram) == (directStateAccess ? 1 : 2));
+    state_cache::current().invalidate();
+}
+
+int main() {
+    testSetUniform(false);
+    testSetUniform(true);
+    return test::result();
+}
@@ -0,0 +1,71 @@
+#include "test_support.h"
+
+#include <ogu/mock_gl.h>
+#include <ogu/shader_reloader.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+using namespace ogu;
+
+
+static void writeFile(const std::string& path, const std::string& contents) {
+    std::ofstream(path, std::ios::binary) << contents;
+}
+
+// A change whose link is still in flight, then saves that don't change anything: the link carries on
+// instead of being started again on every update (polling reports every file on every interval)
+int main() {
+    features f {};
+    f.parallelShaderCompile = true;
+    mock_gl gl(f);
+
+    namespace fs = std::filesystem;
+    fs::path directory = fs::temp_directory_path() / ("ogu_shader_reloader_test_"
+        + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::create_directories(directory);
+    const std::string vertexPath = (directory / "a.vert").string();
+    const std::string fragmentPath = (directory / "a.frag").string();
+    writeFile(vertexPath, "#version 450 core\nvoid main() {}\n");
+    writeFile(fragmentPath, "#version 450 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n");
+
+    shader_preprocessor preprocessor;
+    shader_reloader reloader(preprocessor);
+    if (!reloader.watching()) {
+        fs::remove_all(directory);
+        return test::SKIPPED;
+    }
+    reloader.load({ { vertexPath, shader::type::VERTEX }, { fragmentPath, shader::type::FRAGMENT } });
+
+    gl.setCompletionStatus(false);
+    gl.reset();
+    writeFile(vertexPath, "#version 450 core\nvoid main() { gl_Position = vec4(0.0); }\n");
+    OGU_CHECK(reloader.update() == 0);
+    OGU_CHECK(gl.count(gl_entry_point::LinkProgram) == 1);
+    OGU_CHECK(reloader.getStats().stagesCompiled == 3);
+
+    // saved again as is, twice
+    for (int i = 0; i < 2; ++i) {
+        writeFile(vertexPath, "#version 450 core\nvoid main() { gl_Position = vec4(0.0); }\n");
+        OGU_CHECK(reloader.update() == 0);
+    }
+    OGU_CHECK(gl.count(gl_entry_point::LinkProgram) == 1);
+    OGU_CHECK(gl.count(gl_entry_point::DeleteProgram) == 0);
+    OGU_CHECK(reloader.getStats().stagesCompiled == 3);
+
+    // a real change to the other stage supersedes the link, reusing the vertex shader it compiled
+    writeFile(fragmentPath, "#version 450 core\nout vec4 color;\nvoid main() { color = vec4(0.5); }\n");
+    OGU_CHECK(reloader.update() == 0);
+    OGU_CHECK(gl.count(gl_entry_point::LinkProgram) == 2);
+    OGU_CHECK(reloader.getStats().stagesCompiled == 4);
+
+    gl.setCompletionStatus(true);
+    OGU_CHECK(reloader.update() == 1);
+    OGU_CHECK(reloader.getStats().reloads == 1);
+    OGU_CHECK(reloader.getStats().stagesReused == 0);
+    OGU_CHECK(reloader.getStats().failures == 0);
+
+    fs::remove_all(directory);
+    return test::result();
+}
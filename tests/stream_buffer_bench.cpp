@@ -0,0 +1,67 @@
+#include "test_support.h"
+
+#include <ogu/stream_buffer.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace ogu;
+
+
+// Per-frame uploads through stream_buffer against mapping a buffer for every write (buffer::write).
+// Each write is consumed by a copy into another buffer, standing in for the draw that reads it.
+
+static constexpr int FRAMES = 200;
+static constexpr size_t WRITES_PER_FRAME = 256;
+static constexpr size_t WRITE_SIZE = 1024;
+
+int main() {
+    auto context = test::gl_context::create();
+    if (!context) return test::SKIPPED;
+    std::printf("%s\n", (const char*) glGetString(GL_RENDERER));
+
+    std::vector<uint8_t> source(WRITE_SIZE, 0x5a);
+    buffer destination(WRITE_SIZE * WRITES_PER_FRAME);
+    auto fill = [&source] (void* pData) {
+        std::memcpy(pData, source.data(), source.size());
+    };
+    auto finish = [] () {
+        // so queued work is timed with the frame that issued it
+        glFinish();
+    };
+
+    auto runStream = [&] (bool coherent) {
+        stream_buffer stream(WRITE_SIZE * WRITES_PER_FRAME, 3, coherent);
+        return test::bestMs(3, [&] () {
+            for (int frame = 0; frame < FRAMES; ++frame) {
+                for (size_t i = 0; i < WRITES_PER_FRAME; ++i) {
+                    intptr_t offset = stream.write(WRITE_SIZE, 4, fill);
+                    glCopyNamedBufferSubData(stream.getBuffer().handle(), destination.handle(), offset,
+                        i * WRITE_SIZE, WRITE_SIZE);
+                }
+                stream.end_frame();
+            }
+            finish();
+        }) / FRAMES;
+    };
+
+    buffer mapped(WRITE_SIZE * WRITES_PER_FRAME);
+    double mapPerWrite = test::bestMs(3, [&] () {
+        for (int frame = 0; frame < FRAMES; ++frame) {
+            for (size_t i = 0; i < WRITES_PER_FRAME; ++i) {
+                mapped.write(i * WRITE_SIZE, WRITE_SIZE, fill);
+                glCopyNamedBufferSubData(mapped.handle(), destination.handle(), i * WRITE_SIZE, i * WRITE_SIZE,
+                    WRITE_SIZE);
+            }
+        }
+        finish();
+    }) / FRAMES;
+    double coherent = runStream(true);
+    double explicitFlush = runStream(false);
+
+    std::printf("%zu writes of %zu bytes per frame\n", WRITES_PER_FRAME, WRITE_SIZE);
+    std::printf("map per write:            %8.3f ms/frame\n", mapPerWrite);
+    std::printf("stream_buffer coherent:   %8.3f ms/frame (%.1fx)\n", coherent, mapPerWrite / coherent);
+    std::printf("stream_buffer flushed:    %8.3f ms/frame (%.1fx)\n", explicitFlush, mapPerWrite / explicitFlush);
+    return 0;
+}
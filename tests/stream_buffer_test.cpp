@@ -0,0 +1,64 @@
+#include "test_support.h"
+
+#include <ogu/stream_buffer.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace ogu;
+
+
+// Copies what a command issued right now sees in the stream buffer
+static std::vector<uint8_t> readBack(const stream_buffer& stream, intptr_t offset, size_t size) {
+    buffer copy(size);
+    glCopyNamedBufferSubData(stream.getBuffer().handle(), copy.handle(), offset, 0, size);
+    std::vector<uint8_t> data(size);
+    glGetNamedBufferSubData(copy.handle(), 0, size, data.data());
+    return data;
+}
+
+static void testWritesVisible(bool coherent) {
+    stream_buffer stream(4096, 3, coherent);
+    for (int frame = 0; frame < 5; ++frame) {
+        std::vector<uint8_t> expected(256, (uint8_t) (frame * 2 + 1));
+        intptr_t offset = stream.write(expected.size(), 16, [&] (void* pData) {
+            std::memcpy(pData, expected.data(), expected.size());
+        });
+        OGU_CHECK(offset % 16 == 0);
+        OGU_CHECK(readBack(stream, offset, expected.size()) == expected);
+
+        // allocate() leaves flushing to the caller
+        stream_buffer::region r = stream.allocate(128);
+        std::memset(r.pData, frame * 2 + 2, r.size);
+        stream.flush(r);
+        OGU_CHECK(readBack(stream, r.offset, r.size) == std::vector<uint8_t>(128, (uint8_t) (frame * 2 + 2)));
+        stream.end_frame();
+    }
+}
+
+int main() {
+    auto context = test::gl_context::create();
+    if (!context) return test::SKIPPED;
+
+    testWritesVisible(true);
+    testWritesVisible(false);
+
+    bool threw = false;
+    try {
+        stream_buffer empty(4096, 0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    OGU_CHECK(threw);
+
+    stream_buffer small(64, 2);
+    threw = false;
+    try {
+        small.allocate(65);
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    OGU_CHECK(threw);
+    return test::result();
+}
@@ -0,0 +1,122 @@
+#include "test_support.h"
+
+#include <ogu/init.h>
+
+#include <cstring>
+#include <exception>
+#include <fstream>
+
+#ifdef OGU_TEST_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+
+namespace ogu {
+namespace test {
+
+static int failures = 0;
+
+bool check(bool passed, const char* expression, const char* file, int line) {
+    if (!passed) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        ++failures;
+    }
+    return passed;
+}
+
+int result() {
+    if (failures) std::fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
+
+gl_context::gl_context(void* display, void* context) :
+        _display(display), _context(context) {
+}
+
+#ifdef OGU_TEST_EGL
+
+std::unique_ptr<gl_context> gl_context::create(int majorVersion, int minorVersion) {
+    // Mesa's surfaceless platform needs neither a window system nor a GPU
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (clientExtensions && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless") && getPlatformDisplay) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        std::fprintf(stderr, "No EGL display, skipping.\n");
+        return nullptr;
+    }
+
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::fprintf(stderr, "Can't make a GL %d.%d context (EGL error 0x%x), skipping.\n", majorVersion, minorVersion,
+            eglGetError());
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        eglTerminate(display);
+        return nullptr;
+    }
+
+    std::unique_ptr<gl_context> c(new gl_context(display, context));
+    try {
+        ogu::init();
+    } catch (const std::exception& e) {
+        // e.g. a GLEW built only for GLX
+        std::fprintf(stderr, "ogu::init() failed on an EGL context (%s), skipping.\n", e.what());
+        return nullptr;
+    }
+    return c;
+}
+
+gl_context::~gl_context() {
+    eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(_display, _context);
+    eglTerminate(_display);
+}
+
+#else
+
+std::unique_ptr<gl_context> gl_context::create(int, int) {
+    std::fprintf(stderr, "Built without EGL, skipping.\n");
+    return nullptr;
+}
+
+gl_context::~gl_context() {
+}
+
+#endif
+
+void writeKTX2(const std::string& path, uint32_t vkFormat, uint32_t width, uint32_t height, uint32_t levelCount,
+        const std::vector<std::vector<uint8_t>>& levels) {
+    static const uint8_t IDENTIFIER[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+    std::vector<uint8_t> file(80 + levels.size() * 24);
+    auto put32 = [&file] (size_t offset, uint32_t v) { std::memcpy(file.data() + offset, &v, 4); };
+    auto put64 = [&file] (size_t offset, uint64_t v) { std::memcpy(file.data() + offset, &v, 8); };
+    std::memcpy(file.data(), IDENTIFIER, sizeof(IDENTIFIER));
+    put32(12, vkFormat);
+    put32(16, 1);
+    put32(20, width);
+    put32(24, height);
+    put32(36, 1);  // faces
+    put32(40, levelCount);
+    for (size_t i = 0; i < levels.size(); ++i) {
+        put64(80 + i * 24, file.size());
+        put64(80 + i * 24 + 8, levels[i].size());
+        put64(80 + i * 24 + 16, levels[i].size());
+        file.insert(file.end(), levels[i].begin(), levels[i].end());
+    }
+    std::ofstream(path, std::ios::binary).write((const char*) file.data(), (std::streamsize) file.size());
+}
+
+}  // namespace test
+}  // namespace ogu
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace ogu {
+namespace test {
+
+// Exit code ctest reports as skipped, e.g. when no GL context can be made
+constexpr int SKIPPED = 77;
+
+// Reports a failed check and remembers it for result(), without stopping the test
+bool check(bool passed, const char* expression, const char* file, int line);
+
+// 0 if every check passed, 1 otherwise, to return from main()
+int result();
+
+#define OGU_CHECK(expression) ::ogu::test::check((expression), #expression, __FILE__, __LINE__)
+
+// A surfaceless EGL context (Mesa's llvmpipe runs it without a GPU), current on the calling thread
+// with ogu::init() done. create() returns null when no context can be made, so GL tests can skip.
+class gl_context {
+public:
+
+    static std::unique_ptr<gl_context> create(int majorVersion = 4, int minorVersion = 5);
+
+    ~gl_context();
+
+    gl_context(const gl_context&) = delete;
+
+    gl_context& operator=(const gl_context&) = delete;
+
+private:
+
+    void* _display;
+    void* _context;
+
+    gl_context(void* display, void* context);
+
+};
+
+// Best of repeats runs of fn, in milliseconds
+template<typename Fn>
+double bestMs(int repeats, const Fn& fn) {
+    double best = 0.0;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = (i == 0 || ms < best) ? ms : best;
+    }
+    return best;
+}
+
+// Writes a 2D KTX2 file with one image per level, level 0 first. levelCount is written as given, so
+// it can disagree with levels.size() to make broken files.
+void writeKTX2(const std::string& path, uint32_t vkFormat, uint32_t width, uint32_t height, uint32_t levelCount,
+    const std::vector<std::vector<uint8_t>>& levels);
+
+}  // namespace test
+}  // namespace ogu
@@ -0,0 +1,68 @@
+#include "test_support.h"
+
+#include <ogu/init.h>
+#include <ogu/texture_atlas.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace ogu;
+
+
+// Texels of one layer of the atlas, RGBA8
+static std::vector<uint32_t> readLayer(texture_atlas& atlas, uint32_t layer, uint32_t size) {
+    std::vector<uint32_t> texels(size * size);
+    glGetTextureSubImage(atlas.texture().getHandle(), 0, 0, 0, layer, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+        (GLsizei) (texels.size() * sizeof(uint32_t)), texels.data());
+    return texels;
+}
+
+// Every texel of the image's slot is the nearest texel of the image, so nothing else can bleed in
+static void checkPadded(texture_atlas& atlas, texture_atlas::image_id id, const std::vector<uint32_t>& image,
+        uint32_t size, uint32_t padding) {
+    const texture_atlas::region& r = atlas.getRegion(id);
+    std::vector<uint32_t> texels = readLayer(atlas, r.layer, size);
+    for (uint32_t y = r.y - padding; y < r.y + r.height + padding; ++y) {
+        for (uint32_t x = r.x - padding; x < r.x + r.width + padding; ++x) {
+            uint32_t ix = std::min(std::max(x, r.x), r.x + r.width - 1) - r.x;
+            uint32_t iy = std::min(std::max(y, r.y), r.y + r.height - 1) - r.y;
+            if (!OGU_CHECK(texels[y * size + x] == image[iy * r.width + ix])) return;
+        }
+    }
+}
+
+int main() {
+    auto context = test::gl_context::create();
+    if (!context) return test::SKIPPED;
+
+    const uint32_t SIZE = 64, PADDING = 2;
+    const Texture::Format rgba8 { 4, 8, false, true, false, false };
+    texture_atlas atlas(SIZE, SIZE, rgba8, 1, 4, PADDING);
+
+    std::vector<std::vector<uint32_t>> images;
+    std::vector<texture_atlas::image_id> ids;
+    for (uint32_t i = 0; i < 6; ++i) {
+        uint32_t width = 3 + i, height = 5 - i % 3;
+        images.emplace_back(width * height);
+        for (uint32_t t = 0; t < images.back().size(); ++t) {
+            images.back()[t] = 0xff000000u | (i << 16) | t;
+        }
+        texture_atlas::image_id id;
+        OGU_CHECK(atlas.add(width, height, images.back().data(), id));
+        ids.push_back(id);
+    }
+    for (size_t i = 0; i < ids.size(); ++i) {
+        checkPadded(atlas, ids[i], images[i], SIZE, PADDING);
+    }
+
+    if (getFeatures().copyImage) {
+        // repacking moves the padding with the image
+        atlas.remove(ids[0]);
+        atlas.remove(ids[3]);
+        OGU_CHECK(atlas.repack());
+        for (size_t i : { 1, 2, 4, 5 }) {
+            checkPadded(atlas, ids[i], images[i], SIZE, PADDING);
+        }
+    }
+    return test::result();
+}
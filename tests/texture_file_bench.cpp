@@ -0,0 +1,97 @@
+#include "test_support.h"
+
+#include <ogu/image_ops.h>
+#include <ogu/texture_file.h>
+
+#include <png.h>
+
+#include <chrono>
+#include <filesystem>
+#include <random>
+
+using namespace ogu;
+
+
+// Load time of a 2048x2048 RGBA8 texture with its mip chain: texture_file on a KTX2 file that stores
+// the chain, against decoding a PNG with libpng, uploading level 0 and generating the rest with
+// glGenerateMipmap. The files are read from the page cache after the first run, so this is decoding
+// and upload, not disk time. The KTX2 file is uncompressed since there is no BC encoder at hand;
+// block-compressed files would be a quarter to an eighth of its size.
+
+static constexpr uint32_t SIZE = 2048;
+
+int main() {
+    auto context = test::gl_context::create();
+    if (!context) return test::SKIPPED;
+    std::printf("%s\n", (const char*) glGetString(GL_RENDERER));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // smooth gradients with some noise, so the PNG compresses about as well as a real texture
+    std::mt19937 random(5);
+    std::vector<uint8_t> pixels((size_t) SIZE * SIZE * 4);
+    for (uint32_t y = 0; y < SIZE; ++y) {
+        for (uint32_t x = 0; x < SIZE; ++x) {
+            uint8_t* p = &pixels[((size_t) y * SIZE + x) * 4];
+            p[0] = (uint8_t) (x / 8 + random() % 8);
+            p[1] = (uint8_t) (y / 8 + random() % 8);
+            p[2] = (uint8_t) ((x + y) / 16);
+            p[3] = 255;
+        }
+    }
+
+    namespace fs = std::filesystem;
+    fs::path directory = fs::temp_directory_path() / ("ogu_texture_file_bench_"
+        + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::create_directories(directory);
+    const std::string ktx2Path = (directory / "image.ktx2").string();
+    const std::string pngPath = (directory / "image.png").string();
+
+    const Texture::Format rgba8 { 4, 8, false, true, false, false };
+    std::vector<std::vector<uint8_t>> chain { pixels };
+    for (auto& level : image_ops::generateMipmaps(pixels.data(), SIZE, SIZE, rgba8)) {
+        chain.push_back(std::move(level.data));
+    }
+    test::writeKTX2(ktx2Path, 37, SIZE, SIZE, (uint32_t) chain.size(), chain);
+
+    png_image image {};
+    image.version = PNG_IMAGE_VERSION;
+    image.width = SIZE;
+    image.height = SIZE;
+    image.format = PNG_FORMAT_RGBA;
+    if (!png_image_write_to_file(&image, pngPath.c_str(), 0, pixels.data(), 0, nullptr)) {
+        std::fprintf(stderr, "Writing the PNG failed: %s\n", image.message);
+        return 1;
+    }
+
+    double ktx2Ms = test::bestMs(5, [&] () {
+        texture_file file(ktx2Path);
+        auto texture = file.createTexture();
+        glFinish();
+    });
+
+    std::vector<uint8_t> decoded((size_t) SIZE * SIZE * 4);
+    double decodeMs = 0.0;
+    double pngMs = test::bestMs(5, [&] () {
+        auto start = std::chrono::steady_clock::now();
+        png_image read {};
+        read.version = PNG_IMAGE_VERSION;
+        png_image_begin_read_from_file(&read, pngPath.c_str());
+        read.format = PNG_FORMAT_RGBA;
+        png_image_finish_read(&read, nullptr, decoded.data(), 0, nullptr);
+        decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        Texture texture(Texture::DIMENSION_2D, rgba8);
+        texture.allocateStorage(0, SIZE, SIZE, 1);
+        texture.writeSubPixels(0, 0, 0, 0, SIZE, SIZE, 1, decoded.data());
+        texture.generateMipmaps();
+        glFinish();
+    });
+
+    std::printf("%ux%u RGBA8 with %zu levels, ms\n", SIZE, SIZE, chain.size());
+    std::printf("  KTX2 (%5.1f MB), mapped and uploaded:        %8.2f\n", fs::file_size(ktx2Path) / 1e6, ktx2Ms);
+    std::printf("  PNG  (%5.1f MB), decoded + glGenerateMipmap: %8.2f (decode %.2f)\n", fs::file_size(pngPath) / 1e6,
+        pngMs, decodeMs);
+
+    fs::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "test_support.h"
+
+#include <ogu/texture_file.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+using namespace ogu;
+
+
+// Parsing only, no GL context needed
+
+static std::vector<std::vector<uint8_t>> rgba8Chain(uint32_t size, uint32_t levels) {
+    std::vector<std::vector<uint8_t>> chain;
+    for (uint32_t level = 0; level < levels; ++level) {
+        uint32_t s = std::max(size >> level, 1u);
+        chain.emplace_back((size_t) s * s * 4, (uint8_t) level);
+    }
+    return chain;
+}
+
+static bool rejected(const std::string& path) {
+    try {
+        texture_file file(path);
+    } catch (const std::runtime_error& e) {
+        std::printf("rejected: %s\n", e.what());
+        return true;
+    }
+    return false;
+}
+
+// DXT1 4x4 with the given mip count and a single block of data
+static void writeDDS(const std::string& path, uint32_t mipCount) {
+    std::vector<uint8_t> file(128 + 8);
+    auto put32 = [&file] (size_t offset, uint32_t v) { std::memcpy(file.data() + offset, &v, 4); };
+    put32(0, 0x20534444);  // "DDS "
+    put32(4, 124);
+    put32(8, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000);  // caps, height, width, pixel format, mip count
+    put32(12, 4);
+    put32(16, 4);
+    put32(28, mipCount);
+    put32(76, 32);
+    put32(80, 0x4);  // DDPF_FOURCC
+    put32(84, 0x31545844);  // "DXT1"
+    std::ofstream(path, std::ios::binary).write((const char*) file.data(), (std::streamsize) file.size());
+}
+
+int main() {
+    namespace fs = std::filesystem;
+    fs::path directory = fs::temp_directory_path() / ("ogu_texture_file_test_"
+        + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::create_directories(directory);
+    const uint32_t VK_FORMAT_R8G8B8A8_UNORM = 37;
+
+    {
+        // 16x16 has 5 levels down to 1x1
+        std::string path = (directory / "full.ktx2").string();
+        test::writeKTX2(path, VK_FORMAT_R8G8B8A8_UNORM, 16, 16, 5, rgba8Chain(16, 5));
+        texture_file file(path);
+        OGU_CHECK(file.getDescription().levels == 5 && file.images().size() == 5);
+    }
+    {
+        std::string path = (directory / "too_many.ktx2").string();
+        test::writeKTX2(path, VK_FORMAT_R8G8B8A8_UNORM, 16, 16, 6, rgba8Chain(16, 6));
+        OGU_CHECK(rejected(path));
+    }
+    {
+        // far past 32 levels, where width >> level would be undefined
+        std::string path = (directory / "huge_count.ktx2").string();
+        test::writeKTX2(path, VK_FORMAT_R8G8B8A8_UNORM, 16, 16, 40, rgba8Chain(16, 1));
+        OGU_CHECK(rejected(path));
+    }
+    {
+        std::string path = (directory / "one_level.dds").string();
+        writeDDS(path, 1);
+        texture_file file(path);
+        OGU_CHECK(file.getDescription().levels == 1 && file.getDescription().compressed);
+    }
+    {
+        std::string path = (directory / "too_many.dds").string();
+        writeDDS(path, 33);
+        OGU_CHECK(rejected(path));
+    }
+
+    fs::remove_all(directory);
+    return test::result();
+}
@@ -0,0 +1,50 @@
+#include "test_support.h"
+
+#include <ogu/instrumentation.h>
+#include <ogu/texture.h>
+
+#include <memory>
+#include <vector>
+
+using namespace ogu;
+
+
+int main() {
+    auto context = test::gl_context::create();
+    if (!context) return test::SKIPPED;
+
+    const Texture::Format rgba8 { 4, 8, false, true, false, false };
+    GLuint handle = 0;
+    {
+        auto source = std::make_unique<Texture>(Texture::DIMENSION_2D, rgba8);
+        source->allocateStorage(0, 64, 32, 1);
+        handle = source->getHandle();
+
+        // the moved-to texture owns the GL texture, destroying the source must not delete it
+        Texture moved(std::move(*source));
+        OGU_CHECK(source->getHandle() == 0);
+        source.reset();
+        OGU_CHECK(moved.getHandle() == handle && glIsTexture(handle));
+        OGU_CHECK(moved.getWidth() == 64 && moved.getHeight() == 32 && moved.getLevels() == 7);
+        OGU_CHECK(moved.getMemorySize() > 64 * 32 * 4);
+    }
+    OGU_CHECK(!glIsTexture(handle));
+
+    // writePixels specifies level 0 only, glGenerateMipmap adds the rest of the chain
+    const int64_t memoryBefore = instrumentation::current().memoryBytes[(size_t) instrumentation::object_type::TEXTURE];
+    {
+        Texture mutableTexture(Texture::DIMENSION_2D, rgba8);
+        std::vector<uint8_t> pixels(64 * 32 * 4, 0x80);
+        mutableTexture.writePixels(64, 32, 1, pixels.data());
+        OGU_CHECK(mutableTexture.getLevels() == 1);
+        mutableTexture.generateMipmaps();
+        OGU_CHECK(mutableTexture.getLevels() == 7);
+        OGU_CHECK(mutableTexture.getMemorySize() > 64 * 32 * 4);
+
+        // the generated levels are reported as well, so the destructor takes back what was added
+        int64_t memory = instrumentation::current().memoryBytes[(size_t) instrumentation::object_type::TEXTURE];
+        OGU_CHECK(!instrumentation::enabled || memory - memoryBefore == (int64_t) mutableTexture.getMemorySize());
+    }
+    OGU_CHECK(instrumentation::current().memoryBytes[(size_t) instrumentation::object_type::TEXTURE] == memoryBefore);
+    return test::result();
+}
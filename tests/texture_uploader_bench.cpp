@@ -0,0 +1,78 @@
+#include "test_support.h"
+
+#include <ogu/texture_uploader.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace ogu;
+
+
+// Frame times with per-frame texture streaming: glTexSubImage2D from client memory (synchronous, the
+// driver copies the pixels before the call returns) against texture_uploader's mapped ring.
+
+static constexpr int FRAMES = 60;
+static constexpr uint32_t TILES_PER_FRAME = 4;
+static constexpr uint32_t TILE = 256;
+static constexpr size_t TILE_BYTES = (size_t) TILE * TILE * 4;
+
+int main() {
+    auto context = test::gl_context::create();
+    if (!context) return test::SKIPPED;
+    std::printf("%s\n", (const char*) glGetString(GL_RENDERER));
+
+    const Texture::Format rgba8 { 4, 8, false, true, false, false };
+    std::vector<uint8_t> pixels(TILE_BYTES);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = (uint8_t) (i * 7);
+    }
+
+    // renderMs: the render thread's part, which for texture_uploader is only flush(); stageMs: filling
+    // the ring, which can happen on any thread
+    auto run = [&] (bool async, double& renderMs, double& stageMs) {
+        Texture texture(Texture::DIMENSION_2D, rgba8);
+        texture.allocateStorage(1, TILE * TILES_PER_FRAME, TILE, 1);
+        texture_uploader uploader(TILE_BYTES * TILES_PER_FRAME * 3);
+        glFinish();
+
+        renderMs = stageMs = 0.0;
+        double totalMs = test::bestMs(1, [&] () {
+            for (int frame = 0; frame < FRAMES; ++frame) {
+                if (!async) {
+                    renderMs += test::bestMs(1, [&] () {
+                        for (uint32_t tile = 0; tile < TILES_PER_FRAME; ++tile) {
+                            texture.writeSubPixels(0, tile * TILE, 0, 0, TILE, TILE, 1, pixels.data());
+                        }
+                    });
+                    continue;
+                }
+                stageMs += test::bestMs(1, [&] () {
+                    for (uint32_t tile = 0; tile < TILES_PER_FRAME; ++tile) {
+                        texture_uploader::staging s;
+                        while (!uploader.stage(TILE_BYTES, s)) {
+                            uploader.flush();
+                        }
+                        std::memcpy(s.pData, pixels.data(), TILE_BYTES);
+                        uploader.submit(s, texture, 0, tile * TILE, 0, 0, TILE, TILE, 1);
+                    }
+                });
+                renderMs += test::bestMs(1, [&] () {
+                    uploader.flush();
+                });
+            }
+            glFinish();
+        });
+        renderMs /= FRAMES;
+        stageMs /= FRAMES;
+        return totalMs / FRAMES;
+    };
+
+    double syncRender, syncStage, asyncRender, asyncStage;
+    double syncTotal = run(false, syncRender, syncStage);
+    double asyncTotal = run(true, asyncRender, asyncStage);
+    std::printf("%u tiles of %ux%u RGBA8 per frame, ms/frame\n", TILES_PER_FRAME, TILE, TILE);
+    std::printf("                             render thread   staging     total\n");
+    std::printf("glTexSubImage2D from memory: %13.3f %9s %9.3f\n", syncRender, "-", syncTotal);
+    std::printf("texture_uploader:            %13.3f %9.3f %9.3f\n", asyncRender, asyncStage, asyncTotal);
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "test_support.h"
+
+#include <ogu/shader.h>
+
+#ifdef OGU_GL_DISPATCH
+#include <ogu/mock_gl.h>
+#endif
+
+using namespace ogu;
+
+
+// Cost per uniform set: by std::string name (map lookup), by compile-time hashed name (binary search
+// of a flat table) and through a pre-resolved uniform<T> handle, against calling GL directly.
+// uniform<T> uses glProgramUniform* where direct state access is available, setUniform glUniform*.
+// Build optimized, the hashed names are only folded to constants by the optimizer.
+
+static constexpr int SETS = 1000000;
+
+static const char* VERTEX_SOURCE =
+    "#version 450 core\n"
+    "uniform float scale;\n"
+    "uniform vec4 offset;\n"
+    "uniform vec4 tint;\n"
+    "uniform mat4 transform;\n"
+    "out vec4 color;\n"
+    "void main() { gl_Position = transform * vec4(scale) + offset; color = tint; }\n";
+
+static const char* FRAGMENT_SOURCE =
+    "#version 450 core\n"
+    "in vec4 color;\n"
+    "out vec4 fragColor;\n"
+    "void main() { fragColor = color; }\n";
+
+static void run(const char* backend) {
+    shader_program program({ shader({ VERTEX_SOURCE }, shader::type::VERTEX),
+        shader({ FRAGMENT_SOURCE }, shader::type::FRAGMENT) });
+    for (const char* name : { "scale", "offset", "tint", "transform" }) {
+        program.addUniform(name);
+    }
+    uniform<float> scale = program.getUniform<float>("scale");
+    program.use();
+
+    std::printf("%s\n", backend);
+    auto report = [] (const char* what, double ms) {
+        std::printf("  %-28s %7.1f ns/set\n", what, ms * 1e6 / SETS);
+    };
+    float value = 0.0f;
+    report("glUniform1f", test::bestMs(5, [&] () {
+        for (int i = 0; i < SETS; ++i) {
+            glUniform1f(scale.location(), value += 1.0f);
+        }
+    }));
+    report("glProgramUniform1f", test::bestMs(5, [&] () {
+        for (int i = 0; i < SETS; ++i) {
+            glProgramUniform1f(scale.program(), scale.location(), value += 1.0f);
+        }
+    }));
+    report("setUniform(std::string)", test::bestMs(5, [&] () {
+        for (int i = 0; i < SETS; ++i) {
+            program.setUniform("scale", value += 1.0f);
+        }
+    }));
+    report("setUniform(\"scale\"_uniform)", test::bestMs(5, [&] () {
+        for (int i = 0; i < SETS; ++i) {
+            program.setUniform("scale"_uniform, value += 1.0f);
+        }
+    }));
+    report("uniform<float>::set", test::bestMs(5, [&] () {
+        for (int i = 0; i < SETS; ++i) {
+            scale.set(value += 1.0f);
+        }
+    }));
+}
+
+int main() {
+    auto context = test::gl_context::create();
+    if (context) run((const char*) glGetString(GL_RENDERER));
+#ifdef OGU_GL_DISPATCH
+    {
+        // next to no cost in the GL calls themselves, so what's left is the wrappers' own
+        features f = getFeatures();
+        mock_gl gl(f);
+        gl.setRecording(false);
+        run("mock_gl");
+    }
+#endif
+    return context ? 0 : test::SKIPPED;
+}
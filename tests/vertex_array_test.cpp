@@ -0,0 +1,86 @@
+#include "test_support.h"
+
+#include <ogu/mock_gl.h>
+#include <ogu/vertex_array.h>
+
+using namespace ogu;
+
+
+static std::vector<mock_gl::call> callsTo(const mock_gl& gl, gl_entry_point entryPoint) {
+    std::vector<mock_gl::call> calls;
+    for (const auto& c : gl.calls()) {
+        if (c.entryPoint == entryPoint) calls.push_back(c);
+    }
+    return calls;
+}
+
+// Interleaved position / normal / uv
+static std::vector<vertex_attrib_description> interleaved() {
+    return { { 0, 3, GL_FLOAT, 0 }, { 1, 3, GL_FLOAT, 12 }, { 2, 2, GL_FLOAT, 24 } };
+}
+
+struct call_counts {
+    uint64_t total;
+    uint64_t binds;
+};
+
+static call_counts createCalls(bool directStateAccess) {
+    features f {};
+    f.directStateAccess = directStateAccess;
+    mock_gl gl(f);
+    buffer b(1 << 20);
+    gl.reset();
+    vertex_array va({ { b, interleaved(), 32 } });
+    return { gl.totalCalls(), gl.count(gl_entry_point::BindBuffer) + gl.count(gl_entry_point::BindVertexArray) };
+}
+
+int main() {
+    // what each path costs to create an interleaved VAO: DSA makes more calls, but no binds
+    call_counts bindToEdit = createCalls(false);
+    call_counts direct = createCalls(true);
+    std::printf("interleaved VAO: bind-to-edit %llu calls (%llu binds), DSA %llu calls (%llu binds)\n",
+        (unsigned long long) bindToEdit.total, (unsigned long long) bindToEdit.binds,
+        (unsigned long long) direct.total, (unsigned long long) direct.binds);
+    OGU_CHECK(bindToEdit.binds == 2 && direct.binds == 0);
+
+    features f {};
+    f.directStateAccess = true;
+    {
+        mock_gl gl(f);
+        buffer b(1 << 20);
+        gl.reset();
+        vertex_array va({ { b, interleaved(), 32 } });
+        auto points = callsTo(gl, gl_entry_point::VertexArrayVertexBuffer);
+        OGU_CHECK(points.size() == 1 && points[0].args[4] == 32);
+        OGU_CHECK(gl.count(gl_entry_point::BindBuffer) == 0 && gl.count(gl_entry_point::BindVertexArray) == 0);
+    }
+    {
+        // stride 0 means tightly packed, and the second attribute's offset is past any relative offset limit
+        mock_gl gl(f);
+        buffer b(1 << 20);
+        gl.reset();
+        buffer_range range { &b, 256, 8192 };
+        vertex_array va({ { range, { { 0, 3, GL_FLOAT, 0 }, { 1, 4, GL_UNSIGNED_BYTE, 4096, false, true } }, 0 } });
+        auto points = callsTo(gl, gl_entry_point::VertexArrayVertexBuffer);
+        OGU_CHECK(points.size() == 2);
+        if (points.size() == 2) {
+            OGU_CHECK(points[0].args[1] == 0 && points[0].args[3] == 256 && points[0].args[4] == 12);
+            OGU_CHECK(points[1].args[1] == 1 && points[1].args[3] == 256 + 4096 && points[1].args[4] == 4);
+        }
+        for (const auto& c : callsTo(gl, gl_entry_point::VertexArrayAttribFormat)) {
+            OGU_CHECK(c.args[5] == 0);
+        }
+        auto attribBindings = callsTo(gl, gl_entry_point::VertexArrayAttribBinding);
+        OGU_CHECK(attribBindings.size() == 2 && attribBindings[1].args[1] == 1 && attribBindings[1].args[2] == 1);
+    }
+    {
+        // interleaved but with the vertex data far into the buffer: only the binding offset is large
+        mock_gl gl(f);
+        buffer b(1 << 20);
+        gl.reset();
+        vertex_array va({ { buffer_range { &b, 65536, 32 * 100 }, interleaved(), 32 } });
+        auto points = callsTo(gl, gl_entry_point::VertexArrayVertexBuffer);
+        OGU_CHECK(points.size() == 1 && points[0].args[3] == 65536 && points[0].args[4] == 32);
+    }
+    return test::result();
+}
@@ -0,0 +1,63 @@
+#include "test_support.h"
+
+#include <ogu/vertex_layout.h>
+
+#include <memory>
+#include <vector>
+
+using namespace ogu;
+
+
+// Switching between meshes that share a vertex format: one VAO per mesh against vertex_array_cache's
+// one VAO per layout, with the meshes drawn in order and then with every mesh drawn twice in a row.
+// Draws are left out, what's timed is the state changes in front of them.
+
+static constexpr int FRAMES = 200;
+static constexpr size_t MESHES = 512;
+
+int main() {
+    auto context = test::gl_context::create();
+    if (!context) return test::SKIPPED;
+    std::printf("%s\n", (const char*) glGetString(GL_RENDERER));
+
+    std::vector<vertex_attrib_description> attribs = { { 0, 3, GL_FLOAT, 0 }, { 1, 3, GL_FLOAT, 12 },
+        { 2, 2, GL_FLOAT, 24 } };
+    std::vector<std::unique_ptr<buffer>> buffers;
+    std::vector<vertex_array> perMesh;
+    for (size_t i = 0; i < MESHES; ++i) {
+        buffers.push_back(std::make_unique<buffer>(32 * 1024));
+        perMesh.emplace_back(std::vector<vertex_buffer_binding> { { *buffers.back(), attribs, 32 } });
+    }
+
+    for (int repeat : { 1, 2 }) {
+        double perMeshMs = test::bestMs(3, [&] () {
+            for (int frame = 0; frame < FRAMES; ++frame) {
+                for (const auto& va : perMesh) {
+                    for (int i = 0; i < repeat; ++i) va.bind();
+                }
+            }
+            glFinish();
+        }) / FRAMES;
+
+        vertex_array_cache cache;
+        const vertex_layout& layout = cache.intern(vertex_layout({ { attribs, 32, false } }));
+        double cachedMs = test::bestMs(3, [&] () {
+            for (int frame = 0; frame < FRAMES; ++frame) {
+                for (const auto& b : buffers) {
+                    buffer_range r { b.get(), 0, 32 * 1024 };
+                    for (int i = 0; i < repeat; ++i) cache.bind(layout, &r);
+                }
+                cache.endFrame();
+            }
+            glFinish();
+        }) / FRAMES;
+
+        const auto& s = cache.lastFrameStats();
+        std::printf("%zu meshes, each bound %d time(s), ms/frame\n", MESHES, repeat);
+        std::printf("  VAO per mesh:       %8.3f\n", perMeshMs);
+        std::printf("  vertex_array_cache: %8.3f (%zu layout, %llu VAO switches, %llu buffer binds, %llu elided)\n",
+            cachedMs, s.layouts, (unsigned long long) s.vaoSwitches, (unsigned long long) s.bufferBinds,
+            (unsigned long long) s.elidedBufferBinds);
+    }
+    return 0;
+}
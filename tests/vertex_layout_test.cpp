@@ -0,0 +1,64 @@
+#include "test_support.h"
+
+#include <ogu/vertex_layout.h>
+
+#include <memory>
+
+using namespace ogu;
+
+
+static GLint bindingState(GLenum pname, GLuint index) {
+    GLint value = -1;
+    glGetIntegeri_v(pname, index, &value);
+    return value;
+}
+
+int main() {
+    auto context = test::gl_context::create();
+    if (!context) return test::SKIPPED;
+
+    vertex_array_cache cache;
+    const vertex_layout& interleaved = cache.intern(vertex_layout({
+        { { { 0, 3, GL_FLOAT, 0 }, { 1, 2, GL_FLOAT, 12 } }, 20, false } }));
+
+    {
+        // a buffer deleted and its name given to a new one: the cache must not take it for the old one
+        auto first = std::make_unique<buffer>(4096);
+        buffer_range r { first.get(), 0, 4096 };
+        cache.bind(interleaved, &r);
+        GLuint name = first->handle();
+        first.reset();
+
+        buffer second(4096);
+        if (second.handle() != name) {
+            std::printf("the driver did not reuse buffer name %u (Mesa: set force_gl_names_reuse=true)\n", name);
+        }
+        r = { &second, 0, 4096 };
+        cache.bind(interleaved, &r);
+        OGU_CHECK(bindingState(GL_VERTEX_BINDING_BUFFER, 0) == (GLint) second.handle());
+        OGU_CHECK(bindingState(GL_VERTEX_BINDING_STRIDE, 0) == 20);
+
+        cache.bind(interleaved, &r);
+        OGU_CHECK(cache.frameStats().elidedBufferBinds == 1);
+    }
+    {
+        // stride 0 is tightly packed, and an attribute past the relative offset limit gets its own binding
+        // point with the offset moved into the buffer offset
+        const vertex_layout& planar = cache.intern(vertex_layout({
+            { { { 0, 3, GL_FLOAT, 0 }, { 1, 4, GL_UNSIGNED_BYTE, 65536, false, true } }, 0, false } }));
+        buffer b(1 << 20);
+        buffer_range r { &b, 256, 1 << 19 };
+        cache.bind(planar, &r);
+        OGU_CHECK(bindingState(GL_VERTEX_BINDING_BUFFER, 0) == (GLint) b.handle());
+        OGU_CHECK(bindingState(GL_VERTEX_BINDING_OFFSET, 0) == 256);
+        OGU_CHECK(bindingState(GL_VERTEX_BINDING_STRIDE, 0) == 12);
+        OGU_CHECK(bindingState(GL_VERTEX_BINDING_BUFFER, 1) == (GLint) b.handle());
+        OGU_CHECK(bindingState(GL_VERTEX_BINDING_OFFSET, 1) == 256 + 65536);
+        OGU_CHECK(bindingState(GL_VERTEX_BINDING_STRIDE, 1) == 4);
+
+        GLint relativeOffset = -1;
+        glGetVertexAttribiv(1, GL_VERTEX_ATTRIB_RELATIVE_OFFSET, &relativeOffset);
+        OGU_CHECK(relativeOffset == 0);
+    }
+    return test::result();
+}